@@ -0,0 +1,98 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+
+#include "types.h"
+
+namespace skald {
+
+// Flavour of the C++ ABI. ARM (AAPCS32) follows Itanium for the RTTI and the vtables, but the
+// function pointers of the Thumb code have their lowest bit set
+enum class CxxAbi : uint8_t { ITANIUM, ARM };
+
+// ABI of a binary, as told by its backend
+struct Abi {
+    uint32_t pointerSize = 8;
+    std::endian order = std::endian::little;
+    CxxAbi variant = CxxAbi::ITANIUM;
+
+    bool operator==(const Abi &other) const = default;
+};
+
+// Integer of memory stored in the byte order `Order`, converted to the host one
+template <std::endian Order, typename T>
+constexpr T fromOrder(T value) {
+    if constexpr (Order == std::endian::native || sizeof(T) == 1) {
+        return value;
+    } else {
+        typedef std::make_unsigned_t<T> unsigned_t;
+        auto bits = static_cast<unsigned_t>(value);
+        if constexpr (sizeof(T) == 2) bits = __builtin_bswap16(bits);
+        if constexpr (sizeof(T) == 4) bits = __builtin_bswap32(bits);
+        if constexpr (sizeof(T) == 8) bits = __builtin_bswap64(bits);
+        return static_cast<T>(bits);
+    }
+}
+
+// Compile-time ABI the recovery engine is instantiated for. Every read of the binary goes through
+// these, so that each instantiation gets its own loops without any test on the width or the byte
+// order
+template <typename Pointer, std::endian Order, CxxAbi Variant>
+struct AbiTraits {
+    typedef Pointer pointer_t;
+    typedef std::make_signed_t<Pointer> offset_t;  // `offset_to_top`, vbase and vcall offsets
+
+    static constexpr uint64_t POINTER_SIZE = sizeof(Pointer);
+    static constexpr std::endian ORDER = Order;
+    static constexpr CxxAbi VARIANT = Variant;
+
+    // Whether the words of memory can be used as they are read
+    static constexpr bool NATIVE = sizeof(Pointer) == 8 && Order == std::endian::native;
+
+    static constexpr address_t load(Pointer word) { return fromOrder<Order>(word); }
+    static constexpr int64_t loadOffset(Pointer word) {
+        return static_cast<offset_t>(fromOrder<Order>(word));
+    }
+
+    // Start of the function a vtable slot points to
+    static constexpr address_t functionAddress(address_t slot) {
+        return Variant == CxxAbi::ARM ? slot & ~address_t{1} : slot;
+    }
+
+    static constexpr Abi abi() { return {sizeof(Pointer), Order, Variant}; }
+};
+
+typedef AbiTraits<uint64_t, std::endian::little, CxxAbi::ITANIUM> ItaniumLe64;  // x86-64, AArch64
+typedef AbiTraits<uint64_t, std::endian::big, CxxAbi::ITANIUM> ItaniumBe64;     // PPC64, MIPS64
+typedef AbiTraits<uint32_t, std::endian::little, CxxAbi::ITANIUM> ItaniumLe32;  // x86, MIPSel
+typedef AbiTraits<uint32_t, std::endian::big, CxxAbi::ITANIUM> ItaniumBe32;     // PPC, MIPS
+typedef AbiTraits<uint32_t, std::endian::little, CxxAbi::ARM> ArmLe32;
+typedef AbiTraits<uint32_t, std::endian::big, CxxAbi::ARM> ArmBe32;
+
+// Applies `X` to every supported ABI, to instantiate the templates defined in a source file
+#define SKALD_FOR_EACH_ABI(X) \
+    X(ItaniumLe64)            \
+    X(ItaniumBe64)            \
+    X(ItaniumLe32)            \
+    X(ItaniumBe32)            \
+    X(ArmLe32)                \
+    X(ArmBe32)
+
+// Calls `f.template operator()<Traits>()` with the traits of `abi`. Throws std::invalid_argument
+// if it is not supported
+template <typename F>
+decltype(auto) dispatchAbi(const Abi &abi, F &&f) {
+    const bool little = abi.order == std::endian::little;
+    if (abi.pointerSize == 8 && abi.variant == CxxAbi::ITANIUM)
+        return little ? f.template operator()<ItaniumLe64>() : f.template operator()<ItaniumBe64>();
+    if (abi.pointerSize == 4 && abi.variant == CxxAbi::ITANIUM)
+        return little ? f.template operator()<ItaniumLe32>() : f.template operator()<ItaniumBe32>();
+    if (abi.pointerSize == 4 && abi.variant == CxxAbi::ARM)
+        return little ? f.template operator()<ArmLe32>() : f.template operator()<ArmBe32>();
+    throw std::invalid_argument("Unsupported pointer size or C++ ABI");
+}
+
+}  // namespace skald
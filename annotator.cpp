@@ -0,0 +1,418 @@
+#include "annotator.h"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "binaryninjaapi.h"
+#include "instrumentation.h"
+#include "log.h"
+#include "skald.h"
+#include "type_interner.h"
+#include "type_name_decoder.h"
+
+namespace skald {
+
+using BinaryNinja::BaseStructure;
+using BinaryNinja::QualifiedName;
+using BinaryNinja::Ref;
+using BinaryNinja::Structure;
+using BinaryNinja::StructureBuilder;
+using BinaryNinja::Type;
+
+Annotator::Annotator(BinaryNinja::BinaryView *view) : _view(view), types(view) {}
+
+void Annotator::apply(const Skald &skald) {
+    this->applyTypeInfos(skald.getTypeInfos());
+    this->applyVtables(skald.getVtables());
+    this->applyVtts(skald.getVtts());
+    this->createMissingFunctions();
+}
+
+void Annotator::applyTypeInfos(std::span<const TypeInfoRecord> typeInfos) {
+    if (typeInfos.size() > this->batchSize) {
+        for (size_t first = 0; first < typeInfos.size(); first += this->batchSize)
+            this->applyTypeInfos(typeInfos.subspan(first, this->getBatchSize(first, typeInfos)));
+        return;
+    }
+    SKALD_TIMED_SCOPE("type commit");
+    const std::string id = this->beginUndo();
+
+    // The records restored from the cache have already been applied, unless the user removed them
+    std::vector<std::pair<address_t, Ref<Type>>> variables;
+    for (const auto &typeInfo : typeInfos) {
+        if (typeInfo.cached && this->isDefined(typeInfo.address)) continue;
+        if (Ref<Type> type = this->typeInfoType(typeInfo))
+            variables.emplace_back(typeInfo.address, type);
+    }
+
+    // The types must exist before the variables referencing them
+    this->types.flush();
+    for (const auto &[address, type] : variables) {
+        const Ref<Type> reference = this->types.getReference(type);
+        SKALD_COUNT(DEFINE_DATA_VARIABLE, 1);
+        _view->DefineUserDataVariable(address, reference->WithConfidence(0xff));
+    }
+
+    this->commitUndo(id);
+}
+
+void Annotator::applyVtables(std::span<const VtableRecord> vtables) {
+    if (vtables.size() > this->batchSize) {
+        for (size_t first = 0; first < vtables.size(); first += this->batchSize)
+            this->applyVtables(vtables.subspan(first, this->getBatchSize(first, vtables)));
+        return;
+    }
+    SKALD_TIMED_SCOPE("type commit");
+    const std::string id = this->beginUndo();
+
+    std::vector<const VtableRecord *> defined;
+    for (const auto &vtable : vtables) {
+        if (vtable.cached && this->isDefined(vtable.address)) continue;
+        this->nameFunctions(vtable);
+        bool complete = true;
+        this->types.define(this->vtableName(vtable) + "_t",
+                           this->createVtableType(vtable.functions, complete));
+        if (!complete)
+            this->incompleteVtables.emplace_back(this->vtableName(vtable), vtable.functions);
+        defined.push_back(&vtable);
+    }
+
+    this->types.flush();
+    for (const VtableRecord *vtable : defined) {
+        const std::string name = this->vtableName(*vtable);
+        const Ref<Type> type = this->types.getReference(name + "_t");
+
+        // Assign variable
+        SKALD_COUNT(DEFINE_DATA_VARIABLE, 1);
+        _view->DefineUserDataVariable(vtable->address, type->WithConfidence(0xff));
+
+        // Create user symbol
+        auto *symbol = new BinaryNinja::Symbol(BNSymbolType::DataSymbol, name, vtable->address);
+        SKALD_COUNT(DEFINE_SYMBOL, 1);
+        _view->DefineUserSymbol(symbol);
+    }
+
+    this->commitUndo(id);
+}
+
+void Annotator::applyVtts(std::span<const VttRecord> vtts) {
+    if (vtts.empty()) return;
+    if (vtts.size() > this->batchSize) {
+        for (size_t first = 0; first < vtts.size(); first += this->batchSize)
+            this->applyVtts(vtts.subspan(first, this->getBatchSize(first, vtts)));
+        return;
+    }
+    SKALD_TIMED_SCOPE("type commit");
+    const std::string id = this->beginUndo();
+
+    // Arrays of pointers to the address points, the vtables themselves are already typed
+    for (const VttRecord &vtt : vtts) {
+        const Ref<Type> type = Type::ArrayType(this->types.getVoidPointer(), vtt.entries.size());
+        SKALD_COUNT(DEFINE_DATA_VARIABLE, 1);
+        _view->DefineUserDataVariable(vtt.address, type->WithConfidence(0xff));
+
+        auto *symbol =
+            new BinaryNinja::Symbol(BNSymbolType::DataSymbol,
+                                    fmt::format("vtt_{}", this->names.decode(vtt.className)),
+                                    vtt.address);
+        SKALD_COUNT(DEFINE_SYMBOL, 1);
+        _view->DefineUserSymbol(symbol);
+    }
+
+    this->commitUndo(id);
+}
+
+void Annotator::applyLayouts(const CompactGraph &graph, std::span<const ClassLayout> layouts) {
+    if (layouts.empty()) return;
+    SKALD_TIMED_SCOPE("type commit");
+    const std::string id = this->beginUndo();
+
+    // Only the classes getting a structure can be referenced, as bases or members
+    std::vector<bool> defined(graph.size(), false);
+    for (const ClassLayout &layout : layouts) defined[layout.id] = true;
+    const auto reference = [&](class_id_t id) {
+        return this->types.getReference(std::string(this->names.decode(graph.getName(id))));
+    };
+
+    for (const ClassLayout &layout : layouts) {
+        const std::string name(this->names.decode(graph.getName(layout.id)));
+        this->types.getNamed(name, [&] {
+            StructureBuilder classBuilder;
+            std::vector<BaseStructure> bases;
+            for (const LayoutBase &base : layout.bases)
+                if (defined[base.id]) bases.emplace_back(reference(base.id), base.offset);
+            classBuilder.SetBaseStructures(bases);
+
+            if (layout.hasVptr) {
+                const Ref<Type> vtable = this->types.getReference(fmt::format("vtable_{}_t", name));
+                classBuilder.AddMemberAtOffset(
+                    Type::PointerType(_view->GetDefaultArchitecture(), vtable), "vtable", 0);
+            }
+            for (const LayoutField &field : layout.fields) {
+                const Ref<Type> type = field.type != NO_CLASS && defined[field.type]
+                                           ? reference(field.type)
+                                           : Type::IntegerType(field.size, false);
+                classBuilder.AddMemberAtOffset(type, fmt::format("field_{:x}", field.offset),
+                                               field.offset);
+            }
+            const uint64_t alignment = _view->GetAddressSize();
+            classBuilder.SetWidth((layout.size + alignment - 1) / alignment * alignment);
+            return Type::StructureType(classBuilder.Finalize());
+        });
+    }
+
+    this->types.flush();
+    this->commitUndo(id);
+}
+
+void Annotator::applyCalls(std::span<const ResolvedCall> calls) {
+    if (calls.empty()) return;
+    if (calls.size() > this->batchSize) {
+        for (size_t first = 0; first < calls.size(); first += this->batchSize)
+            this->applyCalls(calls.subspan(first, this->getBatchSize(first, calls)));
+        return;
+    }
+    SKALD_TIMED_SCOPE("call commit");
+    const std::string id = this->beginUndo();
+
+    for (const ResolvedCall &call : calls) {
+        Ref<BinaryNinja::Function> caller =
+            _view->GetAnalysisFunction(_view->GetDefaultPlatform(), call.caller);
+        if (!caller) continue;
+        SKALD_COUNT(ADD_CODE_REFERENCE, call.targets.size());
+        for (address_t target : call.targets)
+            caller->AddUserCodeReference(caller->GetArchitecture(), call.site, target);
+    }
+
+    this->commitUndo(id);
+}
+
+void Annotator::createMissingFunctions() {
+    if (this->missingFunctions.empty()) return;
+    SKALD_TIMED_SCOPE("function creation");
+
+    std::ranges::sort(this->missingFunctions);
+    const auto [last, end] = std::ranges::unique(this->missingFunctions);
+    this->missingFunctions.erase(last, end);
+    logInfo("Creating {} functions referenced by vtables", this->missingFunctions.size());
+
+    // Creating a function schedules its analysis, hold it until all of them exist
+    _view->SetAnalysisHold(true);
+    SKALD_COUNT(CREATE_FUNCTION, this->missingFunctions.size());
+    for (address_t addr : this->missingFunctions)
+        _view->CreateUserFunction(_view->GetDefaultPlatform(), addr);
+    _view->SetAnalysisHold(false);
+    _view->UpdateAnalysisAndWait();
+
+    // The slots can now be typed from the analyzed functions
+    const std::string id = this->beginUndo();
+    for (const auto &[name, functions] : this->incompleteVtables) {
+        bool complete = true;
+        this->types.define(name + "_t", this->createVtableType(functions, complete));
+    }
+    this->types.flush();
+    this->commitUndo(id);
+
+    this->missingFunctions.clear();
+    this->incompleteVtables.clear();
+}
+
+std::string Annotator::beginUndo() { return _view->BeginUndoActions(); }
+
+void Annotator::commitUndo(const std::string &id) {
+    if (this->undo)
+        _view->CommitUndoActions(id);
+    else
+        _view->ForgetUndoActions(id);
+}
+
+bool Annotator::isDefined(address_t address) {
+    SKALD_COUNT(GET_DATA_VARIABLE, 1);
+    BinaryNinja::DataVariable var;
+    return _view->GetDataVariableAtAddress(address, var);
+}
+
+void Annotator::nameFunctions(const VtableRecord &vtable) {
+    if (!this->signatures || vtable.signature == NO_SIGNATURE) return;
+    const size_t count =
+        std::min(vtable.functions.size(), this->signatures->getSlotCount(vtable.signature));
+    for (size_t i = 0; i < count; ++i) {
+        const std::string_view name = this->signatures->getFunction(vtable.signature, i);
+        const address_t address = vtable.functions[i];
+        if (name.empty() || address == 0 || _view->GetSymbolByAddress(address)) continue;
+        SKALD_COUNT(DEFINE_SYMBOL, 1);
+        _view->DefineUserSymbol(
+            new BinaryNinja::Symbol(BNSymbolType::FunctionSymbol, std::string(name), address));
+    }
+}
+
+Ref<Type> Annotator::typeInfoType(const TypeInfoRecord &typeInfo) {
+    switch (typeInfo.type) {
+        case CLASS_TYPE_INFO:
+        case FUNDAMENTAL_TYPE_INFO:
+        case ARRAY_TYPE_INFO:
+        case ENUM_TYPE_INFO:
+        case FUNCTION_TYPE_INFO:
+            return this->defineClassType();
+        case VMI_CLASS_TYPE_INFO:
+            return this->defineVmiClassType(typeInfo.baseCount);
+        case SI_CLASS_TYPE_INFO:
+            return this->defineSiClassType();
+        case PBASE_TYPE_INFO:
+        case POINTER_TYPE_INFO:
+            return this->definePbaseClassType();
+        case POINTER_TO_MEMBER_TYPE_INFO:
+            return this->definePointerToMemberClassType();
+        default:
+            return nullptr;
+    }
+}
+
+std::string Annotator::vtableName(const VtableRecord &vtable) {
+    std::string name;
+    if (vtable.kind != VtableKind::CONSTRUCTION) {
+        name = fmt::format("vtable_{}", this->names.decode(vtable.className));
+    } else if (!vtable.owner.empty()) {
+        name = fmt::format("construction_vtable_{}_in_{}", this->names.decode(vtable.className),
+                           this->names.decode(vtable.owner));
+    } else {
+        // Not referenced by any VTT, the address keeps the name unique
+        name = fmt::format("construction_vtable_{}_{:x}", this->names.decode(vtable.className),
+                           vtable.address);
+    }
+    if (vtable.offsetToTop == 0) return name;
+
+    const std::string_view subobject =
+        vtable.subobject.empty() ? "unknown" : this->names.decode(vtable.subobject);
+    return fmt::format("{}_for_{}_{:#x}", name, subobject, -vtable.offsetToTop);
+}
+
+Ref<Type> Annotator::createVtableType(const std::vector<address_t> &functionPointers,
+                                      bool &complete) {
+    StructureBuilder vtableBuilder;
+    vtableBuilder.SetPropagateDataVariableReferences(true);  // same as __vtable or __data_var_ref
+
+    // Add each function pointer
+    size_t missing = 0;
+    for (size_t i = 0; i < functionPointers.size(); ++i) {
+        const uint64_t addr = functionPointers[i];
+        if (addr == 0) {
+            // Left out of a construction vtable, or a pure virtual function
+            vtableBuilder.AddMember(this->types.getVoidPointer(), fmt::format("null_{}", i));
+            continue;
+        }
+
+        // Get function at current address
+        auto functions = _view->GetAnalysisFunctionsForAddress(addr);
+        if (functions.empty()) {
+            // No function defined. It is created later together with the others, until then the
+            // slot is a plain `void (*)(void *this)`
+            ++missing;
+            this->missingFunctions.push_back(addr);
+            complete = false;
+            vtableBuilder.AddMember(
+                this->types.getFunctionPointer(Type::VoidType(),
+                                               {{"this", this->types.getVoidPointer()}}),
+                fmt::format("sub_{:x}", addr));
+            continue;
+        } else if (functions.size() > 1) {  // More than one function, pick the first one
+            logWarn(
+                "More than one function defined at address {:#x}. Optimistically picking the "
+                "first one",
+                addr);
+        }
+
+        // Recover previous type definition for the function
+        auto functionType = functions[0]->GetType();
+        auto retType = functionType->GetChildType();
+        auto params = functionType->GetParameters();
+        // Use a `void * this` for the time being
+        if (params.empty()) params.resize(1);
+        params[0] = {"this", this->types.getVoidPointer()};
+
+        // Adding method to the vtable, the pointer type is shared by the identical signatures
+        const std::string name = functions[0]->GetSymbol()->GetShortName();
+        if (isLogEnabled(LogLevel::DEBUG))
+            logDebug("Adding function `{} (*{})(void *this, ...)`", retType->GetString(), name);
+        vtableBuilder.AddMember(this->types.getFunctionPointer(retType, params), name);
+    }
+    if (missing > 0)
+        logDebug("{} slots without a function, created later for the default platform", missing);
+
+    return Type::StructureType(vtableBuilder.Finalize());
+}
+
+Ref<Type> Annotator::defineClassType() {
+    return this->types.getNamed("__class_type", [&] {
+        StructureBuilder typeInfoBuilder;
+        typeInfoBuilder.AddMember(this->types.getVoidPointer(), "type_info");
+        typeInfoBuilder.AddMember(this->types.getCharPointer(), "__type_name");
+        return Type::StructureType(typeInfoBuilder.Finalize());
+    });
+}
+
+Ref<Type> Annotator::defineBaseClass() {
+    return this->types.getNamed("__base_class_type_info", [&] {
+        StructureBuilder typeBuilder;
+        typeBuilder.AddMember(this->types.getVoidPointer(), "__base_type");
+        // A `long`, as wide as the pointers
+        typeBuilder.AddMember(Type::IntegerType(_view->GetAddressSize(), true, "long"),
+                              "__offset_flags");
+        return Type::StructureType(typeBuilder.Finalize());
+    });
+}
+
+Ref<Type> Annotator::defineVmiClassType(uint32_t base_count) {
+    return this->types.getNamed(fmt::format("__vmi_class_type_{}", base_count), [&] {
+        // Define inner struct
+        const auto baseClassTypeInfo = this->defineBaseClass();
+
+        StructureBuilder typeInfoBuilder;
+        typeInfoBuilder.AddMember(this->types.getVoidPointer(), "type_info");
+        typeInfoBuilder.AddMember(this->types.getCharPointer(), "__type_name");
+        typeInfoBuilder.AddMember(Type::IntegerType(4, false, "unsigned int"), "__flags");
+        typeInfoBuilder.AddMember(Type::IntegerType(4, false, "unsigned int"), "__base_count");
+        typeInfoBuilder.AddMember(Type::ArrayType(baseClassTypeInfo, base_count), "__base_info");
+        return Type::StructureType(typeInfoBuilder.Finalize());
+    });
+}
+
+Ref<Type> Annotator::defineSiClassType() {
+    return this->types.getNamed("__si_class_type", [&] {
+        StructureBuilder typeInfoBuilder;
+        typeInfoBuilder.AddMember(this->types.getVoidPointer(), "type_info");
+        typeInfoBuilder.AddMember(this->types.getCharPointer(), "__type_name");
+        typeInfoBuilder.AddMember(this->types.getVoidPointer(), "__base_type");
+        return Type::StructureType(typeInfoBuilder.Finalize());
+    });
+}
+
+Ref<Type> Annotator::definePbaseClassType() {
+    return this->types.getNamed("__pbase_class_type", [&] {
+        StructureBuilder typeInfoBuilder;
+        typeInfoBuilder.AddMember(this->types.getVoidPointer(), "type_info");
+        typeInfoBuilder.AddMember(this->types.getCharPointer(), "__type_name");
+        typeInfoBuilder.AddMember(Type::IntegerType(4, false, "unsigned int"), "__flags");
+        typeInfoBuilder.AddMember(this->types.getVoidPointer(), "__pointee");
+        return Type::StructureType(typeInfoBuilder.Finalize());
+    });
+}
+
+Ref<Type> Annotator::definePointerToMemberClassType() {
+    return this->types.getNamed("__pointer_to_member_type_info", [&] {
+        StructureBuilder typeInfoBuilder;
+        typeInfoBuilder.SetBaseStructures({BaseStructure(this->definePbaseClassType(), 0)});
+        typeInfoBuilder.AddMember(this->types.getVoidPointer(), "__context");
+        return Type::StructureType(typeInfoBuilder.Finalize());
+    });
+}
+
+}  // namespace skald
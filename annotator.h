@@ -0,0 +1,106 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "binaryninjaapi.h"
+#include "call_resolution.h"
+#include "compact_graph.h"
+#include "layout_recovery.h"
+#include "signature_pack.h"
+#include "skald.h"
+#include "type_interner.h"
+#include "type_name_decoder.h"
+
+namespace skald {
+
+// Applies the results of a `Skald` run to a BinaryView: type_info and vtable types, data
+// variables and symbols
+class Annotator {
+   public:
+    Annotator(BinaryNinja::BinaryView *view);
+    void apply(const Skald &skald);
+
+    // Records committed per undo action, and whether the undo actions are kept at all. Without
+    // them the view does not hold a copy of every definition, which grows with the binary
+    void setBatching(size_t batchSize, bool undo) {
+        this->batchSize = std::max<size_t>(batchSize, 1);
+        this->undo = undo;
+    }
+
+    // Pack given to `Skald`: the functions of the primary vtables matching one of its classes get
+    // the symbols of the reference build, which the vtable types then use for their slots
+    void setSignatures(std::shared_ptr<const SignaturePack> signatures) {
+        this->signatures = std::move(signatures);
+    }
+
+    // Each one is a separate undo action, or several of them for more than a batch of records, so
+    // that the records can be applied while the analysis is still running
+    void applyTypeInfos(std::span<const TypeInfoRecord> typeInfos);
+    void applyVtables(std::span<const VtableRecord> vtables);
+    void applyVtts(std::span<const VttRecord> vtts);
+
+    // Structures of the classes, named after them. Those already defined in the view are kept
+    void applyLayouts(const CompactGraph &graph, std::span<const ClassLayout> layouts);
+
+    // Code references from the virtual call sites to their targets, for the call graph
+    void applyCalls(std::span<const ResolvedCall> calls);
+
+    // Create, in a single batch, the functions missing at the slots of the vtables applied so far,
+    // then fill the vtable types from the analysis results
+    void createMissingFunctions();
+
+   private:
+    BinaryNinja::BinaryView *_view;
+    TypeInterner types;     // Shared by all the batches
+    TypeNameDecoder names;  // Display names of the classes, decoded once
+
+    size_t batchSize = SIZE_MAX;
+    bool undo = true;
+    std::shared_ptr<const SignaturePack> signatures;
+
+    std::vector<address_t> missingFunctions;  // Slots without a function, created at the end
+    // Type name and slots of the vtables having some of those slots
+    std::vector<std::pair<std::string, std::vector<address_t>>> incompleteVtables;
+
+    std::string beginUndo();
+    void commitUndo(const std::string &id);
+
+    // Length of the batch of `records` starting at `first`
+    template <typename T>
+    size_t getBatchSize(size_t first, std::span<const T> records) const {
+        return std::min(this->batchSize, records.size() - first);
+    }
+
+    bool isDefined(address_t address);
+
+    // Define the symbols the signature pack knows for the functions of `vtable`, unless they
+    // already have one
+    void nameFunctions(const VtableRecord &vtable);
+
+    // Type of the type_info object, nullptr if it is not supported
+    BinaryNinja::Ref<BinaryNinja::Type> typeInfoType(const TypeInfoRecord &typeInfo);
+
+    // Symbol of the vtable, `vtable_Derived_for_Base_0x10` for a secondary one and
+    // `construction_vtable_Base_in_Derived` for a construction one. Its type is suffixed with `_t`
+    std::string vtableName(const VtableRecord &vtable);
+    // Slots without a function get a placeholder member, `complete` is then set to false
+    BinaryNinja::Ref<BinaryNinja::Type> createVtableType(const std::vector<address_t> &functions,
+                                                         bool &complete);
+
+    BinaryNinja::Ref<BinaryNinja::Type> defineClassType();
+    BinaryNinja::Ref<BinaryNinja::Type> defineBaseClass();
+    BinaryNinja::Ref<BinaryNinja::Type> defineVmiClassType(uint32_t base_count);
+    BinaryNinja::Ref<BinaryNinja::Type> defineSiClassType();
+    BinaryNinja::Ref<BinaryNinja::Type> definePbaseClassType();
+    BinaryNinja::Ref<BinaryNinja::Type> definePointerToMemberClassType();
+};
+
+}  // namespace skald
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "abi.h"
+#include "bitmask.h"
+#include "types.h"
+
+namespace skald {
+
+typedef enum : uint32_t { READABLE = 1, WRITABLE = 2, EXECUTABLE = 4 } SectionFlag;
+DECLARE_BITMASK(SectionFlag);
+
+struct Section {
+    std::string name;
+    address_t start;
+    address_t end;
+    SectionFlag flags;
+
+    bool operator==(const Section &other) const = default;
+};
+
+constexpr uint32_t NO_SYMBOL = UINT32_MAX;
+constexpr int64_t UNKNOWN_ADDEND = INT64_MIN;
+
+struct Relocation {
+    address_t address;  // Address patched by the relocation
+    uint32_t symbol;    // Index of the target in `RelocationTable::symbols`, or NO_SYMBOL
+    int64_t addend = UNKNOWN_ADDEND;  // Added to the address of the symbol, 0 for a GOT entry
+};
+
+// All the relocations of the binary. The target symbols are stored once and referenced by index
+struct RelocationTable {
+    std::vector<std::string> symbols;  // Raw (mangled) names of the target symbols
+    std::vector<Relocation> relocations;
+};
+
+// Read-only view over the binary being analyzed. `Skald` only ever talks to the binary through
+// this interface, so that the same recovery logic runs both inside Binary Ninja and headless.
+// Implementations must be safe to query from multiple threads at the same time
+class Backend {
+   public:
+    virtual ~Backend() = default;
+
+    virtual std::vector<Section> getSections() = 0;
+    virtual std::vector<Section> getSegments() = 0;  // Loaded memory ranges, they have no name
+    virtual RelocationTable getRelocations() = 0;
+
+    // Read up to `len` bytes at `address`. Returns the number of bytes actually read
+    virtual size_t read(void *dest, address_t address, size_t len) = 0;
+
+    virtual bool isValidOffset(address_t address) = 0;
+    virtual bool isOffsetReadable(address_t address) = 0;
+    virtual bool isOffsetExecutable(address_t address) = 0;
+    virtual std::optional<Section> getSectionAt(address_t address) = 0;
+
+    // Pointer size, byte order and C++ ABI of the binary
+    virtual Abi getAbi() { return {}; }
+
+    // Incremented every time the content of the binary changes, so that the users can drop what
+    // they cached
+    virtual uint64_t getGeneration() { return 0; }
+};
+
+}  // namespace skald
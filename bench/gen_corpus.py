@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+"""Generate a synthetic C++ corpus for skald-bench.
+
+The corpus is a single translation unit with a random class hierarchy (single, multiple and
+virtual inheritance, class templates). It is compiled with every compiler available, the binaries
+are stripped and the ground truth is taken from the symbols of the unstripped build. For each
+compiler `<output>/corpus-<compiler>` and `<output>/corpus-<compiler>.truth` are written, the
+truth lists the classes in the same format as skald-cli.
+"""
+
+import argparse
+import random
+import shutil
+import subprocess
+import sys
+from pathlib import Path
+
+
+def generate(args):
+    """Return the source and, for each class, its mangled name and its bases."""
+    rng = random.Random(args.seed)
+    levels = min(args.depth + 1, args.classes)
+    classes = []
+
+    for i in range(args.classes):
+        name = f"C{i}"
+        template = rng.random() < args.templates
+        mangled = f"{len(name)}{name}" + ("ILi0EE" if template else "")
+        spelling = f"{name}<0>" if template else name
+
+        # The first base comes from the level above, so that the hierarchy has the requested depth
+        bases = []
+        level = i * levels // args.classes
+        if level > 0:
+            level_start = (level * args.classes + levels - 1) // levels
+            previous_start = ((level - 1) * args.classes + levels - 1) // levels
+            count = 1
+            if args.fan_out > 1 and rng.random() < args.multiple:
+                count = rng.randint(2, args.fan_out)
+            count = min(count, level_start)
+            chosen = [rng.randrange(previous_start, level_start)]
+            while len(chosen) < count:
+                base = rng.randrange(0, level_start)
+                if base not in chosen:
+                    chosen.append(base)
+            bases = [(base, rng.random() < args.virtual) for base in chosen]
+
+        classes.append((name, template, mangled, spelling, bases))
+
+    lines = []
+    for i, (name, template, _, _, bases) in enumerate(classes):
+        inheritance = ", ".join(
+            ("virtual " if is_virtual else "") + classes[base][3] for base, is_virtual in bases
+        )
+        prefix = "template <int N> " if template else ""
+        value = f"{i} + N" if template else f"{i}"
+        lines.append(
+            f"{prefix}struct {name}{' : ' + inheritance if inheritance else ''} {{ "
+            f"virtual ~{name}() {{}} virtual int f{i}() {{ return {value}; }} "
+            f"virtual int g{i}() {{ return {i % 7}; }} }};"
+        )
+
+    # Every class is instantiated, so that its vtable and type_info are emitted
+    lines.append("void *make(int i) { switch (i) {")
+    lines += [f"case {i}: return new {spelling};" for i, (_, _, _, spelling, _) in enumerate(classes)]
+    lines.append("} return 0; }")
+    lines.append("int main(int argc, char **) { return make(argc) != 0; }")
+    return "\n".join(lines) + "\n", classes
+
+
+def truth(binary, classes):
+    """Class lines of skald-cli, with the addresses of the type_info symbols."""
+    output = subprocess.run(["nm", binary], check=True, capture_output=True, text=True).stdout
+    addresses = {}
+    for line in output.splitlines():
+        fields = line.split()
+        if len(fields) == 3 and fields[2].startswith("_ZTI"):
+            addresses[fields[2][4:]] = int(fields[0], 16)
+
+    lines = []
+    for _, _, mangled, _, bases in classes:
+        if mangled not in addresses:
+            continue
+        line = f"class {addresses[mangled]:#x} {mangled}"
+        for j, (base, is_virtual) in enumerate(bases):
+            line += " : " if j == 0 else ", "
+            line += "public " + ("virtual " if is_virtual else "") + classes[base][2]
+        lines.append(line)
+    return "\n".join(lines) + "\n"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("-n", "--classes", type=int, default=2000, help="number of classes")
+    parser.add_argument("--depth", type=int, default=6, help="levels below the roots")
+    parser.add_argument("--fan-out", type=int, default=3, help="maximum number of direct bases")
+    parser.add_argument("--multiple", type=float, default=0.2,
+                        help="probability of multiple inheritance")
+    parser.add_argument("--virtual", type=float, default=0.1,
+                        help="probability of a virtual base")
+    parser.add_argument("--templates", type=float, default=0.1,
+                        help="probability of a class template")
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--compilers", default="g++,clang++",
+                        help="comma separated list, the missing ones are skipped")
+    parser.add_argument("--flags", default="-O1", help="compilation flags")
+    parser.add_argument("-o", "--output", type=Path, default=Path("corpus"))
+    args = parser.parse_args()
+
+    args.output.mkdir(parents=True, exist_ok=True)
+    source, classes = generate(args)
+    source_path = args.output / "corpus.cpp"
+    source_path.write_text(source)
+
+    built = 0
+    for compiler in args.compilers.split(","):
+        if not shutil.which(compiler):
+            print(f"{compiler} not found, skipping", file=sys.stderr)
+            continue
+        name = "gcc" if compiler.startswith("g++") else compiler.removesuffix("++")
+        binary = args.output / f"corpus-{name}"
+        subprocess.run([compiler, "-std=c++17", "-w", *args.flags.split(), "-o", binary,
+                        source_path], check=True)
+        Path(f"{binary}.truth").write_text(truth(binary, classes))
+        subprocess.run(["strip", binary], check=True)
+        print(f"{binary}: {len(classes)} classes")
+        built += 1
+
+    return 0 if built else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
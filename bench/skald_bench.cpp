@@ -0,0 +1,321 @@
+// Benchmark harness: time each phase of the recovery on real binaries and on synthetic images, and
+// check the recovered classes against the ground truth
+#include <fmt/format.h>
+#include <malloc.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include "compact_graph.h"
+#include "elf_backend.h"
+#include "log.h"
+#include "run_observer.h"
+#include "skald.h"
+#include "synthetic_backend.h"
+#include "trace_backend.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::array PHASES = {skald::Phase::RELOCATIONS, skald::Phase::RTTI,
+                               skald::Phase::VTABLES};
+
+void usage(const char *argv0) {
+    fmt::print(stderr,
+               "usage: {} [-c] [-j threads] [-r repeats] [-m budget] [-s classes]...\n"
+               "       [binary | replay | directory]...\n"
+               "\n"
+               "Time the phases of the recovery on each binary, replay trace (see skald-cli -w)\n"
+               "and synthetic image. Directories are scanned recursively for ELF binaries.\n"
+               "A binary is checked against `<binary>.truth` when it exists (see gen_corpus.py).\n"
+               "\n"
+               "  -c  print the results as CSV, to compare them across builds\n"
+               "  -j  number of threads used for the analysis (default: one per core)\n"
+               "  -r  number of runs per input, the fastest one is reported (default: 3)\n"
+               "  -m  run in streaming mode, holding about this many MiB of records at once\n"
+               "  -s  add a synthetic image with the given number of classes\n",
+               argv0);
+}
+
+// Records the time at which each phase ends, and counts the records as a streaming run does not
+// keep them
+class PhaseTimer : public skald::RunObserver {
+   public:
+    std::array<Clock::time_point, PHASES.size()> ends;
+    size_t typeInfos = 0;
+    size_t vtables = 0;
+
+    void typeInfosAdded(const skald::Skald &skald,
+                        std::span<const skald::TypeInfoRecord> records) override {
+        this->typeInfos += records.size();
+    }
+
+    void vtablesAdded(const skald::Skald &skald,
+                      std::span<const skald::VtableRecord> records) override {
+        this->vtables += records.size();
+    }
+
+    void progress(skald::Phase phase, size_t done, size_t total) override {
+        if (done == total) this->ends[static_cast<size_t>(phase)] = Clock::now();
+    }
+
+    void phaseCompleted(const skald::Skald &skald, skald::Phase phase) override {
+        this->ends[static_cast<size_t>(phase)] = Clock::now();
+    }
+};
+
+struct Measure {
+    std::array<double, PHASES.size()> phases{};  // Seconds
+    double total = 0;
+    double peakRss = 0;  // MiB, during the runs of this input only
+    size_t classes = 0;
+    size_t vtables = 0;
+    std::vector<std::string> lines;  // Recovered classes, in the ground truth format
+};
+
+// Same format as the `class` lines of skald-cli
+std::vector<std::string> classLines(
+    const skald::CompactGraph &graph,
+    const std::function<std::string(skald::address_t)> &externalName) {
+    std::vector<std::string> lines;
+    for (skald::class_id_t id = 0; id < graph.size(); ++id) {
+        if (graph.getName(id).empty()) continue;
+        std::string line = fmt::format("class {:#x} {}", graph.getAddress(id), graph.getName(id));
+        bool first = true;
+        for (const auto &[base, flags, offset] : graph.getChildren(id)) {
+            line += first ? " : " : ", ";
+            line += flags & skald::EdgeFlag::PUBLIC ? "public " : "private ";
+            if (flags & skald::EdgeFlag::VIRTUAL) line += "virtual ";
+            line += graph.getName(base).empty() ? externalName(graph.getAddress(base))
+                                                : std::string(graph.getName(base));
+            first = false;
+        }
+        lines.push_back(std::move(line));
+    }
+    return lines;
+}
+
+// The peak RSS of the process is reset before each input, so that each one has its own. The memory
+// freed by the previous input goes back to the system first, else it would count in the new peak
+void resetPeakRss() {
+    malloc_trim(0);
+    std::ofstream("/proc/self/clear_refs") << "5";
+}
+
+// Peak RSS since the last reset
+double peakRssMiB() {
+    std::ifstream status("/proc/self/status");
+    for (std::string line; std::getline(status, line);)
+        if (line.starts_with("VmHWM:")) return std::strtod(line.c_str() + 6, nullptr) / 1024.0;
+    return 0;
+}
+
+// `budget` is the memory budget of the streaming mode in MiB, 0 for a regular run
+Measure measure(skald::Backend &backend, size_t threads, size_t repeats, size_t budget,
+                const std::function<std::string(skald::address_t)> &externalName) {
+    resetPeakRss();
+    Measure best;
+    for (size_t run = 0; run < repeats; ++run) {
+        PhaseTimer timer;
+        skald::Skald skald(backend, threads);
+        skald.setObserver(&timer);
+        if (budget != 0) skald.setStreaming(skald::StreamingOptions{budget << 20, {}});
+
+        const auto start = Clock::now();
+        skald.run();
+        const auto end = Clock::now();
+
+        Measure current;
+        auto previous = start;
+        for (size_t i = 0; i < PHASES.size(); ++i) {
+            current.phases[i] = std::chrono::duration<double>(timer.ends[i] - previous).count();
+            previous = timer.ends[i];
+        }
+        current.total = std::chrono::duration<double>(end - start).count();
+        current.classes = timer.typeInfos;
+        current.vtables = timer.vtables;
+
+        if (run == 0 || current.total < best.total) {
+            current.lines = classLines(skald.getInheritanceGraph(), externalName);
+            best = std::move(current);
+        }
+    }
+    best.peakRss = peakRssMiB();
+    return best;
+}
+
+// "matched/expected", followed by the number of unexpected classes if any
+std::string checkTruth(const std::vector<std::string> &recovered,
+                       const std::vector<std::string> &truth, bool &ok) {
+    if (truth.empty()) return "-";
+    const std::unordered_set<std::string> found(recovered.begin(), recovered.end());
+    const std::unordered_set<std::string> expected(truth.begin(), truth.end());
+    const size_t matched = std::ranges::count_if(expected, [&](const auto &line) {
+        return found.contains(line);
+    });
+    const size_t extra = found.size() - matched;
+    ok &= matched == expected.size();
+    return extra ? fmt::format("{}/{} +{}", matched, expected.size(), extra)
+                 : fmt::format("{}/{}", matched, expected.size());
+}
+
+void printHeader(bool csv) {
+    if (csv) {
+        fmt::print("input,classes,vtables,relocs_ms,rtti_ms,vtables_ms,total_ms,classes_per_s,"
+                   "vtables_per_s,peak_rss_mib,truth\n");
+        return;
+    }
+    fmt::print("{:<32} {:>8} {:>8} {:>10} {:>10} {:>10} {:>10} {:>11} {:>11} {:>9}  {}\n",
+               "input", "classes", "vtables", "relocs ms", "rtti ms", "vtables ms", "total ms",
+               "classes/s", "vtables/s", "RSS MiB", "truth");
+}
+
+void printRow(bool csv, std::string_view input, const Measure &result,
+              const std::string &truth) {
+    if (csv) {
+        fmt::print("{},{},{},{:.3f},{:.3f},{:.3f},{:.3f},{:.0f},{:.0f},{:.1f},{}\n", input,
+                   result.classes, result.vtables, result.phases[0] * 1e3,
+                   result.phases[1] * 1e3, result.phases[2] * 1e3, result.total * 1e3,
+                   result.classes / result.total, result.vtables / result.total, result.peakRss,
+                   truth);
+        std::fflush(stdout);
+        return;
+    }
+    fmt::print(
+        "{:<32} {:>8} {:>8} {:>10.2f} {:>10.2f} {:>10.2f} {:>10.2f} {:>11.0f} {:>11.0f} {:>9.1f}  "
+        "{}\n",
+        input, result.classes, result.vtables, result.phases[0] * 1e3, result.phases[1] * 1e3,
+        result.phases[2] * 1e3, result.total * 1e3, result.classes / result.total,
+        result.vtables / result.total, result.peakRss, truth);
+    std::fflush(stdout);
+}
+
+std::vector<std::string> readTruth(const std::filesystem::path &path) {
+    std::vector<std::string> lines;
+    std::ifstream file(path);
+    for (std::string line; std::getline(file, line);)
+        if (line.starts_with("class ")) lines.push_back(line);
+    return lines;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    skald::setLogLevel(skald::LogLevel::ERROR);
+
+    std::vector<std::filesystem::path> paths;
+    std::vector<size_t> synthetic;
+    size_t threads = 0;
+    size_t repeats = 3;
+    size_t budget = 0;
+    bool csv = false;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "-c")) {
+            csv = true;
+        } else if (!std::strcmp(argv[i], "-j") && i + 1 < argc) {
+            threads = std::strtoul(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "-r") && i + 1 < argc) {
+            repeats = std::max<size_t>(1, std::strtoul(argv[++i], nullptr, 10));
+        } else if (!std::strcmp(argv[i], "-m") && i + 1 < argc) {
+            budget = std::strtoul(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "-s") && i + 1 < argc) {
+            synthetic.push_back(std::strtoul(argv[++i], nullptr, 10));
+        } else if (argv[i][0] == '-') {
+            usage(argv[0]);
+            return 2;
+        } else {
+            std::error_code ec;
+            if (!std::filesystem::is_directory(argv[i], ec)) {
+                paths.emplace_back(argv[i]);
+                continue;
+            }
+            // Only pick up the ELF files when walking a directory, in a stable order
+            std::vector<std::filesystem::path> found;
+            for (auto it = std::filesystem::recursive_directory_iterator(
+                     argv[i], std::filesystem::directory_options::skip_permission_denied, ec);
+                 it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+                if (ec) break;
+                if (it->is_regular_file(ec) && skald::ElfBackend::isElf(it->path()))
+                    found.push_back(it->path());
+            }
+            std::ranges::sort(found);
+            paths.insert(paths.end(), found.begin(), found.end());
+        }
+    }
+    if (paths.empty() && synthetic.empty()) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    bool ok = true;
+    printHeader(csv);
+
+    for (size_t classes : synthetic) {
+        skald::HierarchyShape shape;
+        shape.classes = classes;
+        skald::SyntheticBackend backend(shape);
+
+        // The ground truth is the generated hierarchy itself
+        std::vector<std::string> truth;
+        for (const auto &cls : backend.getClasses()) {
+            std::string line = fmt::format("class {:#x} {}", cls.typeInfo, cls.name);
+            for (size_t i = 0; i < cls.bases.size(); ++i) {
+                const auto [base, flags] = cls.bases[i];
+                line += i == 0 ? " : public " : ", public ";
+                if (flags & skald::EdgeFlag::VIRTUAL) line += "virtual ";
+                line += backend.getClasses()[base].name;
+            }
+            truth.push_back(std::move(line));
+        }
+
+        const Measure result =
+            measure(backend, threads, repeats, budget,
+                    [](skald::address_t) { return "<unknown>"; });
+        printRow(csv, fmt::format("synthetic-{}", classes), result,
+                 checkTruth(result.lines, truth, ok));
+    }
+
+    for (const auto &path : paths) {
+        try {
+            Measure result;
+            if (skald::TraceBackend::isTrace(path)) {
+                // A trace has no symbols to name the imported classes
+                skald::TraceBackend backend(path);
+                result = measure(backend, threads, repeats, budget,
+                                 [](skald::address_t) { return "<unknown>"; });
+            } else {
+                skald::ElfBackend backend(path);
+                result = measure(backend, threads, repeats, budget, [&](skald::address_t address) {
+                    std::string_view symbol = backend.getSymbolAt(address);
+                    if (symbol.starts_with("_ZTI")) symbol.remove_prefix(4);
+                    return symbol.empty() ? std::string("<unknown>") : std::string(symbol);
+                });
+            }
+
+            std::filesystem::path truthPath = path;
+            truthPath += ".truth";
+            printRow(csv, path.filename().string(), result,
+                     checkTruth(result.lines, readTruth(truthPath), ok));
+        } catch (const std::exception &e) {
+            skald::logError("{}: {}", path.string(), e.what());
+            ok = false;
+        }
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,192 @@
+#include "synthetic_backend.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "backend.h"
+#include "inheritance_graph.h"
+
+namespace skald {
+
+namespace {
+
+constexpr address_t TEXT_START = 0x401000;
+constexpr address_t EXTERN_START = 0x10000000;  // Imported type_info vtables, not mapped
+constexpr uint64_t PAGE_SIZE = 0x1000;
+constexpr uint64_t FUNCTION_SIZE = 0x10;
+
+// Symbols of the type_info vtables, indexed by the relocation symbol id
+const std::vector<std::string> TYPE_INFO_VTABLES = {
+    "_ZTVN10__cxxabiv117__class_type_infoE",
+    "_ZTVN10__cxxabiv120__si_class_type_infoE",
+    "_ZTVN10__cxxabiv121__vmi_class_type_infoE",
+};
+
+address_t alignUp(address_t value, uint64_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+void put64(std::vector<uint8_t> &data, uint64_t value) {
+    const size_t offset = data.size();
+    data.resize(offset + 8);
+    std::memcpy(data.data() + offset, &value, 8);
+}
+
+void put32(std::vector<uint8_t> &data, uint32_t value) {
+    const size_t offset = data.size();
+    data.resize(offset + 4);
+    std::memcpy(data.data() + offset, &value, 4);
+}
+
+}  // namespace
+
+SyntheticBackend::SyntheticBackend(const HierarchyShape &shape) {
+    std::mt19937_64 rng(shape.seed);
+    std::uniform_real_distribution<double> chance(0, 1);
+    const size_t count = std::max<size_t>(shape.classes, 1);
+    const size_t levels = std::min(shape.depth + 1, count);
+
+    // The classes are spread evenly over the levels. The first base of a class comes from the
+    // level above, so that the hierarchy has the requested depth, the others from any level above
+    this->classes.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        Class &cls = this->classes[i];
+        const std::string name = "Cls" + std::to_string(i);
+        cls.name = std::to_string(name.size()) + name;
+
+        const size_t level = i * levels / count;
+        if (level == 0) continue;
+        const size_t levelStart = (level * count + levels - 1) / levels;
+        const size_t previousStart = ((level - 1) * count + levels - 1) / levels;
+
+        size_t baseCount = 1;
+        if (shape.fanOut > 1 && chance(rng) < shape.multiple)
+            baseCount = std::uniform_int_distribution<size_t>(2, shape.fanOut)(rng);
+        baseCount = std::min(baseCount, levelStart);
+
+        std::vector<size_t> bases{std::uniform_int_distribution<size_t>(previousStart,
+                                                                        levelStart - 1)(rng)};
+        while (bases.size() < baseCount) {
+            const size_t base = std::uniform_int_distribution<size_t>(0, levelStart - 1)(rng);
+            if (std::ranges::find(bases, base) == bases.end()) bases.push_back(base);
+        }
+        for (size_t base : bases) {
+            const bool isVirtual = chance(rng) < shape.virtualBase;
+            cls.bases.emplace_back(base, isVirtual ? EdgeFlag::PUBLIC | EdgeFlag::VIRTUAL
+                                                   : EdgeFlag::PUBLIC);
+        }
+    }
+
+    // One primary vtable per class with a few functions, one secondary vtable with a thunk for
+    // each additional base
+    size_t functionCount = 0;
+    for (size_t i = 0; i < count; ++i)
+        functionCount += 2 + i % 4 + std::max<size_t>(1, this->classes[i].bases.size()) - 1;
+
+    const address_t rodataStart = alignUp(TEXT_START + functionCount * FUNCTION_SIZE, PAGE_SIZE);
+    std::vector<uint8_t> rodata;
+    std::vector<address_t> names(count);
+    for (size_t i = 0; i < count; ++i) {
+        names[i] = rodataStart + rodata.size();
+        rodata.insert(rodata.end(), this->classes[i].name.begin(), this->classes[i].name.end());
+        rodata.push_back(0);
+    }
+
+    const address_t dataStart = alignUp(rodataStart + rodata.size(), PAGE_SIZE);
+    std::vector<uint8_t> data;
+    address_t nextFunction = TEXT_START;
+    for (size_t i = 0; i < count; ++i) {
+        Class &cls = this->classes[i];
+        cls.typeInfo = dataStart + data.size();
+
+        // type_info object, its first word is patched by a relocation against the ABI vtable
+        const bool single = cls.bases.size() == 1 && !(cls.bases[0].second & EdgeFlag::VIRTUAL);
+        const uint32_t kind = cls.bases.empty() ? 0 : single ? 1 : 2;
+        this->relocations.relocations.push_back({cls.typeInfo, kind, 0x10});
+        put64(data, EXTERN_START + 0x100 * kind + 0x10);
+        put64(data, names[i]);
+        if (kind == 1) {
+            put64(data, this->classes[cls.bases[0].first].typeInfo);
+        } else if (kind == 2) {
+            put32(data, 0);
+            put32(data, cls.bases.size());
+            for (size_t j = 0; j < cls.bases.size(); ++j) {
+                const auto [base, flags] = cls.bases[j];
+                put64(data, this->classes[base].typeInfo);
+                put64(data, (8 * j) << 8 | flags);
+            }
+        }
+
+        // Vtables: `offset_to_top`, RTTI pointer, then the virtual functions
+        const size_t vtables = std::max<size_t>(1, cls.bases.size());
+        for (size_t j = 0; j < vtables; ++j) {
+            put64(data, -8 * static_cast<int64_t>(j));
+            put64(data, cls.typeInfo);
+            for (size_t k = 0; k < (j == 0 ? 2 + i % 4 : 1); ++k) {
+                put64(data, nextFunction);
+                nextFunction += FUNCTION_SIZE;
+            }
+        }
+        this->vtableCount += vtables;
+    }
+    this->relocations.symbols = TYPE_INFO_VTABLES;
+
+    this->sections = {
+        {".text", TEXT_START, nextFunction, SectionFlag::READABLE | SectionFlag::EXECUTABLE},
+        {".rodata", rodataStart, rodataStart + rodata.size(), SectionFlag::READABLE},
+        {".data.rel.ro", dataStart, dataStart + data.size(),
+         SectionFlag::READABLE | SectionFlag::WRITABLE},
+    };
+
+    // The code is never read, it only has to be executable
+    this->contents.emplace_back(nextFunction - TEXT_START, 0xcc);
+    this->contents.push_back(std::move(rodata));
+    this->contents.push_back(std::move(data));
+}
+
+std::vector<Section> SyntheticBackend::getSegments() {
+    std::vector<Section> segments = this->sections;
+    for (Section &segment : segments) segment.name.clear();
+    return segments;
+}
+
+size_t SyntheticBackend::read(void *dest, address_t address, size_t len) {
+    const Section *section = this->find(address);
+    if (!section) return 0;
+    const std::vector<uint8_t> &content = this->contents[section - this->sections.data()];
+    const size_t size = std::min<uint64_t>(len, section->end - address);
+    std::memcpy(dest, content.data() + (address - section->start), size);
+    return size;
+}
+
+bool SyntheticBackend::isValidOffset(address_t address) { return this->find(address) != nullptr; }
+
+bool SyntheticBackend::isOffsetReadable(address_t address) {
+    return this->find(address) != nullptr;
+}
+
+bool SyntheticBackend::isOffsetExecutable(address_t address) {
+    const Section *section = this->find(address);
+    return section && section->flags & SectionFlag::EXECUTABLE;
+}
+
+std::optional<Section> SyntheticBackend::getSectionAt(address_t address) {
+    const Section *section = this->find(address);
+    if (!section) return std::nullopt;
+    return *section;
+}
+
+const Section *SyntheticBackend::find(address_t address) const {
+    for (const Section &section : this->sections)
+        if (section.start <= address && address < section.end) return &section;
+    return nullptr;
+}
+
+}  // namespace skald
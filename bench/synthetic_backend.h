@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "backend.h"
+#include "inheritance_graph.h"
+
+namespace skald {
+
+// Shape of a generated class hierarchy
+struct HierarchyShape {
+    size_t classes = 1000;
+    size_t depth = 6;          // Number of levels below the roots
+    size_t fanOut = 3;         // Maximum number of direct bases
+    double multiple = 0.2;     // Probability that a class has more than one base
+    double virtualBase = 0.1;  // Probability that an inheritance edge is virtual
+    uint64_t seed = 1;
+};
+
+// In-memory image built from a random class hierarchy, laid out like the output of a compiler
+// following the Itanium ABI: names in `.rodata`, type_info objects and vtables in `.data.rel.ro`
+// and the relocations against the type_info vtables. It stands in for a Binary Ninja view, so
+// that the recovery can be measured without any I/O
+class SyntheticBackend : public Backend {
+   public:
+    struct Class {
+        std::string name;  // Mangled, as stored in the `_ZTS` string
+        std::vector<std::pair<size_t, EdgeFlag>> bases;
+        address_t typeInfo;
+    };
+
+    explicit SyntheticBackend(const HierarchyShape &shape);
+
+    const std::vector<Class> &getClasses() const { return this->classes; }
+    size_t getVtableCount() const { return this->vtableCount; }
+
+    std::vector<Section> getSections() override { return this->sections; }
+    std::vector<Section> getSegments() override;
+    RelocationTable getRelocations() override { return this->relocations; }
+    size_t read(void *dest, address_t address, size_t len) override;
+    bool isValidOffset(address_t address) override;
+    bool isOffsetReadable(address_t address) override;
+    bool isOffsetExecutable(address_t address) override;
+    std::optional<Section> getSectionAt(address_t address) override;
+
+   private:
+    std::vector<Class> classes;
+    size_t vtableCount = 0;
+    std::vector<Section> sections;  // Sorted by address, one segment each
+    std::vector<std::vector<uint8_t>> contents;
+    RelocationTable relocations;
+
+    const Section *find(address_t address) const;
+};
+
+}  // namespace skald
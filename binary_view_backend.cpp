@@ -0,0 +1,156 @@
+#include "binary_view_backend.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "backend.h"
+#include "binaryninjaapi.h"
+#include "instrumentation.h"
+
+namespace skald {
+
+using BinaryNinja::Ref;
+
+// Track the changes to the content of the view, including the ones done or reverted by undo
+class BinaryViewBackend::WriteListener : public BinaryNinja::BinaryDataNotification {
+   public:
+    WriteListener(std::atomic<uint64_t> &generation) : generation(generation) {}
+
+    void OnBinaryDataWritten(BinaryNinja::BinaryView *, uint64_t, size_t) override {
+        ++this->generation;
+    }
+    void OnBinaryDataInserted(BinaryNinja::BinaryView *, uint64_t, size_t) override {
+        ++this->generation;
+    }
+    void OnBinaryDataRemoved(BinaryNinja::BinaryView *, uint64_t, uint64_t) override {
+        ++this->generation;
+    }
+
+   private:
+    std::atomic<uint64_t> &generation;
+};
+
+BinaryViewBackend::BinaryViewBackend(BinaryNinja::BinaryView *view)
+    : _view(view), listener(std::make_unique<WriteListener>(this->generation)) {
+    _view->RegisterNotification(this->listener.get());
+}
+
+BinaryViewBackend::~BinaryViewBackend() { _view->UnregisterNotification(this->listener.get()); }
+
+Section BinaryViewBackend::toSection(const Ref<BinaryNinja::Section> &section) {
+    SectionFlag flags{};
+    if (_view->IsOffsetReadable(section->GetStart())) flags |= SectionFlag::READABLE;
+    if (_view->IsOffsetWritable(section->GetStart())) flags |= SectionFlag::WRITABLE;
+    if (_view->IsOffsetExecutable(section->GetStart())) flags |= SectionFlag::EXECUTABLE;
+    return {section->GetName(), section->GetStart(), section->GetEnd(), flags};
+}
+
+std::vector<Section> BinaryViewBackend::getSections() {
+    SKALD_COUNT(GET_SECTIONS, 1);
+    std::vector<Section> sections;
+    for (const auto &section : _view->GetSections()) sections.push_back(this->toSection(section));
+    return sections;
+}
+
+std::vector<Section> BinaryViewBackend::getSegments() {
+    SKALD_COUNT(GET_SEGMENTS, 1);
+    std::vector<Section> segments;
+    for (const auto &segment : _view->GetSegments()) {
+        const uint32_t segmentFlags = segment->GetFlags();
+        SectionFlag flags{};
+        if (segmentFlags & SegmentReadable) flags |= SectionFlag::READABLE;
+        if (segmentFlags & SegmentWritable) flags |= SectionFlag::WRITABLE;
+        if (segmentFlags & SegmentExecutable) flags |= SectionFlag::EXECUTABLE;
+        segments.push_back({"", segment->GetStart(), segment->GetEnd(), flags});
+    }
+    return segments;
+}
+
+RelocationTable BinaryViewBackend::getRelocations() {
+    SKALD_COUNT(GET_RELOCATIONS, 1);
+    RelocationTable table;
+    std::unordered_map<BNSymbol *, uint32_t> symbolIds;  // Fetch the name once per symbol
+
+    for (auto [start, end] : _view->GetRelocationRanges()) {
+        // A range can hold more than one relocation, visit all of them
+        for (uint64_t addr = start; addr < end;) {
+            const auto relocations = _view->GetRelocationsAt(addr);
+            if (relocations.empty()) {
+                ++addr;
+                continue;
+            }
+
+            size_t size = 1;
+            for (const auto &rel : relocations) {
+                const BNRelocationInfo info = rel->GetInfo();
+                size = std::max<size_t>(size, info.size);
+
+                // The GOT and PLT entries only take the address of the symbol
+                int64_t addend =
+                    info.implicitAddend ? UNKNOWN_ADDEND : static_cast<int64_t>(info.addend);
+                if (info.type == ELFGlobalRelocationType || info.type == ELFJumpSlotRelocationType)
+                    addend = 0;
+
+                uint32_t id = NO_SYMBOL;
+                if (const auto symbol = rel->GetSymbol()) {
+                    auto [it, inserted] = symbolIds.try_emplace(
+                        symbol->GetObject(), static_cast<uint32_t>(table.symbols.size()));
+                    if (inserted) table.symbols.push_back(symbol->GetRawName());
+                    id = it->second;
+                }
+                table.relocations.push_back({addr, id, addend});
+            }
+            addr += size;
+        }
+    }
+    return table;
+}
+
+size_t BinaryViewBackend::read(void *dest, address_t address, size_t len) {
+    SKALD_COUNT(READ, 1);
+    SKALD_COUNT(BYTES_READ, len);
+    return _view->Read(dest, address, len);
+}
+
+bool BinaryViewBackend::isValidOffset(address_t address) {
+    SKALD_COUNT(IS_VALID_OFFSET, 1);
+    return _view->IsValidOffset(address);
+}
+
+bool BinaryViewBackend::isOffsetReadable(address_t address) {
+    SKALD_COUNT(IS_OFFSET_READABLE, 1);
+    return _view->IsOffsetReadable(address);
+}
+
+bool BinaryViewBackend::isOffsetExecutable(address_t address) {
+    SKALD_COUNT(IS_OFFSET_EXECUTABLE, 1);
+    return _view->IsOffsetExecutable(address);
+}
+
+std::optional<Section> BinaryViewBackend::getSectionAt(address_t address) {
+    SKALD_COUNT(GET_SECTION_AT, 1);
+    auto sections = _view->GetSectionsAt(address);
+    if (sections.empty()) return std::nullopt;
+    return this->toSection(sections[0]);
+}
+
+Abi BinaryViewBackend::getAbi() {
+    Abi abi;
+    abi.pointerSize = _view->GetAddressSize();
+    abi.order = _view->GetDefaultEndianness() == BigEndian ? std::endian::big : std::endian::little;
+    // AArch64 follows the generic Itanium ABI, only the 32-bit ARM tags its Thumb functions
+    const Ref<BinaryNinja::Architecture> arch = _view->GetDefaultArchitecture();
+    const std::string name = arch ? arch->GetName() : "";
+    if (abi.pointerSize == 4 && (name.starts_with("arm") || name.starts_with("thumb")))
+        abi.variant = CxxAbi::ARM;
+    return abi;
+}
+
+}  // namespace skald
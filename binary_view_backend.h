@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "backend.h"
+#include "binaryninjaapi.h"
+
+namespace skald {
+
+// Backend answering the queries through an opened Binary Ninja BinaryView
+class BinaryViewBackend : public Backend {
+   public:
+    BinaryViewBackend(BinaryNinja::BinaryView *view);
+    ~BinaryViewBackend() override;
+
+    std::vector<Section> getSections() override;
+    std::vector<Section> getSegments() override;
+    RelocationTable getRelocations() override;
+    size_t read(void *dest, address_t address, size_t len) override;
+    bool isValidOffset(address_t address) override;
+    bool isOffsetReadable(address_t address) override;
+    bool isOffsetExecutable(address_t address) override;
+    std::optional<Section> getSectionAt(address_t address) override;
+    uint64_t getGeneration() override { return this->generation; }
+    Abi getAbi() override;
+
+   private:
+    class WriteListener;
+
+    BinaryNinja::BinaryView *_view;
+    std::atomic<uint64_t> generation = 0;
+    std::unique_ptr<WriteListener> listener;  // Bumps the generation on every write
+
+    Section toSection(const BinaryNinja::Ref<BinaryNinja::Section> &section);
+};
+
+}  // namespace skald
@@ -0,0 +1,185 @@
+#include "binary_view_code_source.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <vector>
+
+#include "binaryninjaapi.h"
+#include "instrumentation.h"
+#include "layout_recovery.h"
+#include "mediumlevelilinstruction.h"
+
+namespace skald {
+
+using BinaryNinja::MediumLevelILFunction;
+using BinaryNinja::MediumLevelILInstruction;
+using BinaryNinja::Ref;
+using BinaryNinja::Variable;
+
+namespace {
+
+// Variables pointing inside the object, with their offset
+typedef std::map<Variable, int64_t> pointers_t;
+
+// Offset in the object of the address computed by `expr`, nullopt if it is not in the object
+std::optional<int64_t> getObjectOffset(const MediumLevelILInstruction &expr,
+                                       const pointers_t &pointers) {
+    switch (expr.operation) {
+        case MLIL_VAR: {
+            auto it = pointers.find(expr.GetSourceVariable<MLIL_VAR>());
+            if (it == pointers.end()) return std::nullopt;
+            return it->second;
+        }
+        case MLIL_ADD: {
+            const MediumLevelILInstruction right = expr.GetRightExpr<MLIL_ADD>();
+            if (right.operation != MLIL_CONST) return std::nullopt;
+            const auto base = getObjectOffset(expr.GetLeftExpr<MLIL_ADD>(), pointers);
+            if (!base) return std::nullopt;
+            return *base + right.GetConstant<MLIL_CONST>();
+        }
+        case MLIL_SUB: {
+            const MediumLevelILInstruction right = expr.GetRightExpr<MLIL_SUB>();
+            if (right.operation != MLIL_CONST) return std::nullopt;
+            const auto base = getObjectOffset(expr.GetLeftExpr<MLIL_SUB>(), pointers);
+            if (!base) return std::nullopt;
+            return *base - right.GetConstant<MLIL_CONST>();
+        }
+        default:
+            return std::nullopt;
+    }
+}
+
+// Offset in the object of the vptr held by `expr`: a variable loaded from the object, or the load
+// itself. nullopt if it does not hold one
+std::optional<int64_t> getVptrOffset(const MediumLevelILInstruction &expr,
+                                     const pointers_t &pointers, const pointers_t &vptrs) {
+    if (expr.operation == MLIL_LOAD)
+        return getObjectOffset(expr.GetSourceExpr<MLIL_LOAD>(), pointers);
+    if (expr.operation != MLIL_VAR) return std::nullopt;
+    auto it = vptrs.find(expr.GetSourceVariable<MLIL_VAR>());
+    if (it == vptrs.end()) return std::nullopt;
+    return it->second;
+}
+
+// Call through the function pointer at a constant offset from a vptr of the object
+std::optional<VirtualCall> getVirtualCall(const MediumLevelILInstruction &call,
+                                          const MediumLevelILInstruction &dest,
+                                          const pointers_t &pointers, const pointers_t &vptrs) {
+    if (dest.operation != MLIL_LOAD) return std::nullopt;
+    MediumLevelILInstruction vptr = dest.GetSourceExpr<MLIL_LOAD>();
+    int64_t slot = 0;
+    if (vptr.operation == MLIL_ADD && vptr.GetRightExpr<MLIL_ADD>().operation == MLIL_CONST) {
+        slot = vptr.GetRightExpr<MLIL_ADD>().GetConstant<MLIL_CONST>();
+        vptr = vptr.GetLeftExpr<MLIL_ADD>();
+    }
+    const auto object = getVptrOffset(vptr, pointers, vptrs);
+    if (!object) return std::nullopt;
+    return VirtualCall{call.address, *object, slot};
+}
+
+std::optional<address_t> getConstant(const MediumLevelILInstruction &expr) {
+    if (expr.operation == MLIL_CONST_PTR) return expr.GetConstant<MLIL_CONST_PTR>();
+    if (expr.operation == MLIL_CONST) return expr.GetConstant<MLIL_CONST>();
+    return std::nullopt;
+}
+
+// Record the access `expr` makes to the object, if any
+void summarizeExpr(const MediumLevelILInstruction &expr, const pointers_t &pointers,
+                   const pointers_t &vptrs, FunctionSummary &summary) {
+    std::optional<int64_t> offset;
+    switch (expr.operation) {
+        case MLIL_LOAD:
+            offset = getObjectOffset(expr.GetSourceExpr<MLIL_LOAD>(), pointers);
+            break;
+        case MLIL_LOAD_STRUCT:
+            offset = getObjectOffset(expr.GetSourceExpr<MLIL_LOAD_STRUCT>(), pointers);
+            if (offset) *offset += expr.GetOffset<MLIL_LOAD_STRUCT>();
+            break;
+        case MLIL_STORE:
+            offset = getObjectOffset(expr.GetDestExpr<MLIL_STORE>(), pointers);
+            if (auto value = getConstant(expr.GetSourceExpr<MLIL_STORE>()); offset && value)
+                summary.constantStores.emplace_back(*offset, *value);
+            break;
+        case MLIL_STORE_STRUCT:
+            offset = getObjectOffset(expr.GetDestExpr<MLIL_STORE_STRUCT>(), pointers);
+            if (!offset) break;
+            *offset += expr.GetOffset<MLIL_STORE_STRUCT>();
+            if (auto value = getConstant(expr.GetSourceExpr<MLIL_STORE_STRUCT>()))
+                summary.constantStores.emplace_back(*offset, *value);
+            break;
+        case MLIL_CALL:
+        case MLIL_TAILCALL: {
+            const MediumLevelILInstruction dest = expr.operation == MLIL_CALL
+                                                      ? expr.GetDestExpr<MLIL_CALL>()
+                                                      : expr.GetDestExpr<MLIL_TAILCALL>();
+            if (auto call = getVirtualCall(expr, dest, pointers, vptrs))
+                summary.virtualCalls.push_back(*call);
+            const auto target = getConstant(dest);
+            const auto params = expr.operation == MLIL_CALL
+                                    ? expr.GetParameterExprs<MLIL_CALL>()
+                                    : expr.GetParameterExprs<MLIL_TAILCALL>();
+            if (!target || params.size() == 0) return;
+            if (const auto object = getObjectOffset(*params.begin(), pointers))
+                summary.calls.emplace_back(*target, *object);
+            return;
+        }
+        default:
+            return;
+    }
+    if (offset) summary.accesses.push_back({*offset, static_cast<uint32_t>(expr.size)});
+}
+
+}  // namespace
+
+std::vector<address_t> BinaryViewCodeSource::getReferencingFunctions(address_t address) {
+    SKALD_COUNT(GET_CODE_REFERENCES, 1);
+    std::vector<address_t> functions;
+    for (const BinaryNinja::ReferenceSource &reference : _view->GetCodeReferences(address))
+        if (reference.func) functions.push_back(reference.func->GetStart());
+    std::ranges::sort(functions);
+    functions.erase(std::ranges::unique(functions).begin(), functions.end());
+    return functions;
+}
+
+std::optional<FunctionSummary> BinaryViewCodeSource::summarize(address_t function) {
+    Ref<BinaryNinja::Function> func =
+        _view->GetAnalysisFunction(_view->GetDefaultPlatform(), function);
+    if (!func) return std::nullopt;
+    SKALD_COUNT(GET_IL, 1);
+    Ref<MediumLevelILFunction> il = func->GetMediumLevelIL();
+    const std::vector<Variable> params = func->GetParameterVariables().GetValue();
+    if (!il || params.empty()) return std::nullopt;
+
+    // Constructors are short and mostly linear, a single pass in instruction order is enough
+    FunctionSummary summary;
+    pointers_t pointers{{params[0], 0}};
+    pointers_t vptrs;  // Variables loaded from the object, with the offset of the load
+    for (size_t i = 0; i < il->GetInstructionCount(); ++i) {
+        const MediumLevelILInstruction instr = il->GetInstruction(i);
+        instr.VisitExprs([&](const MediumLevelILInstruction &expr) {
+            summarizeExpr(expr, pointers, vptrs, summary);
+            return true;
+        });
+        if (instr.operation != MLIL_SET_VAR) continue;
+
+        const Variable dest = instr.GetDestVariable<MLIL_SET_VAR>();
+        const MediumLevelILInstruction source = instr.GetSourceExpr<MLIL_SET_VAR>();
+        const auto vptr = source.operation == MLIL_LOAD
+                              ? getObjectOffset(source.GetSourceExpr<MLIL_LOAD>(), pointers)
+                              : std::nullopt;
+        if (vptr)
+            vptrs[dest] = *vptr;
+        else
+            vptrs.erase(dest);
+        if (auto offset = getObjectOffset(source, pointers))
+            pointers[dest] = *offset;
+        else
+            pointers.erase(dest);
+    }
+    return summary;
+}
+
+}  // namespace skald
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <optional>
+#include <vector>
+
+#include "binaryninjaapi.h"
+#include "layout_recovery.h"
+#include "types.h"
+
+namespace skald {
+
+// Summaries of the functions of an opened Binary Ninja BinaryView, from their Medium Level IL. The
+// object is the first parameter, the variables assigned from it plus a constant are followed in
+// instruction order, as well as the vptrs loaded from it for the virtual calls
+class BinaryViewCodeSource : public CodeSource {
+   public:
+    BinaryViewCodeSource(BinaryNinja::BinaryView *view) : _view(view) {}
+
+    std::vector<address_t> getReferencingFunctions(address_t address) override;
+    std::optional<FunctionSummary> summarize(address_t function) override;
+
+   private:
+    BinaryNinja::BinaryView *_view;
+};
+
+}  // namespace skald
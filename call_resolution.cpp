@@ -0,0 +1,262 @@
+#include "call_resolution.h"
+
+#include <algorithm>
+#include <bit>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "compact_graph.h"
+#include "instrumentation.h"
+#include "log.h"
+#include "records.h"
+#include "skald.h"
+
+namespace skald {
+
+namespace {
+
+// Number of functions summarized between two checkpoints
+constexpr size_t FUNCTION_BATCH_SIZE = 256;
+
+// Slot of a class queried by a call
+struct Query {
+    size_t slot;
+    class_id_t id;
+    size_t call;  // Index in the calls being resolved
+
+    auto operator<=>(const Query &other) const = default;
+};
+
+// Functions of a slot, as their indexes in the sorted functions found at that slot. Most classes
+// only see a few of them: the sorted indexes are kept until the bitset is the smaller of the two
+class SlotSet {
+   public:
+    bool empty() const { return this->ids.empty() && this->bits.empty(); }
+
+    // `universe` is the number of functions at the slot
+    void add(uint32_t id, size_t universe) { this->merge(std::span(&id, 1), universe); }
+    void merge(const SlotSet &other, size_t universe) {
+        if (other.bits.empty()) return this->merge(std::span(other.ids), universe);
+        this->toBitset(universe);
+        for (size_t i = 0; i < this->bits.size(); ++i) this->bits[i] |= other.bits[i];
+    }
+
+    // Calls `f` on each index, in increasing order
+    template <typename F>
+    void forEach(F &&f) const {
+        for (uint32_t id : this->ids) f(id);
+        for (size_t i = 0; i < this->bits.size(); ++i)
+            for (uint64_t word = this->bits[i]; word; word &= word - 1)
+                f(static_cast<uint32_t>(i * 64 + std::countr_zero(word)));
+    }
+
+    void clear() {
+        std::vector<uint32_t>().swap(this->ids);
+        std::vector<uint64_t>().swap(this->bits);
+    }
+
+   private:
+    std::vector<uint32_t> ids;  // Sorted, empty once `bits` is used
+    std::vector<uint64_t> bits;
+
+    void merge(std::span<const uint32_t> other, size_t universe) {
+        if (!this->bits.empty()) {
+            for (uint32_t id : other) this->bits[id / 64] |= uint64_t{1} << (id % 64);
+            return;
+        }
+        std::vector<uint32_t> merged;
+        merged.reserve(this->ids.size() + other.size());
+        std::ranges::set_union(this->ids, other, std::back_inserter(merged));
+        this->ids = std::move(merged);
+        if (this->ids.size() * 32 >= universe) this->toBitset(universe);
+    }
+
+    void toBitset(size_t universe) {
+        if (!this->bits.empty()) return;
+        this->bits.assign((universe + 63) / 64, 0);
+        for (uint32_t id : this->ids) this->bits[id / 64] |= uint64_t{1} << (id % 64);
+        std::vector<uint32_t>().swap(this->ids);
+    }
+};
+
+// Class of the subobject at `offset` in an object of class `id`, following the non-virtual bases.
+// NO_CLASS if there is none
+class_id_t getSubobject(const CompactGraph &graph, class_id_t id, int64_t offset) {
+    while (offset != 0) {
+        const CompactEdge *base = nullptr;
+        for (const CompactEdge &edge : graph.getChildren(id)) {
+            if (!(edge.flags & EdgeFlag::VIRTUAL) && edge.offset <= offset &&
+                (!base || edge.offset > base->offset))
+                base = &edge;
+        }
+        if (!base) return NO_CLASS;
+        id = base->target;
+        offset -= base->offset;
+    }
+    return id;
+}
+
+}  // namespace
+
+void CallResolution::run(const Skald &skald) {
+    SKALD_TIMED_SCOPE("call resolution");
+    const CompactGraph &graph = skald.getInheritanceGraph();
+    const int64_t pointerSize = skald.getAbi().pointerSize;
+    this->calls.clear();
+
+    // Class of the subobject using each vtable. The construction vtables are left out, they are
+    // only used while the object is being built
+    std::unordered_map<std::string_view, class_id_t> ids;
+    for (class_id_t id = 0; id < graph.size(); ++id)
+        if (!graph.getName(id).empty()) ids.emplace(graph.getName(id), id);
+    std::vector<std::pair<const VtableRecord *, class_id_t>> vtables;
+    std::vector<size_t> slotCounts(graph.size(), 0);
+    size_t slotCount = 0;
+    for (const VtableRecord &vtable : skald.getVtables()) {
+        class_id_t id = NO_CLASS;
+        if (vtable.kind == VtableKind::PRIMARY) {
+            id = graph.find(vtable.rttiAddress);
+        } else if (vtable.kind == VtableKind::SECONDARY) {
+            auto it = ids.find(vtable.subobject);
+            if (it != ids.end()) id = it->second;
+        }
+        if (id == NO_CLASS) continue;
+        vtables.emplace_back(&vtable, id);
+        slotCounts[id] = std::max(slotCounts[id], vtable.functions.size());
+        slotCount = std::max(slotCount, vtable.functions.size());
+    }
+
+    // The vtable of a subobject is also the one of its primary base, its first dynamic
+    // non-virtual base, at offset 0
+    std::vector<class_id_t> primaryBases(graph.size(), NO_CLASS);
+    for (class_id_t id = 0; id < graph.size(); ++id) {
+        for (const CompactEdge &edge : graph.getChildren(id)) {
+            if (!(edge.flags & EdgeFlag::VIRTUAL) && edge.offset == 0 && slotCounts[edge.target]) {
+                primaryBases[id] = edge.target;
+                break;
+            }
+        }
+    }
+
+    // `this` in a function of a vtable points to a subobject using that vtable
+    std::vector<std::pair<address_t, class_id_t>> methods;
+    std::vector<std::vector<std::pair<class_id_t, address_t>>> slots(slotCount);
+    for (const auto &[vtable, id] : vtables) {
+        for (size_t slot = 0; slot < vtable->functions.size(); ++slot) {
+            const address_t function = vtable->functions[slot];
+            if (function == 0) continue;
+            methods.emplace_back(function, id);
+            slots[slot].emplace_back(id, function);
+        }
+    }
+    std::ranges::sort(methods);
+    methods.erase(std::ranges::unique(methods).begin(), methods.end());
+    std::vector<address_t> functions;
+    for (const auto &[function, id] : methods)
+        if (functions.empty() || functions.back() != function) functions.push_back(function);
+
+    // Independent from each other, and by far the most expensive part
+    std::vector<std::vector<VirtualCall>> virtualCalls(functions.size());
+    for (size_t start = 0; start < functions.size(); start += FUNCTION_BATCH_SIZE) {
+        this->checkpoint(start, functions.size());
+        SKALD_TIMED_SCOPE("function summary");
+        const size_t count = std::min(FUNCTION_BATCH_SIZE, functions.size() - start);
+        this->pool.parallelFor(count, [&](size_t i) {
+            if (auto summary = this->code.summarize(functions[start + i]))
+                virtualCalls[start + i] = std::move(summary->virtualCalls);
+        });
+    }
+    this->checkpoint(functions.size(), functions.size());
+
+    // A call queries its slot in the subobject it goes through, for each class the function is a
+    // method of
+    std::vector<ResolvedCall> pending;
+    std::vector<Query> queries;
+    auto method = methods.begin();
+    for (size_t i = 0; i < functions.size(); ++i) {
+        const auto first = method;
+        while (method != methods.end() && method->first == functions[i]) ++method;
+        for (const VirtualCall &call : virtualCalls[i]) {
+            if (call.slot < 0 || call.slot % pointerSize != 0) continue;
+            const auto slot = static_cast<size_t>(call.slot / pointerSize);
+            const size_t count = queries.size();
+            for (auto it = first; it != method; ++it) {
+                const class_id_t id = getSubobject(graph, it->second, call.object);
+                if (id != NO_CLASS && slot < slotCounts[id])
+                    queries.push_back({slot, id, pending.size()});
+            }
+            if (queries.size() != count) pending.push_back({functions[i], call.site, {}});
+        }
+    }
+    std::ranges::sort(queries);
+
+    // Each slot is swept on its own, from the derived classes to the bases: the set of a class is
+    // complete once all the classes deriving from it have been reached
+    std::vector<std::vector<address_t>> answers(queries.size());  // At the first query of a class
+    const auto order = graph.getTopologicalOrder();
+    SKALD_TIMED_SCOPE("slot sweep");
+    this->pool.parallelFor(slotCount, [&](size_t slot) {
+        const auto first = std::ranges::lower_bound(queries, slot, {}, &Query::slot);
+        const auto last = std::ranges::upper_bound(queries, slot, {}, &Query::slot);
+        if (first == last) return;
+
+        std::vector<address_t> universe;
+        for (const auto &[id, function] : slots[slot]) universe.push_back(function);
+        std::ranges::sort(universe);
+        universe.erase(std::ranges::unique(universe).begin(), universe.end());
+
+        std::vector<SlotSet> sets(graph.size());
+        for (const auto &[id, function] : slots[slot])
+            sets[id].add(std::ranges::lower_bound(universe, function) - universe.begin(),
+                         universe.size());
+        std::vector<bool> queried(graph.size(), false);
+        for (auto it = first; it != last; ++it) queried[it->id] = true;
+
+        for (class_id_t id : order) {
+            SlotSet &set = sets[id];
+            if (set.empty()) continue;
+            if (queried[id]) {
+                const auto query = std::ranges::lower_bound(first, last, id, {}, &Query::id);
+                std::vector<address_t> &targets = answers[query - queries.begin()];
+                set.forEach([&](uint32_t index) { targets.push_back(universe[index]); });
+            }
+            const class_id_t base = primaryBases[id];
+            if (base != NO_CLASS && slot < slotCounts[base]) sets[base].merge(set, universe.size());
+            set.clear();
+        }
+    });
+
+    // A call gets the targets of all its queries
+    for (size_t i = 0, first = 0; i < queries.size(); ++i) {
+        if (queries[i].slot != queries[first].slot || queries[i].id != queries[first].id) first = i;
+        std::vector<address_t> &targets = pending[queries[i].call].targets;
+        targets.insert(targets.end(), answers[first].begin(), answers[first].end());
+    }
+    size_t targetCount = 0;
+    for (ResolvedCall &call : pending) {
+        std::ranges::sort(call.targets);
+        call.targets.erase(std::ranges::unique(call.targets).begin(), call.targets.end());
+        if (call.targets.empty()) continue;
+        targetCount += call.targets.size();
+        this->calls.push_back(std::move(call));
+    }
+    std::ranges::sort(this->calls, {}, &ResolvedCall::site);
+
+    logInfo("Resolved {} virtual calls made by {} functions, {} targets", this->calls.size(),
+            functions.size(), targetCount);
+}
+
+void CallResolution::checkpoint(size_t done, size_t total) {
+    if (!this->observer) return;
+    if (this->observer->isCancelled()) throw RunCancelled();
+    this->observer->progress(Phase::CALLS, done, total);
+}
+
+}  // namespace skald
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "layout_recovery.h"
+#include "run_observer.h"
+#include "thread_pool.h"
+#include "types.h"
+
+namespace skald {
+
+class Skald;
+
+// Virtual call with the functions it can dispatch to
+struct ResolvedCall {
+    address_t caller;  // Start of the function making the call
+    address_t site;
+    std::vector<address_t> targets;  // Sorted
+};
+
+// Resolves the virtual calls made on `this` by the functions of the vtables, by class hierarchy
+// analysis. A slot of a class can dispatch to the functions at the same slot in every vtable used
+// by a subobject of that class, in the classes deriving from it. Those sets are computed for all
+// the classes at once, in a single sweep of the inheritance graph from the derived classes to
+// the bases, each class passing its set to its primary base. The sets are bitsets over the
+// functions found at the slot, so that the cost grows with the hierarchy and not with the number
+// of calls
+class CallResolution {
+   public:
+    CallResolution(CodeSource &code, ThreadPool &pool) : code(code), pool(pool) {}
+
+    // `observer` must outlive the runs, nullptr to remove it
+    void setObserver(RunObserver *observer) { this->observer = observer; }
+
+    // Throws RunCancelled if the observer cancels the run
+    void run(const Skald &skald);
+
+    // Calls having at least one target, sorted by site
+    const std::vector<ResolvedCall> &getCalls() const { return this->calls; }
+
+   private:
+    CodeSource &code;
+    ThreadPool &pool;
+    RunObserver *observer = nullptr;
+    std::vector<ResolvedCall> calls;
+
+    // Reports the progress to the observer, throws RunCancelled if it was cancelled
+    void checkpoint(size_t done, size_t total);
+};
+
+}  // namespace skald
@@ -0,0 +1,154 @@
+#include "compact_graph.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "inheritance_graph.h"
+#include "spill_file.h"
+
+namespace skald {
+
+namespace {
+
+// In-order walk of the implicit tree rooted at `k`, it assigns the sorted values to the nodes
+size_t fillEytzinger(const std::vector<address_t> &sorted, std::vector<address_t> &eytzinger,
+                     std::vector<class_id_t> &ids, size_t i, size_t k) {
+    if (k >= eytzinger.size()) return i;
+    i = fillEytzinger(sorted, eytzinger, ids, i, 2 * k);
+    eytzinger[k] = sorted[i];
+    ids[k] = i++;
+    return fillEytzinger(sorted, eytzinger, ids, i, 2 * k + 1);
+}
+
+}  // namespace
+
+CompactGraph::CompactGraph(const InheritanceGraph &graph) {
+    const std::vector<Node> &nodes = graph.getNodes();
+    std::vector<ClassBase> bases;
+    for (const Node &node : nodes) {
+        for (size_t j = 0; j < node.children.size(); ++j) {
+            const int64_t offset = j < node.childOffsets.size() ? node.childOffsets[j] : 0;
+            bases.push_back({node.children[j].first, node.children[j].second, offset});
+        }
+    }
+
+    std::vector<ClassEntry> classes;
+    classes.reserve(nodes.size());
+    size_t first = 0;
+    for (const Node &node : nodes) {
+        classes.push_back({node.rttiAddress, node.name,
+                           std::span(bases).subspan(first, node.children.size())});
+        first += node.children.size();
+    }
+    *this = CompactGraph(classes);
+}
+
+CompactGraph::CompactGraph(std::span<const ClassEntry> classes,
+                           std::shared_ptr<const SpillFile> storage)
+    : storage(std::move(storage)) {
+    // Dense ids follow the address order, the bases without an entry included
+    for (const ClassEntry &entry : classes) {
+        this->addresses.push_back(entry.address);
+        for (const ClassBase &base : entry.bases) this->addresses.push_back(base.address);
+    }
+    std::ranges::sort(this->addresses);
+    this->addresses.erase(std::ranges::unique(this->addresses).begin(), this->addresses.end());
+    this->addresses.shrink_to_fit();
+    const size_t count = this->addresses.size();
+
+    this->eytzinger.resize(count + 1);
+    this->eytzingerIds.resize(count + 1, NO_CLASS);
+    fillEytzinger(this->addresses, this->eytzinger, this->eytzingerIds, 0, 1);
+
+    std::vector<const ClassEntry *> entries(count, nullptr);
+    for (const ClassEntry &entry : classes) entries[this->find(entry.address)] = &entry;
+
+    // The names already in the storage are referenced in place, the others are copied and the
+    // identical ones share the same copy
+    const std::string_view arena = this->getArena();
+    std::unordered_map<std::string_view, std::pair<uint64_t, uint32_t>> interned;
+    if (!this->storage) {
+        size_t arenaSize = 0;
+        for (const ClassEntry &entry : classes) arenaSize += entry.name.size();
+        this->nameArena.reserve(arenaSize);
+    }
+    this->names.reserve(count);
+    for (const ClassEntry *entry : entries) {
+        const std::string_view name = entry ? entry->name : std::string_view();
+        if (this->storage) {
+            this->names.emplace_back(name.empty() ? 0 : name.data() - arena.data(), name.size());
+            continue;
+        }
+        auto [it, inserted] = interned.try_emplace(name);
+        if (inserted) {
+            it->second = {this->nameArena.size(), static_cast<uint32_t>(name.size())};
+            this->nameArena += name;
+        }
+        this->names.push_back(it->second);
+    }
+
+    // Children in the order of the `__base_info` entries, the parents follow the ids
+    this->childOffsets.reserve(count + 1);
+    this->childOffsets.push_back(0);
+    std::vector<uint32_t> parentCounts(count + 1, 0);
+    for (const ClassEntry *entry : entries) {
+        for (const ClassBase &base : entry ? entry->bases : std::span<const ClassBase>()) {
+            const class_id_t target = this->find(base.address);
+            this->childEdges.push_back({target, base.flags, base.offset});
+            ++parentCounts[target + 1];
+        }
+        this->childOffsets.push_back(this->childEdges.size());
+    }
+
+    this->parentOffsets.resize(count + 1);
+    for (size_t i = 0; i < count; ++i)
+        this->parentOffsets[i + 1] = this->parentOffsets[i] + parentCounts[i + 1];
+    this->parentEdges.resize(this->childEdges.size());
+    std::vector<uint32_t> next(this->parentOffsets.begin(), this->parentOffsets.end() - 1);
+    for (class_id_t id = 0; id < count; ++id)
+        for (const CompactEdge &edge : this->getChildren(id))
+            this->parentEdges[next[edge.target]++] = {id, edge.flags, edge.offset};
+
+    // Kahn's algorithm from the roots, a class is visited once all its parents have been
+    std::vector<uint32_t> remaining(count);
+    for (class_id_t id = 0; id < count; ++id) {
+        remaining[id] = this->getParents(id).size();
+        if (remaining[id] == 0) this->order.push_back(id);
+    }
+    for (size_t i = 0; i < this->order.size(); ++i)
+        for (const CompactEdge &edge : this->getChildren(this->order[i]))
+            if (--remaining[edge.target] == 0) this->order.push_back(edge.target);
+
+    // The level of a class is one more than the deepest of its parents
+    std::vector<uint32_t> levels(count, 0);
+    uint32_t levelCount = this->order.empty() ? 0 : 1;
+    for (class_id_t id : this->order) {
+        for (const CompactEdge &edge : this->getParents(id))
+            levels[id] = std::max(levels[id], levels[edge.target] + 1);
+        levelCount = std::max(levelCount, levels[id] + 1);
+    }
+    std::ranges::stable_sort(this->order, {}, [&](class_id_t id) { return levels[id]; });
+
+    this->levelOffsets.resize(levelCount + 1, 0);
+    for (class_id_t id : this->order) ++this->levelOffsets[levels[id] + 1];
+    for (size_t i = 0; i < levelCount; ++i) this->levelOffsets[i + 1] += this->levelOffsets[i];
+}
+
+class_id_t CompactGraph::find(address_t address) const {
+    // Lower bound, then undo the right turns taken after the last left one
+    size_t k = 1;
+    while (k < this->eytzinger.size()) k = 2 * k + (this->eytzinger[k] < address);
+    k >>= std::countr_one(k) + 1;
+    return k != 0 && this->eytzinger[k] == address ? this->eytzingerIds[k] : NO_CLASS;
+}
+
+}  // namespace skald
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "inheritance_graph.h"
+#include "spill_file.h"
+#include "types.h"
+
+namespace skald {
+
+typedef uint32_t class_id_t;  // Dense identifier, the rank of the type_info address
+constexpr class_id_t NO_CLASS = UINT32_MAX;
+
+struct CompactEdge {
+    class_id_t target;
+    EdgeFlag flags;
+    int64_t offset;  // Of the base, as in `TypeInfoRecord::baseOffsets`
+};
+
+// Base of a class, as read from its type_info
+struct ClassBase {
+    address_t address;
+    EdgeFlag flags;
+    int64_t offset;  // As in `TypeInfoRecord::baseOffsets`
+};
+
+// Class as read from its type_info, the input of CompactGraph
+struct ClassEntry {
+    address_t address;
+    std::string_view name;
+    std::span<const ClassBase> bases;
+};
+
+// Frozen copy of an InheritanceGraph, built once all the classes are known. The edges are stored
+// in compressed sparse rows and the names interned in a single arena, the ids are dense so that
+// any per class data can live in a plain vector.
+// As in InheritanceGraph the children of a class are its bases and the parents the derived classes
+class CompactGraph {
+   public:
+    CompactGraph() = default;
+    explicit CompactGraph(const InheritanceGraph &graph);
+    // The bases without an entry get one with an empty name. If `storage` is given the names of
+    // the entries lie in its mapping, they are referenced from there instead of being copied
+    explicit CompactGraph(std::span<const ClassEntry> classes,
+                          std::shared_ptr<const SpillFile> storage = nullptr);
+
+    size_t size() const { return this->addresses.size(); }
+
+    // Class of the type_info at `address`, NO_CLASS if there is none
+    class_id_t find(address_t address) const;
+
+    address_t getAddress(class_id_t id) const { return this->addresses[id]; }
+    std::string_view getName(class_id_t id) const {
+        const auto [offset, length] = this->names[id];
+        return this->getArena().substr(offset, length);
+    }
+    std::span<const CompactEdge> getChildren(class_id_t id) const {
+        return this->edgeRange(this->childEdges, this->childOffsets, id);
+    }
+    std::span<const CompactEdge> getParents(class_id_t id) const {
+        return this->edgeRange(this->parentEdges, this->parentOffsets, id);
+    }
+    bool isLeaf(class_id_t id) const { return this->getChildren(id).empty(); }
+
+    // Every class reachable from a root, each one after all its parents
+    std::span<const class_id_t> getTopologicalOrder() const { return this->order; }
+
+    // Classes at distance `level` from the furthest root. All the parents of a class sit in a
+    // lower level, so the classes of a level do not depend on each other
+    size_t getLevelCount() const { return this->levelOffsets.size() - 1; }
+    std::span<const class_id_t> getLevel(size_t level) const {
+        return std::span(this->order).subspan(
+            this->levelOffsets[level], this->levelOffsets[level + 1] - this->levelOffsets[level]);
+    }
+
+   private:
+    std::vector<address_t> addresses;  // Sorted, indexed by id
+
+    // `addresses` in Eytzinger layout (1-based) with the respective ids, searched by `find()`
+    std::vector<address_t> eytzinger;
+    std::vector<class_id_t> eytzingerIds;
+
+    std::string nameArena;
+    std::shared_ptr<const SpillFile> storage;  // Replaces `nameArena` when set
+    std::vector<std::pair<uint64_t, uint32_t>> names;  // Offset and length in the arena
+
+    // Edges of the class `i` are `edges[offsets[i]] ... edges[offsets[i + 1] - 1]`
+    std::vector<uint32_t> childOffsets;
+    std::vector<CompactEdge> childEdges;
+    std::vector<uint32_t> parentOffsets;
+    std::vector<CompactEdge> parentEdges;
+
+    std::vector<class_id_t> order;          // Grouped by level
+    std::vector<uint32_t> levelOffsets{0};  // Level `i` is `order[levelOffsets[i]] ...`
+
+    std::string_view getArena() const {
+        if (!this->storage) return this->nameArena;
+        const auto bytes = this->storage->data();
+        return {reinterpret_cast<const char *>(bytes.data()), bytes.size()};
+    }
+
+    static std::span<const CompactEdge> edgeRange(const std::vector<CompactEdge> &edges,
+                                                  const std::vector<uint32_t> &offsets,
+                                                  class_id_t id) {
+        return std::span(edges).subspan(offsets[id], offsets[id + 1] - offsets[id]);
+    }
+};
+
+}  // namespace skald
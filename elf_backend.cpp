@@ -0,0 +1,560 @@
+#include "elf_backend.h"
+
+#include <fcntl.h>
+#include <fmt/format.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "instrumentation.h"
+#include "log.h"
+
+namespace skald {
+
+namespace {
+
+// Subset of the ELF definitions (see `man 5 elf`). They are redefined here to not depend on
+// the system <elf.h>, which is not available everywhere the plugin is built
+struct Elf64Header {
+    std::array<uint8_t, 16> ident;
+    uint16_t type;
+    uint16_t machine;
+    uint32_t version;
+    uint64_t entry;
+    uint64_t phoff;
+    uint64_t shoff;
+    uint32_t flags;
+    uint16_t ehsize;
+    uint16_t phentsize;
+    uint16_t phnum;
+    uint16_t shentsize;
+    uint16_t shnum;
+    uint16_t shstrndx;
+};
+
+struct Elf64ProgramHeader {
+    uint32_t type;
+    uint32_t flags;
+    uint64_t offset;
+    uint64_t vaddr;
+    uint64_t paddr;
+    uint64_t filesz;
+    uint64_t memsz;
+    uint64_t align;
+};
+
+struct Elf64SectionHeader {
+    uint32_t name;
+    uint32_t type;
+    uint64_t flags;
+    uint64_t addr;
+    uint64_t offset;
+    uint64_t size;
+    uint32_t link;
+    uint32_t info;
+    uint64_t addralign;
+    uint64_t entsize;
+};
+
+struct Elf64Symbol {
+    uint32_t name;
+    uint8_t info;
+    uint8_t other;
+    uint16_t shndx;
+    uint64_t value;
+    uint64_t size;
+};
+
+struct Elf64Rela {
+    uint64_t offset;
+    uint64_t info;
+    int64_t addend;
+};
+
+struct Elf64Rel {
+    uint64_t offset;
+    uint64_t info;
+};
+
+// Same fields as the ELF64 ones, narrower and in another order for the program headers and the
+// symbols
+struct Elf32Header {
+    std::array<uint8_t, 16> ident;
+    uint16_t type;
+    uint16_t machine;
+    uint32_t version;
+    uint32_t entry;
+    uint32_t phoff;
+    uint32_t shoff;
+    uint32_t flags;
+    uint16_t ehsize;
+    uint16_t phentsize;
+    uint16_t phnum;
+    uint16_t shentsize;
+    uint16_t shnum;
+    uint16_t shstrndx;
+};
+
+struct Elf32ProgramHeader {
+    uint32_t type;
+    uint32_t offset;
+    uint32_t vaddr;
+    uint32_t paddr;
+    uint32_t filesz;
+    uint32_t memsz;
+    uint32_t flags;
+    uint32_t align;
+};
+
+struct Elf32SectionHeader {
+    uint32_t name;
+    uint32_t type;
+    uint32_t flags;
+    uint32_t addr;
+    uint32_t offset;
+    uint32_t size;
+    uint32_t link;
+    uint32_t info;
+    uint32_t addralign;
+    uint32_t entsize;
+};
+
+struct Elf32Symbol {
+    uint32_t name;
+    uint32_t value;
+    uint32_t size;
+    uint8_t info;
+    uint8_t other;
+    uint16_t shndx;
+};
+
+struct Elf32Rela {
+    uint32_t offset;
+    uint32_t info;
+    int32_t addend;
+};
+
+struct Elf32Rel {
+    uint32_t offset;
+    uint32_t info;
+};
+
+// Structures of an ELF class, the parsing is instantiated for both
+struct Elf64 {
+    typedef Elf64Header Header;
+    typedef Elf64ProgramHeader ProgramHeader;
+    typedef Elf64SectionHeader SectionHeader;
+    typedef Elf64Symbol Symbol;
+    typedef Elf64Rela Rela;
+    typedef Elf64Rel Rel;
+    typedef uint64_t word_t;
+
+    static uint32_t relocationType(uint64_t info) { return static_cast<uint32_t>(info); }
+    static uint32_t relocationSymbol(uint64_t info) { return static_cast<uint32_t>(info >> 32); }
+};
+
+struct Elf32 {
+    typedef Elf32Header Header;
+    typedef Elf32ProgramHeader ProgramHeader;
+    typedef Elf32SectionHeader SectionHeader;
+    typedef Elf32Symbol Symbol;
+    typedef Elf32Rela Rela;
+    typedef Elf32Rel Rel;
+    typedef uint32_t word_t;
+
+    static uint32_t relocationType(uint32_t info) { return info & 0xff; }
+    static uint32_t relocationSymbol(uint32_t info) { return info >> 8; }
+};
+
+constexpr std::array<uint8_t, 4> ELF_MAGIC = {0x7f, 'E', 'L', 'F'};
+constexpr uint8_t ELFCLASS32 = 1;
+constexpr uint8_t ELFCLASS64 = 2;
+constexpr uint8_t ELFDATA2LSB = 1;
+constexpr uint16_t ET_EXEC = 2;
+constexpr uint16_t ET_DYN = 3;
+constexpr uint16_t EM_386 = 3;
+constexpr uint16_t EM_ARM = 40;
+constexpr uint16_t EM_X86_64 = 62;
+constexpr uint16_t EM_AARCH64 = 183;
+
+constexpr uint32_t PT_LOAD = 1;
+constexpr uint32_t PF_X = 1;
+constexpr uint32_t PF_W = 2;
+constexpr uint32_t PF_R = 4;
+
+constexpr uint32_t SHT_SYMTAB = 2;
+constexpr uint32_t SHT_RELA = 4;
+constexpr uint32_t SHT_NOBITS = 8;
+constexpr uint32_t SHT_REL = 9;
+constexpr uint32_t SHT_DYNSYM = 11;
+constexpr uint64_t SHF_WRITE = 1;
+constexpr uint64_t SHF_ALLOC = 2;
+constexpr uint64_t SHF_EXECINSTR = 4;
+constexpr uint16_t SHN_UNDEF = 0;
+
+// How a relocation computes the patched value. S is the symbol address, A the addend
+enum class RelocationKind { NONE, ABSOLUTE /* S + A */, SYMBOL /* S */, RELATIVE /* A */ };
+
+RelocationKind classifyRelocation(uint16_t machine, uint32_t type) {
+    if (machine == EM_X86_64) {
+        switch (type) {
+            case 1:  // R_X86_64_64
+                return RelocationKind::ABSOLUTE;
+            case 6:  // R_X86_64_GLOB_DAT
+            case 7:  // R_X86_64_JUMP_SLOT
+                return RelocationKind::SYMBOL;
+            case 8:  // R_X86_64_RELATIVE
+                return RelocationKind::RELATIVE;
+        }
+    } else if (machine == EM_AARCH64) {
+        switch (type) {
+            case 257:  // R_AARCH64_ABS64
+                return RelocationKind::ABSOLUTE;
+            case 1025:  // R_AARCH64_GLOB_DAT
+            case 1026:  // R_AARCH64_JUMP_SLOT
+                return RelocationKind::SYMBOL;
+            case 1027:  // R_AARCH64_RELATIVE
+                return RelocationKind::RELATIVE;
+        }
+    } else if (machine == EM_386) {
+        switch (type) {
+            case 1:  // R_386_32
+                return RelocationKind::ABSOLUTE;
+            case 6:  // R_386_GLOB_DAT
+            case 7:  // R_386_JMP_SLOT
+                return RelocationKind::SYMBOL;
+            case 8:  // R_386_RELATIVE
+                return RelocationKind::RELATIVE;
+        }
+    } else if (machine == EM_ARM) {
+        switch (type) {
+            case 2:  // R_ARM_ABS32
+                return RelocationKind::ABSOLUTE;
+            case 21:  // R_ARM_GLOB_DAT
+            case 22:  // R_ARM_JUMP_SLOT
+                return RelocationKind::SYMBOL;
+            case 23:  // R_ARM_RELATIVE
+                return RelocationKind::RELATIVE;
+        }
+    }
+    return RelocationKind::NONE;
+}
+
+// Return a pointer to `count` objects of type T at `offset` in the file, checking the bounds
+template <typename T>
+const T *fileAt(const uint8_t *data, size_t size, uint64_t offset, uint64_t count = 1) {
+    if (offset > size || count > (size - offset) / sizeof(T))
+        throw std::runtime_error(fmt::format("Truncated ELF file (offset {:#x})", offset));
+    return reinterpret_cast<const T *>(data + offset);
+}
+
+template <typename SectionHeader>
+std::string_view stringAt(const uint8_t *data, size_t size, const SectionHeader &strtab,
+                          uint32_t index) {
+    if (index >= strtab.size || strtab.offset + strtab.size > size) return {};
+    const char *start = reinterpret_cast<const char *>(data + strtab.offset + index);
+    return {start, strnlen(start, strtab.size - index)};
+}
+
+}  // namespace
+
+ElfBackend::ElfBackend(const std::filesystem::path &path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error(fmt::format("Cannot open `{}`", path.string()));
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(Elf32Header))) {
+        close(fd);
+        throw std::runtime_error(fmt::format("`{}` is too small to be an ELF", path.string()));
+    }
+
+    // Private writable mapping: relocations are applied in place and only the touched pages are
+    // copied
+    this->size = st.st_size;
+    void *mapping = mmap(nullptr, this->size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+        throw std::runtime_error(fmt::format("Cannot map `{}`", path.string()));
+    this->data = static_cast<uint8_t *>(mapping);
+
+    try {
+        this->parse();
+    } catch (...) {
+        munmap(this->data, this->size);
+        throw;
+    }
+}
+
+ElfBackend::~ElfBackend() {
+    if (this->data) munmap(this->data, this->size);
+}
+
+bool ElfBackend::isElf(const std::filesystem::path &path) {
+    std::array<char, 4> magic{};
+    std::ifstream file(path, std::ios::binary);
+    if (!file.read(magic.data(), magic.size())) return false;
+    return std::equal(magic.begin(), magic.end(), ELF_MAGIC.begin());
+}
+
+void ElfBackend::parse() {
+    const auto &ident = fileAt<Elf32Header>(this->data, this->size, 0)->ident;
+    if (!std::equal(ELF_MAGIC.begin(), ELF_MAGIC.end(), ident.begin()))
+        throw std::runtime_error("Not an ELF file");
+    if (ident[5] != ELFDATA2LSB)
+        throw std::runtime_error("Only little endian ELF binaries are supported");
+    if (ident[4] == ELFCLASS64)
+        this->parseClass<Elf64>();
+    else if (ident[4] == ELFCLASS32)
+        this->parseClass<Elf32>();
+    else
+        throw std::runtime_error("Unknown ELF class");
+}
+
+template <typename Elf>
+void ElfBackend::parseClass() {
+    typedef typename Elf::word_t word_t;
+    typedef typename Elf::SectionHeader section_header_t;
+    typedef typename Elf::Symbol symbol_t;
+    constexpr size_t WORD_SIZE = sizeof(word_t);
+
+    const auto &header = *fileAt<typename Elf::Header>(this->data, this->size, 0);
+    if (header.type != ET_EXEC && header.type != ET_DYN)
+        throw std::runtime_error("Only executables and shared objects are supported");
+
+    this->abi.pointerSize = WORD_SIZE;
+    if (header.machine == EM_ARM) this->abi.variant = CxxAbi::ARM;
+
+    // Loadable segments
+    const auto *phdrs =
+        fileAt<typename Elf::ProgramHeader>(this->data, this->size, header.phoff, header.phnum);
+    for (uint16_t i = 0; i < header.phnum; ++i) {
+        const auto &phdr = phdrs[i];
+        if (phdr.type != PT_LOAD || phdr.memsz == 0) continue;
+        if (phdr.offset > this->size) continue;
+
+        SectionFlag flags{};
+        if (phdr.flags & PF_R) flags |= SectionFlag::READABLE;
+        if (phdr.flags & PF_W) flags |= SectionFlag::WRITABLE;
+        if (phdr.flags & PF_X) flags |= SectionFlag::EXECUTABLE;
+        this->segments.push_back({phdr.vaddr, phdr.vaddr + phdr.memsz, phdr.offset,
+                                  std::min<uint64_t>(phdr.filesz, this->size - phdr.offset),
+                                  flags});
+    }
+    std::ranges::sort(this->segments, {}, &Segment::start);
+    if (this->segments.empty()) throw std::runtime_error("No loadable segment");
+
+    // Sections. A stripped binary might not have them at all
+    if (header.shoff == 0 || header.shnum == 0) return;
+    const auto *shdrs =
+        fileAt<section_header_t>(this->data, this->size, header.shoff, header.shnum);
+    const section_header_t *shstrtab =
+        header.shstrndx < header.shnum ? &shdrs[header.shstrndx] : nullptr;
+
+    for (uint16_t i = 0; i < header.shnum; ++i) {
+        const auto &shdr = shdrs[i];
+        if (!(shdr.flags & SHF_ALLOC) || shdr.addr == 0 || shdr.size == 0) continue;
+
+        SectionFlag flags = SectionFlag::READABLE;
+        if (shdr.flags & SHF_WRITE) flags |= SectionFlag::WRITABLE;
+        if (shdr.flags & SHF_EXECINSTR) flags |= SectionFlag::EXECUTABLE;
+        std::string name =
+            shstrtab ? std::string(stringAt(this->data, this->size, *shstrtab, shdr.name)) : "";
+        this->sections.push_back({std::move(name), shdr.addr, shdr.addr + shdr.size, flags});
+    }
+    std::ranges::sort(this->sections, {}, &Section::start);
+
+    // Symbols, both defined and imported. Imported ones are given a synthetic address
+    const address_t externStart = (this->segments.back().end + 0xfff) & ~address_t{0xfff};
+    address_t externEnd = externStart;
+    std::unordered_map<std::string_view, address_t> externs;
+    std::unordered_map<std::string_view, uint32_t> relocationSymbols;  // Name to index in the table
+
+    // Resolve the address of symbol `index` of the symbol table in section `symtabIndex`
+    auto resolveSymbol = [&](uint32_t symtabIndex, uint32_t index,
+                             std::string_view &name) -> address_t {
+        name = {};
+        if (index == 0 || symtabIndex >= header.shnum) return 0;
+        const auto &symtab = shdrs[symtabIndex];
+        if (symtab.entsize != sizeof(symbol_t) || index >= symtab.size / sizeof(symbol_t))
+            return 0;
+        const auto &sym = *fileAt<symbol_t>(this->data, this->size,
+                                            symtab.offset + index * sizeof(symbol_t));
+        if (symtab.link < header.shnum)
+            name = stringAt(this->data, this->size, shdrs[symtab.link], sym.name);
+        if (sym.shndx != SHN_UNDEF) return sym.value;
+        if (name.empty()) return 0;
+
+        auto [it, inserted] = externs.try_emplace(name, externEnd);
+        if (inserted) externEnd += WORD_SIZE;
+        return it->second;
+    };
+
+    for (uint16_t i = 0; i < header.shnum; ++i) {
+        const auto &shdr = shdrs[i];
+        if (shdr.type == SHT_DYNSYM || shdr.type == SHT_SYMTAB) {
+            if (shdr.entsize != sizeof(symbol_t)) continue;
+            for (uint32_t j = 1; j < shdr.size / sizeof(symbol_t); ++j) {
+                std::string_view name;
+                address_t address = resolveSymbol(i, j, name);
+                if (address != 0 && !name.empty()) this->symbols.emplace_back(address, name);
+            }
+            continue;
+        }
+
+        if (shdr.type != SHT_RELA && shdr.type != SHT_REL) continue;
+        if (!(shdr.flags & SHF_ALLOC)) continue;  // Static relocations of an object file
+
+        const bool hasAddend = shdr.type == SHT_RELA;
+        const size_t entrySize = hasAddend ? sizeof(typename Elf::Rela) : sizeof(typename Elf::Rel);
+        const size_t count = shdr.size / entrySize;
+        fileAt<uint8_t>(this->data, this->size, shdr.offset, count * entrySize);
+
+        for (size_t j = 0; j < count; ++j) {
+            const uint8_t *entry = this->data + shdr.offset + j * entrySize;
+            typename Elf::Rela rel{};
+            std::memcpy(&rel, entry, entrySize);
+
+            const uint32_t type = Elf::relocationType(rel.info);
+            const uint32_t symIndex = Elf::relocationSymbol(rel.info);
+            std::string_view name;
+            const address_t symAddress = resolveSymbol(shdr.link, symIndex, name);
+
+            uint32_t symbol = NO_SYMBOL;
+            if (!name.empty()) {
+                auto [it, inserted] = relocationSymbols.try_emplace(
+                    name, static_cast<uint32_t>(this->relocations.symbols.size()));
+                if (inserted) this->relocations.symbols.emplace_back(name);
+                symbol = it->second;
+            }
+
+            // The addend of a REL relocation is the relocated word. The loader ignores it for the
+            // GOT and PLT entries, which only take the address of the symbol
+            const RelocationKind kind = classifyRelocation(header.machine, type);
+            uint8_t *place = this->translate(rel.offset, WORD_SIZE);
+            auto addend = rel.addend;
+            if (!hasAddend && place) std::memcpy(&addend, place, WORD_SIZE);
+            int64_t recorded = hasAddend || place ? int64_t{addend} : UNKNOWN_ADDEND;
+            if (kind == RelocationKind::SYMBOL) recorded = 0;
+            this->relocations.relocations.push_back({rel.offset, symbol, recorded});
+
+            // Patch the relocated word
+            if (kind == RelocationKind::NONE || !place) continue;
+            word_t value = 0;
+            switch (kind) {
+                case RelocationKind::ABSOLUTE:
+                    if (symAddress == 0) continue;
+                    value = symAddress + addend;
+                    break;
+                case RelocationKind::SYMBOL:
+                    if (symAddress == 0) continue;
+                    value = symAddress;
+                    break;
+                case RelocationKind::RELATIVE:
+                    value = addend;
+                    break;
+                default:
+                    continue;
+            }
+            std::memcpy(place, &value, WORD_SIZE);
+        }
+    }
+
+    if (externEnd != externStart)
+        this->sections.push_back({".extern", externStart, externEnd, SectionFlag{}});
+
+    std::ranges::sort(this->symbols);
+    logDebug("Loaded ELF with {} segments, {} sections, {} relocations and {} symbols",
+             this->segments.size(), this->sections.size(), this->relocations.relocations.size(),
+             this->symbols.size());
+}
+
+const ElfBackend::Segment *ElfBackend::findSegment(address_t address) const {
+    auto it = std::ranges::upper_bound(this->segments, address, {}, &Segment::start);
+    if (it == this->segments.begin()) return nullptr;
+    --it;
+    return address < it->end ? &*it : nullptr;
+}
+
+uint8_t *ElfBackend::translate(address_t address, size_t len) {
+    const Segment *segment = this->findSegment(address);
+    if (!segment) return nullptr;
+    const uint64_t offset = address - segment->start;
+    if (offset + len > segment->fileSize) return nullptr;  // Not backed by the file (.bss)
+    return this->data + segment->fileOffset + offset;
+}
+
+std::string_view ElfBackend::getSymbolAt(address_t address) const {
+    auto it = std::ranges::lower_bound(this->symbols, address, {},
+                                       &std::pair<address_t, std::string>::first);
+    if (it == this->symbols.end() || it->first != address) return {};
+    return it->second;
+}
+
+std::vector<Section> ElfBackend::getSections() { return this->sections; }
+
+std::vector<Section> ElfBackend::getSegments() {
+    std::vector<Section> ranges;
+    for (const Segment &segment : this->segments)
+        ranges.push_back({"", segment.start, segment.end, segment.flags});
+    return ranges;
+}
+
+RelocationTable ElfBackend::getRelocations() { return this->relocations; }
+
+size_t ElfBackend::read(void *dest, address_t address, size_t len) {
+    SKALD_COUNT(READ, 1);
+    SKALD_COUNT(BYTES_READ, len);
+    auto *out = static_cast<uint8_t *>(dest);
+    size_t done = 0;
+    while (done < len) {
+        const Segment *segment = this->findSegment(address + done);
+        if (!segment) break;
+
+        const uint64_t offset = address + done - segment->start;
+        const size_t chunk = std::min<uint64_t>(len - done, segment->end - (address + done));
+        // Bytes backed by the file, the remaining ones are zero initialized
+        const size_t fromFile =
+            offset < segment->fileSize ? std::min<uint64_t>(chunk, segment->fileSize - offset) : 0;
+        std::memcpy(out + done, this->data + segment->fileOffset + offset, fromFile);
+        std::memset(out + done + fromFile, 0, chunk - fromFile);
+        done += chunk;
+    }
+    return done;
+}
+
+bool ElfBackend::isValidOffset(address_t address) { return this->findSegment(address) != nullptr; }
+
+bool ElfBackend::isOffsetReadable(address_t address) {
+    const Segment *segment = this->findSegment(address);
+    return segment && segment->flags & SectionFlag::READABLE;
+}
+
+bool ElfBackend::isOffsetExecutable(address_t address) {
+    const Segment *segment = this->findSegment(address);
+    return segment && segment->flags & SectionFlag::EXECUTABLE;
+}
+
+std::optional<Section> ElfBackend::getSectionAt(address_t address) {
+    auto it = std::ranges::upper_bound(this->sections, address, {}, &Section::start);
+    if (it == this->sections.begin()) return std::nullopt;
+    --it;
+    if (address >= it->end) return std::nullopt;
+    return *it;
+}
+
+}  // namespace skald
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "backend.h"
+
+namespace skald {
+
+// Native backend for ELF32 and ELF64 little endian executables and shared objects. The file is
+// mapped privately in memory and the dynamic relocations are applied on the mapping, so that
+// reads return the same pointers that the loader would produce (with a load base of 0). Imported
+// symbols get a synthetic address past the end of the image, like Binary Ninja does with its
+// `.extern` section
+class ElfBackend : public Backend {
+   public:
+    explicit ElfBackend(const std::filesystem::path &path);
+    ~ElfBackend() override;
+
+    ElfBackend(const ElfBackend &) = delete;
+    ElfBackend &operator=(const ElfBackend &) = delete;
+
+    // Check the ELF magic without mapping the whole file
+    static bool isElf(const std::filesystem::path &path);
+
+    // Name of the dynamic symbol defined (or imported) at `address`. Empty if there is none
+    std::string_view getSymbolAt(address_t address) const;
+
+    std::vector<Section> getSections() override;
+    std::vector<Section> getSegments() override;
+    RelocationTable getRelocations() override;
+    size_t read(void *dest, address_t address, size_t len) override;
+    bool isValidOffset(address_t address) override;
+    bool isOffsetReadable(address_t address) override;
+    bool isOffsetExecutable(address_t address) override;
+    std::optional<Section> getSectionAt(address_t address) override;
+    Abi getAbi() override { return this->abi; }
+
+   private:
+    struct Segment {
+        address_t start;
+        address_t end;
+        uint64_t fileOffset;
+        uint64_t fileSize;
+        SectionFlag flags;
+    };
+
+    uint8_t *data = nullptr;
+    size_t size = 0;
+
+    std::vector<Segment> segments;   // Loadable segments sorted by address
+    std::vector<Section> sections;   // Allocated sections sorted by address
+    RelocationTable relocations;
+    std::vector<std::pair<address_t, std::string>> symbols;  // Sorted by address
+    Abi abi;
+
+    void parse();
+    // `Elf` holds the structures of the ELF class of the file
+    template <typename Elf>
+    void parseClass();
+    const Segment *findSegment(address_t address) const;
+    uint8_t *translate(address_t address, size_t len);
+};
+
+}  // namespace skald
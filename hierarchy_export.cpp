@@ -0,0 +1,308 @@
+#include "hierarchy_export.h"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "compact_graph.h"
+#include "mapped_file.h"
+#include "records.h"
+#include "skald.h"
+#include "type_name_decoder.h"
+
+namespace skald {
+
+namespace {
+
+constexpr uint64_t MAGIC = 0x524549484c4b53;  // "SKLHIER"
+constexpr uint32_t VERSION = 1;
+
+// The tables are written and mapped as is, without any padding
+static_assert(sizeof(HierarchyFile::Header) == 48 && sizeof(HierarchyFile::PackedClass) == 24 &&
+              sizeof(HierarchyFile::PackedEdge) == 16 && sizeof(HierarchyFile::PackedVtable) == 48);
+
+// Offsets of the tables following the header, all of them 8-byte aligned
+struct Sections {
+    uint64_t classes, edges, vtables, slots, text, end;
+
+    explicit Sections(const HierarchyFile::Header &header) {
+        this->classes = sizeof(HierarchyFile::Header);
+        this->edges = this->classes + sizeof(HierarchyFile::PackedClass) * header.classCount;
+        this->vtables = this->edges + sizeof(HierarchyFile::PackedEdge) * header.edgeCount;
+        this->slots = this->vtables + sizeof(HierarchyFile::PackedVtable) * header.vtableCount;
+        this->text = this->slots + sizeof(address_t) * header.slotCount;
+        this->end = this->text + header.textSize;
+    }
+};
+
+// Class of the subobject or of the owner of a vtable, from its mangled name
+class_id_t findClass(const std::unordered_map<std::string_view, class_id_t> &ids,
+                     std::string_view name) {
+    auto it = ids.find(name);
+    return it == ids.end() ? NO_CLASS : it->second;
+}
+
+std::unordered_map<std::string_view, class_id_t> classIds(const CompactGraph &graph) {
+    std::unordered_map<std::string_view, class_id_t> ids;
+    for (class_id_t id = 0; id < graph.size(); ++id)
+        if (!graph.getName(id).empty()) ids.emplace(graph.getName(id), id);
+    return ids;
+}
+
+std::string_view kindName(VtableKind kind) {
+    switch (kind) {
+        case VtableKind::PRIMARY:
+            return "primary";
+        case VtableKind::SECONDARY:
+            return "secondary";
+        case VtableKind::CONSTRUCTION:
+            return "construction";
+    }
+    return "unknown";
+}
+
+// Also used for the DOT labels, which follow the same rules for `"` and `\`
+std::string escape(std::string_view text) {
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            escaped += fmt::format("\\u{:04x}", c);
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+std::string jsonClass(class_id_t id) { return id == NO_CLASS ? "null" : fmt::format("{}", id); }
+
+void writeText(const std::filesystem::path &path, const std::string &text) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(text.data(), static_cast<std::streamsize>(text.size()));
+    if (!file.flush())
+        throw std::runtime_error(fmt::format("Cannot write the export `{}`", path.string()));
+}
+
+void writeBinary(const Skald &skald, const std::filesystem::path &path) {
+    if constexpr (std::endian::native != std::endian::little)
+        throw std::runtime_error("Binary exports are only supported on little endian hosts");
+
+    const CompactGraph &graph = skald.getInheritanceGraph();
+    std::vector<HierarchyFile::PackedClass> classes;
+    std::vector<HierarchyFile::PackedEdge> edges;
+    std::string text;
+    classes.reserve(graph.size());
+    for (class_id_t id = 0; id < graph.size(); ++id) {
+        const std::string_view name = graph.getName(id);
+        const std::span<const CompactEdge> bases = graph.getChildren(id);
+        classes.push_back({graph.getAddress(id), static_cast<uint32_t>(text.size()),
+                           static_cast<uint32_t>(name.size()), static_cast<uint32_t>(edges.size()),
+                           static_cast<uint32_t>(bases.size())});
+        text += name;
+        for (const CompactEdge &edge : bases)
+            edges.push_back({edge.target, edge.flags, edge.offset});
+    }
+
+    const auto ids = classIds(graph);
+    std::vector<HierarchyFile::PackedVtable> vtables;
+    std::vector<address_t> slots;
+    for (const VtableRecord &vtable : skald.getVtables()) {
+        vtables.push_back({vtable.address, vtable.offsetToTop, slots.size(),
+                           static_cast<uint32_t>(vtable.functions.size()),
+                           graph.find(vtable.rttiAddress), vtable.kind,
+                           findClass(ids, vtable.subobject), findClass(ids, vtable.owner), 0});
+        slots.insert(slots.end(), vtable.functions.begin(), vtable.functions.end());
+    }
+
+    const HierarchyFile::Header header{MAGIC,
+                                       VERSION,
+                                       skald.getAbi().pointerSize,
+                                       static_cast<uint32_t>(classes.size()),
+                                       static_cast<uint32_t>(edges.size()),
+                                       static_cast<uint32_t>(vtables.size()),
+                                       0,
+                                       slots.size(),
+                                       text.size()};
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    const auto put = [&](const void *data, size_t size) {
+        file.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+    };
+    put(&header, sizeof(header));
+    put(classes.data(), classes.size() * sizeof(HierarchyFile::PackedClass));
+    put(edges.data(), edges.size() * sizeof(HierarchyFile::PackedEdge));
+    put(vtables.data(), vtables.size() * sizeof(HierarchyFile::PackedVtable));
+    put(slots.data(), slots.size() * sizeof(address_t));
+    put(text.data(), text.size());
+    if (!file.flush())
+        throw std::runtime_error(fmt::format("Cannot write the export `{}`", path.string()));
+}
+
+// The addresses are strings, a 64-bit address does not fit the numbers of most JSON readers
+void writeJson(const Skald &skald, const std::filesystem::path &path, TypeNameDecoder *names) {
+    const CompactGraph &graph = skald.getInheritanceGraph();
+    std::string out;
+    auto it = std::back_inserter(out);
+    fmt::format_to(it, "{{\"version\":{},\"pointerSize\":{},\"classes\":[", VERSION,
+                   skald.getAbi().pointerSize);
+    for (class_id_t id = 0; id < graph.size(); ++id) {
+        const std::string_view name = graph.getName(id);
+        fmt::format_to(it, "{}\n{{\"id\":{},\"address\":\"{:#x}\",\"name\":\"{}\",\"bases\":[",
+                       id ? "," : "", id, graph.getAddress(id),
+                       escape(names && !name.empty() ? names->decode(name) : name));
+        bool first = true;
+        for (const CompactEdge &edge : graph.getChildren(id)) {
+            fmt::format_to(it, "{}{{\"id\":{},\"offset\":{},\"virtual\":{},\"public\":{}}}",
+                           first ? "" : ",", edge.target, edge.offset,
+                           bool(edge.flags & EdgeFlag::VIRTUAL),
+                           bool(edge.flags & EdgeFlag::PUBLIC));
+            first = false;
+        }
+        out += "]}";
+    }
+
+    out += "],\"vtables\":[";
+    const auto ids = classIds(graph);
+    bool first = true;
+    for (const VtableRecord &vtable : skald.getVtables()) {
+        fmt::format_to(it,
+                       "{}\n{{\"address\":\"{:#x}\",\"class\":{},\"kind\":\"{}\","
+                       "\"offsetToTop\":{},\"subobject\":{},\"owner\":{},\"slots\":[",
+                       first ? "" : ",", vtable.address, jsonClass(graph.find(vtable.rttiAddress)),
+                       kindName(vtable.kind), vtable.offsetToTop,
+                       jsonClass(findClass(ids, vtable.subobject)),
+                       jsonClass(findClass(ids, vtable.owner)));
+        for (size_t slot = 0; slot < vtable.functions.size(); ++slot)
+            fmt::format_to(it, "{}\"{:#x}\"", slot ? "," : "", vtable.functions[slot]);
+        out += "]}";
+        first = false;
+    }
+    out += "]}\n";
+    writeText(path, out);
+}
+
+// One node per class, labelled with the extent of its primary vtable. The virtual bases are dashed
+void writeDot(const Skald &skald, const std::filesystem::path &path, TypeNameDecoder *names) {
+    const CompactGraph &graph = skald.getInheritanceGraph();
+    std::vector<const VtableRecord *> primaries(graph.size(), nullptr);
+    for (const VtableRecord &vtable : skald.getVtables()) {
+        const class_id_t id = graph.find(vtable.rttiAddress);
+        if (vtable.kind == VtableKind::PRIMARY && id != NO_CLASS) primaries[id] = &vtable;
+    }
+
+    std::string out = "digraph skald {\n    node [shape=box];\n    edge [arrowhead=empty];\n";
+    auto it = std::back_inserter(out);
+    for (class_id_t id = 0; id < graph.size(); ++id) {
+        const std::string_view name = graph.getName(id);
+        std::string label = name.empty() ? fmt::format("{:#x}", graph.getAddress(id))
+                                         : escape(names ? names->decode(name) : name);
+        if (primaries[id])
+            label += fmt::format("\\nvtable {:#x}, {} slots", primaries[id]->address,
+                                 primaries[id]->functions.size());
+        fmt::format_to(it, "    n{} [label=\"{}\"{}];\n", id, label,
+                       name.empty() ? ",style=dashed" : "");
+    }
+    for (class_id_t id = 0; id < graph.size(); ++id) {
+        for (const CompactEdge &edge : graph.getChildren(id)) {
+            fmt::format_to(it, "    n{} -> n{}", id, edge.target);
+            if (edge.flags & EdgeFlag::VIRTUAL) {
+                out += " [style=dashed]";
+            } else if (edge.offset != 0) {
+                fmt::format_to(it, " [label=\"{:#x}\"]", edge.offset);
+            }
+            out += ";\n";
+        }
+    }
+    out += "}\n";
+    writeText(path, out);
+}
+
+}  // namespace
+
+ExportFormat getExportFormat(const std::filesystem::path &path) {
+    const std::filesystem::path extension = path.extension();
+    if (extension == ".json") return ExportFormat::JSON;
+    if (extension == ".dot" || extension == ".gv") return ExportFormat::DOT;
+    return ExportFormat::BINARY;
+}
+
+void exportHierarchy(const Skald &skald, const std::filesystem::path &path, ExportFormat format,
+                     TypeNameDecoder *names) {
+    switch (format) {
+        case ExportFormat::BINARY:
+            return writeBinary(skald, path);
+        case ExportFormat::JSON:
+            return writeJson(skald, path, names);
+        case ExportFormat::DOT:
+            return writeDot(skald, path, names);
+    }
+}
+
+HierarchyFile::HierarchyFile(const std::filesystem::path &path) : file(path) {
+    if constexpr (std::endian::native != std::endian::little)
+        throw std::runtime_error("Binary exports are only supported on little endian hosts");
+
+    // Everything is checked once here, the accessors trust the indexes and the offsets
+    const auto invalid = [&](std::string_view reason) {
+        return std::runtime_error(
+            fmt::format("`{}` is not a valid hierarchy export: {}", path.string(), reason));
+    };
+    const std::span<const uint8_t> bytes = this->file.data();
+    if (bytes.size() < sizeof(Header)) throw invalid("truncated");
+    this->header = reinterpret_cast<const Header *>(bytes.data());
+    if (this->header->magic != MAGIC || this->header->version != VERSION)
+        throw invalid("wrong magic or version");
+    // Bounded first, the offsets of the sections can not wrap around
+    if (this->header->slotCount > bytes.size() / sizeof(address_t) ||
+        this->header->textSize > bytes.size())
+        throw invalid("truncated");
+    const Sections sections(*this->header);
+    if (sections.end > bytes.size()) throw invalid("truncated");
+
+    this->classes = reinterpret_cast<const PackedClass *>(bytes.data() + sections.classes);
+    this->edges = reinterpret_cast<const PackedEdge *>(bytes.data() + sections.edges);
+    this->vtables = reinterpret_cast<const PackedVtable *>(bytes.data() + sections.vtables);
+    this->slots = reinterpret_cast<const address_t *>(bytes.data() + sections.slots);
+    this->text = reinterpret_cast<const char *>(bytes.data() + sections.text);
+
+    const uint32_t classCount = this->header->classCount;
+    const auto validClass = [&](class_id_t id) { return id == NO_CLASS || id < classCount; };
+    for (uint32_t i = 0; i < classCount; ++i) {
+        const PackedClass &packed = this->classes[i];
+        if ((i && packed.address <= this->classes[i - 1].address) ||
+            uint64_t{packed.nameOffset} + packed.nameLength > this->header->textSize ||
+            uint64_t{packed.firstBase} + packed.baseCount > this->header->edgeCount)
+            throw invalid("wrong class");
+    }
+    for (uint32_t i = 0; i < this->header->edgeCount; ++i)
+        if (this->edges[i].target >= classCount) throw invalid("wrong base");
+    for (uint32_t i = 0; i < this->header->vtableCount; ++i) {
+        const PackedVtable &vtable = this->vtables[i];
+        if (vtable.firstSlot > this->header->slotCount ||
+            vtable.slotCount > this->header->slotCount - vtable.firstSlot ||
+            !validClass(vtable.id) || !validClass(vtable.subobject) || !validClass(vtable.owner))
+            throw invalid("wrong vtable");
+    }
+}
+
+class_id_t HierarchyFile::find(address_t address) const {
+    const std::span<const PackedClass> all(this->classes, this->header->classCount);
+    auto it = std::ranges::lower_bound(all, address, {}, &PackedClass::address);
+    return it != all.end() && it->address == address ? it - all.begin() : NO_CLASS;
+}
+
+}  // namespace skald
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string_view>
+
+#include "compact_graph.h"
+#include "mapped_file.h"
+#include "records.h"
+#include "types.h"
+
+namespace skald {
+
+class Skald;
+class TypeNameDecoder;
+
+enum class ExportFormat {
+    BINARY,  // Read back by HierarchyFile
+    JSON,
+    DOT,  // Graphviz, the derived classes point to their bases
+};
+
+// Format of an export to `path` from its extension: `.json`, `.dot` or `.gv`, binary otherwise
+ExportFormat getExportFormat(const std::filesystem::path &path);
+
+// Writes the inheritance graph recovered by `skald` with its vtables, their extents and the targets
+// of their slots. The vtables are left out of a streaming run, which does not keep them. `names` is
+// null to keep the names mangled, the binary format always has them mangled. Throws
+// std::runtime_error on I/O errors
+void exportHierarchy(const Skald &skald, const std::filesystem::path &path, ExportFormat format,
+                     TypeNameDecoder *names = nullptr);
+
+// Hierarchy exported in the binary format, for the tools working on the recovered classes without
+// running the analysis again. The file is mapped read-only and used in place: flat arrays indexed
+// by the class ids of the CompactGraph it was written from, and a string table. Loading checks the
+// bounds of every record once, in linear time, and copies nothing
+class HierarchyFile {
+   public:
+    // On-disk structures, little endian
+    struct Header {
+        uint64_t magic;
+        uint32_t version;
+        uint32_t pointerSize;
+        uint32_t classCount;
+        uint32_t edgeCount;
+        uint32_t vtableCount;
+        uint32_t reserved;
+        uint64_t slotCount;
+        uint64_t textSize;
+    };
+    struct PackedClass {
+        address_t address;  // Of the type_info, sorted
+        uint32_t nameOffset;  // In the text, mangled. Empty for a class defined in another module
+        uint32_t nameLength;
+        uint32_t firstBase;  // In the edges
+        uint32_t baseCount;
+    };
+    struct PackedEdge {
+        class_id_t target;
+        EdgeFlag flags;
+        int64_t offset;  // As in `TypeInfoRecord::baseOffsets`
+    };
+    struct PackedVtable {
+        address_t address;  // Of the first slot
+        int64_t offsetToTop;
+        uint64_t firstSlot;  // In the slots
+        uint32_t slotCount;
+        class_id_t id;         // Of the type_info, NO_CLASS if it is not in the graph
+        VtableKind kind;
+        class_id_t subobject;  // As in VtableRecord, NO_CLASS if it is the class itself
+        class_id_t owner;      // NO_CLASS unless a construction vtable
+        uint32_t reserved;
+    };
+
+    // Throws std::runtime_error if the file can not be read or is not a valid export
+    explicit HierarchyFile(const std::filesystem::path &path);
+
+    uint32_t getPointerSize() const { return this->header->pointerSize; }
+
+    size_t size() const { return this->header->classCount; }
+    // Class of the type_info at `address`, NO_CLASS if there is none
+    class_id_t find(address_t address) const;
+    address_t getAddress(class_id_t id) const { return this->classes[id].address; }
+    std::string_view getName(class_id_t id) const {
+        return {this->text + this->classes[id].nameOffset, this->classes[id].nameLength};
+    }
+    std::span<const PackedEdge> getBases(class_id_t id) const {
+        return {this->edges + this->classes[id].firstBase, this->classes[id].baseCount};
+    }
+
+    // In the order of `Skald::getVtables()`
+    std::span<const PackedVtable> getVtables() const {
+        return {this->vtables, this->header->vtableCount};
+    }
+    std::span<const address_t> getSlots(const PackedVtable &vtable) const {
+        return {this->slots + vtable.firstSlot, vtable.slotCount};
+    }
+
+   private:
+    MappedFile file;
+
+    const Header *header = nullptr;
+    const PackedClass *classes = nullptr;
+    const PackedEdge *edges = nullptr;
+    const PackedVtable *vtables = nullptr;
+    const address_t *slots = nullptr;
+    const char *text = nullptr;
+};
+
+}  // namespace skald
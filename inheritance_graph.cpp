@@ -8,21 +8,20 @@
 #include <utility>
 #include <vector>
 
-#include "binaryninjaapi.h"
-
 namespace skald {
 
 InheritanceGraph::InheritanceGraph() {}
 
 void InheritanceGraph::addNode(const std::string &name, address_t rttiAddress,
-                               const std::vector<edge_t> &children) {
+                               const std::vector<edge_t> &children,
+                               const std::vector<int64_t> &childOffsets) {
     // Add the missing children
     for (const auto &[addr, e_flags] : children) {
         // First time adding the children node. Add it as a skeleton node that will be later
         // initialized
         if (!this->idMap.contains(addr)) {
             this->idMap[addr] = this->graph.size();
-            this->graph.push_back({{}, {}, "", addr, addr});
+            this->graph.push_back({{}, {}, {}, "", addr, addr});
         }
         this->roots.erase(addr);  // Children is not a root anymore
         this->graph[this->idMap[addr]].parents.push_back({rttiAddress, e_flags});
@@ -36,8 +35,9 @@ void InheritanceGraph::addNode(const std::string &name, address_t rttiAddress,
         // Initialize its content
         this->graph[this->idMap[rttiAddress]].name = name;
         this->graph[this->idMap[rttiAddress]].children = children;
+        this->graph[this->idMap[rttiAddress]].childOffsets = childOffsets;
     } else {  // First time adding it. Create the node
-        Node node{{}, children, name, rttiAddress, rttiAddress};
+        Node node{{}, children, childOffsets, name, rttiAddress, rttiAddress};
         this->roots.insert(rttiAddress);
         this->idMap[rttiAddress] = this->graph.size();
         this->graph.push_back(std::move(node));
@@ -46,7 +46,7 @@ void InheritanceGraph::addNode(const std::string &name, address_t rttiAddress,
 
 Node &InheritanceGraph::getNodeById(const node_identifier_t &id) {
     if (!this->idMap.contains(id))
-        throw std::invalid_argument(fmt::format("No node with id %p", id));
+        throw std::invalid_argument(fmt::format("No node with id {:#x}", id));
     return this->graph[this->idMap[id]];
 }
 
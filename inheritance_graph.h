@@ -8,13 +8,13 @@
 #include <vector>
 
 #include "bitmask.h"
+#include "types.h"
 
 namespace skald {
 
 typedef enum : uint32_t { VIRTUAL = 1, PUBLIC = 2 } EdgeFlag;
 DECLARE_BITMASK(EdgeFlag);
 
-typedef uint64_t address_t;
 typedef address_t node_identifier_t;  // A node identifier is also an address
 
 // Inheritance edge type. It has a node identifier and EdgeFlag describing the edge type
@@ -26,6 +26,7 @@ class Node {
 
     std::vector<edge_t> parents;
     std::vector<edge_t> children;
+    std::vector<int64_t> childOffsets;  // `TypeInfoRecord::baseOffsets` of the children
     std::string name;
     address_t rttiAddress;
     node_identifier_t id;  // For now the address is the same as the id, but it might change
@@ -35,9 +36,10 @@ class InheritanceGraph {
    public:
     InheritanceGraph();
     void addNode(const std::string &name, address_t rttiAddress,
-                 const std::vector<edge_t> &children);
+                 const std::vector<edge_t> &children, const std::vector<int64_t> &childOffsets);
     Node &getNodeByAddr(const address_t &addr);
     Node &getNodeById(const node_identifier_t &id);
+    const std::vector<Node> &getNodes() const { return this->graph; }
 
     auto getRoots() {
         return std::views::transform(this->roots, [&](const node_identifier_t id) -> Node & {
@@ -0,0 +1,187 @@
+#include "instrumentation.h"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace skald {
+
+namespace {
+
+struct TimerEvent {
+    const char *name;
+    uint32_t thread;
+    uint64_t start;  // Nanoseconds since `epoch`
+    uint64_t duration;
+};
+
+const auto epoch = std::chrono::steady_clock::now();
+
+std::mutex eventsMutex;
+std::vector<TimerEvent> events;
+std::array<std::atomic<uint64_t>, static_cast<size_t>(Counter::COUNT)> counters{};
+
+std::string_view counterName(Counter counter) {
+    switch (counter) {
+        case Counter::READ:
+            return "read";
+        case Counter::BYTES_READ:
+            return "bytes read";
+        case Counter::GET_SECTIONS:
+            return "get sections";
+        case Counter::GET_SEGMENTS:
+            return "get segments";
+        case Counter::GET_RELOCATIONS:
+            return "get relocations";
+        case Counter::IS_VALID_OFFSET:
+            return "is valid offset";
+        case Counter::IS_OFFSET_READABLE:
+            return "is offset readable";
+        case Counter::IS_OFFSET_EXECUTABLE:
+            return "is offset executable";
+        case Counter::GET_SECTION_AT:
+            return "get section at";
+        case Counter::GET_DATA_VARIABLE:
+            return "get data variable";
+        case Counter::DEFINE_DATA_VARIABLE:
+            return "define data variable";
+        case Counter::DEFINE_SYMBOL:
+            return "define symbol";
+        case Counter::DEFINE_TYPES:
+            return "define types";
+        case Counter::GET_CODE_REFERENCES:
+            return "get code references";
+        case Counter::GET_IL:
+            return "get IL";
+        case Counter::CREATE_FUNCTION:
+            return "create function";
+        default:
+            return "add code reference";
+    }
+}
+
+uint64_t now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                                                                epoch)
+        .count();
+}
+
+// Small dense identifier of the calling thread, for the trace
+uint32_t threadId() {
+    static std::atomic<uint32_t> next = 0;
+    thread_local const uint32_t id = next++;
+    return id;
+}
+
+std::string escapeJson(std::string_view text) {
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') escaped += '\\';
+        escaped += c;
+    }
+    return escaped;
+}
+
+}  // namespace
+
+ScopedTimer::ScopedTimer(const char *name) : name(name), start(now()) {}
+
+ScopedTimer::~ScopedTimer() {
+    const uint64_t end = now();
+    std::lock_guard lock(eventsMutex);
+    events.push_back({this->name, threadId(), this->start, end - this->start});
+}
+
+void count(Counter counter, uint64_t value) {
+    counters[static_cast<size_t>(counter)].fetch_add(value, std::memory_order_relaxed);
+}
+
+void resetInstrumentation() {
+    std::lock_guard lock(eventsMutex);
+    events.clear();
+    for (auto &counter : counters) counter = 0;
+}
+
+std::string formatInstrumentationSummary() {
+    struct Total {
+        uint64_t calls = 0;
+        uint64_t duration = 0;
+        uint64_t max = 0;
+    };
+
+    // Keep the timers in the order they were first started
+    std::vector<const char *> order;
+    std::map<std::string_view, Total> totals;
+    {
+        std::lock_guard lock(eventsMutex);
+        std::vector<TimerEvent> sorted = events;
+        std::ranges::sort(sorted, {}, &TimerEvent::start);
+        for (const TimerEvent &event : sorted) {
+            auto [it, inserted] = totals.try_emplace(event.name);
+            if (inserted) order.push_back(event.name);
+            it->second.calls++;
+            it->second.duration += event.duration;
+            it->second.max = std::max(it->second.max, event.duration);
+        }
+    }
+
+    std::string summary = fmt::format("{:<24} {:>8} {:>12} {:>12}\n", "timer", "calls",
+                                      "total ms", "max ms");
+    for (const char *name : order) {
+        const Total &total = totals[name];
+        summary += fmt::format("{:<24} {:>8} {:>12.2f} {:>12.2f}\n", name, total.calls,
+                               total.duration / 1e6, total.max / 1e6);
+    }
+
+    summary += fmt::format("\n{:<24} {:>12}\n", "counter", "value");
+    for (size_t i = 0; i < counters.size(); ++i) {
+        const uint64_t value = counters[i].load(std::memory_order_relaxed);
+        if (value) summary += fmt::format("{:<24} {:>12}\n", counterName(Counter(i)), value);
+    }
+    return summary;
+}
+
+bool writeTrace(const std::filesystem::path &path) {
+    std::FILE *file = std::fopen(path.c_str(), "w");
+    if (!file) return false;
+
+    // Complete events ("X"), the timestamps are in microseconds. The counters are emitted once, at
+    // the end of the trace
+    uint64_t last = 0;
+    fmt::print(file, "{{\"traceEvents\":[\n");
+    {
+        std::lock_guard lock(eventsMutex);
+        for (const TimerEvent &event : events) {
+            fmt::print(file,
+                       "{{\"name\":\"{}\",\"cat\":\"skald\",\"ph\":\"X\",\"pid\":1,\"tid\":{},"
+                       "\"ts\":{:.3f},\"dur\":{:.3f}}},\n",
+                       escapeJson(event.name), event.thread, event.start / 1e3,
+                       event.duration / 1e3);
+            last = std::max(last, event.start + event.duration);
+        }
+    }
+
+    std::string args;
+    for (size_t i = 0; i < counters.size(); ++i) {
+        if (!args.empty()) args += ',';
+        args += fmt::format("\"{}\":{}", counterName(Counter(i)),
+                            counters[i].load(std::memory_order_relaxed));
+    }
+    fmt::print(file, "{{\"name\":\"calls\",\"ph\":\"C\",\"pid\":1,\"tid\":0,\"ts\":{:.3f},"
+               "\"args\":{{{}}}}}\n]}}\n", last / 1e3, args);
+
+    return std::fclose(file) == 0;
+}
+
+}  // namespace skald
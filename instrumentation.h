@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+namespace skald {
+
+// Timers and counters of the recovery, for profiling. The SKALD_TIMED_SCOPE and SKALD_COUNT
+// macros compile to nothing unless SKALD_INSTRUMENTATION is defined, so that the production
+// builds do not pay for them
+#ifdef SKALD_INSTRUMENTATION
+constexpr bool INSTRUMENTATION_ENABLED = true;
+#else
+constexpr bool INSTRUMENTATION_ENABLED = false;
+#endif
+
+// Calls made to the binary (and the Binary Ninja API) through the backends and the annotator
+enum class Counter : uint32_t {
+    READ,
+    BYTES_READ,
+    GET_SECTIONS,
+    GET_SEGMENTS,
+    GET_RELOCATIONS,
+    IS_VALID_OFFSET,
+    IS_OFFSET_READABLE,
+    IS_OFFSET_EXECUTABLE,
+    GET_SECTION_AT,
+    GET_DATA_VARIABLE,
+    DEFINE_DATA_VARIABLE,
+    DEFINE_SYMBOL,
+    DEFINE_TYPES,
+    GET_CODE_REFERENCES,
+    GET_IL,
+    CREATE_FUNCTION,
+    ADD_CODE_REFERENCE,
+    COUNT
+};
+
+// Records the time spent between its construction and its destruction under `name`, which must
+// be a string literal
+class ScopedTimer {
+   public:
+    explicit ScopedTimer(const char *name);
+    ~ScopedTimer();
+
+    ScopedTimer(const ScopedTimer &) = delete;
+    ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+   private:
+    const char *name;
+    uint64_t start;
+};
+
+// Safe to call from any thread
+void count(Counter counter, uint64_t value = 1);
+
+// Drop the timings and the counters recorded so far
+void resetInstrumentation();
+
+// Table with the total time of each timer and the value of each counter
+std::string formatInstrumentationSummary();
+
+// Write the timings as a Chrome trace (JSON), it can be opened in Perfetto or chrome://tracing
+bool writeTrace(const std::filesystem::path &path);
+
+}  // namespace skald
+
+#ifdef SKALD_INSTRUMENTATION
+#define SKALD_CONCAT_(a, b) a##b
+#define SKALD_CONCAT(a, b) SKALD_CONCAT_(a, b)
+#define SKALD_TIMED_SCOPE(name) const ::skald::ScopedTimer SKALD_CONCAT(timer_, __LINE__)(name)
+#define SKALD_COUNT(counter, value) ::skald::count(::skald::Counter::counter, value)
+#else
+#define SKALD_TIMED_SCOPE(name) static_cast<void>(0)
+#define SKALD_COUNT(counter, value) static_cast<void>(0)
+#endif
@@ -0,0 +1,232 @@
+#include "layout_recovery.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "compact_graph.h"
+#include "instrumentation.h"
+#include "log.h"
+#include "records.h"
+#include "skald.h"
+
+namespace skald {
+
+namespace {
+
+// Number of functions summarized between two checkpoints
+constexpr size_t FUNCTION_BATCH_SIZE = 256;
+
+// Accesses further than this from the object are not members
+constexpr int64_t MAX_OBJECT_SIZE = 1 << 24;
+
+// Address point of a vtable used by the complete objects of a class
+struct AddressPoint {
+    address_t address;
+    class_id_t id;
+    bool primary;
+};
+
+typedef std::pair<int64_t, int64_t> range_t;  // [start, end) in the object
+
+bool isCovered(std::span<const range_t> ranges, int64_t offset) {
+    return std::ranges::any_of(ranges, [&](const range_t &range) {
+        return offset >= range.first && offset < range.second;
+    });
+}
+
+// Fields from the accesses sorted by offset: the smallest access at each offset, the ones
+// overlapping the previous field or lying in `covered` are dropped
+void addFields(std::vector<LayoutField> &fields, std::span<const FieldAccess> accesses,
+               std::span<const range_t> covered) {
+    int64_t end = 0;
+    for (const FieldAccess &access : accesses) {
+        if (access.offset < end || access.size == 0 || access.offset >= MAX_OBJECT_SIZE ||
+            isCovered(covered, access.offset))
+            continue;
+        fields.push_back({access.offset, access.size});
+        end = access.offset + access.size;
+    }
+}
+
+uint64_t getEnd(const ClassLayout &layout, std::span<const range_t> covered,
+                int64_t pointerSize) {
+    int64_t end = pointerSize;
+    for (const range_t &range : covered) end = std::max(end, range.second);
+    for (const LayoutField &field : layout.fields)
+        end = std::max<int64_t>(end, field.offset + field.size);
+    return end;
+}
+
+}  // namespace
+
+void LayoutRecovery::run(const Skald &skald) {
+    SKALD_TIMED_SCOPE("layout recovery");
+    const CompactGraph &graph = skald.getInheritanceGraph();
+    const int64_t pointerSize = skald.getAbi().pointerSize;
+    this->layouts.clear();
+
+    // The construction vtables are left out: the constructors using them take the address points
+    // from the VTT, they never store them as constants
+    std::vector<AddressPoint> points;
+    std::vector<const VtableRecord *> primaries(graph.size(), nullptr);
+    for (const VtableRecord &vtable : skald.getVtables()) {
+        const class_id_t id = graph.find(vtable.rttiAddress);
+        if (id == NO_CLASS || vtable.kind == VtableKind::CONSTRUCTION) continue;
+        const bool primary = vtable.kind == VtableKind::PRIMARY;
+        points.push_back({vtable.address, id, primary});
+        if (primary && !primaries[id]) primaries[id] = &vtable;
+    }
+    std::ranges::sort(points, {}, &AddressPoint::address);
+    const auto findPoint = [&](address_t address) -> const AddressPoint * {
+        auto it = std::ranges::lower_bound(points, address, {}, &AddressPoint::address);
+        return it != points.end() && it->address == address ? &*it : nullptr;
+    };
+
+    // Every complete object constructor or destructor references the primary vtable
+    std::vector<class_id_t> classes;
+    for (class_id_t id = 0; id < graph.size(); ++id)
+        if (primaries[id]) classes.push_back(id);
+    std::vector<std::vector<address_t>> references(classes.size());
+    this->pool.parallelFor(classes.size(), [&](size_t i) {
+        references[i] = this->code.getReferencingFunctions(primaries[classes[i]]->address);
+    });
+    std::vector<address_t> functions;
+    for (const auto &functionsOf : references)
+        functions.insert(functions.end(), functionsOf.begin(), functionsOf.end());
+    std::ranges::sort(functions);
+    functions.erase(std::ranges::unique(functions).begin(), functions.end());
+
+    // Independent from each other, and by far the most expensive part
+    std::vector<std::optional<FunctionSummary>> summaries(functions.size());
+    for (size_t start = 0; start < functions.size(); start += FUNCTION_BATCH_SIZE) {
+        this->checkpoint(start, functions.size());
+        SKALD_TIMED_SCOPE("function summary");
+        const size_t count = std::min(FUNCTION_BATCH_SIZE, functions.size() - start);
+        this->pool.parallelFor(count, [&](size_t i) {
+            summaries[start + i] = this->code.summarize(functions[start + i]);
+        });
+    }
+    this->checkpoint(functions.size(), functions.size());
+
+    // A function builds the most derived class whose primary vtable it stores into the object,
+    // the others come from inlined constructors of its bases
+    std::vector<uint32_t> rank(graph.size(), UINT32_MAX);
+    const auto order = graph.getTopologicalOrder();
+    for (size_t i = 0; i < order.size(); ++i) rank[order[i]] = i;
+
+    std::vector<std::vector<size_t>> constructors(graph.size());  // Indexes in `functions`
+    std::unordered_map<address_t, class_id_t> built;               // Class built by a function
+    for (size_t i = 0; i < functions.size(); ++i) {
+        if (!summaries[i]) continue;
+        class_id_t owner = NO_CLASS;
+        for (const auto &[offset, value] : summaries[i]->constantStores) {
+            const AddressPoint *point = findPoint(value);
+            if (offset != 0 || !point || !point->primary) continue;
+            if (owner == NO_CLASS || rank[point->id] < rank[owner]) owner = point->id;
+        }
+        if (owner == NO_CLASS) continue;
+        constructors[owner].push_back(i);
+        built.emplace(functions[i], owner);
+    }
+
+    // The bases sit in the higher levels, their layouts are ready when a derived class needs them
+    std::vector<std::optional<ClassLayout>> computed(graph.size());
+    std::vector<std::vector<LayoutField>> members(graph.size());  // Sized once all are computed
+    std::vector<std::vector<range_t>> covered(graph.size());      // Vptr and base subobjects
+    for (size_t level = graph.getLevelCount(); level-- > 0;) {
+        SKALD_TIMED_SCOPE("layout merge");
+        const auto ids = graph.getLevel(level);
+        this->pool.parallelFor(ids.size(), [&](size_t i) {
+            const class_id_t id = ids[i];
+            if (!primaries[id]) return;
+            const VtableRecord &primary = *primaries[id];
+            ClassLayout layout{id, static_cast<uint64_t>(pointerSize), true, {}, {}, {}};
+            covered[id].emplace_back(0, pointerSize);
+
+            for (const CompactEdge &edge : graph.getChildren(id)) {
+                int64_t offset = edge.offset;
+                if (edge.flags & EdgeFlag::VIRTUAL) {
+                    // `edge.offset` locates the vbase offset before the address point, after
+                    // `offset_to_top` and the RTTI pointer
+                    const auto count = static_cast<int64_t>(primary.offsets.size());
+                    const int64_t index = count + (edge.offset + 2 * pointerSize) / pointerSize;
+                    if (edge.offset % pointerSize != 0 || index < 0 || index >= count) continue;
+                    offset = primary.offsets[index];
+                }
+                if (offset < 0 || offset >= MAX_OBJECT_SIZE) continue;
+                const bool isVirtual = (edge.flags & EdgeFlag::VIRTUAL) != 0;
+                layout.bases.push_back({edge.target, offset, isVirtual});
+
+                // A base without a layout has at least its vptr
+                const uint64_t size = computed[edge.target] ? computed[edge.target]->size
+                                                            : pointerSize;
+                covered[id].emplace_back(offset, offset + size);
+                if (offset == 0 && primaries[edge.target]) layout.hasVptr = false;
+            }
+
+            std::vector<FieldAccess> accesses;
+            for (size_t index : constructors[id]) {
+                const FunctionSummary &summary = *summaries[index];
+                layout.constructors.push_back(functions[index]);
+                accesses.insert(accesses.end(), summary.accesses.begin(), summary.accesses.end());
+                for (const auto &[callee, offset] : summary.calls) {
+                    auto it = built.find(callee);
+                    if (it == built.end() || offset <= 0 || offset >= MAX_OBJECT_SIZE ||
+                        isCovered(covered[id], offset))
+                        continue;
+                    members[id].push_back({offset, static_cast<uint64_t>(pointerSize), it->second});
+                }
+            }
+            std::ranges::sort(layout.constructors);
+            std::ranges::sort(accesses, {}, [](const FieldAccess &access) {
+                return std::pair(access.offset, access.size);
+            });
+            addFields(layout.fields, accesses, covered[id]);
+            layout.size = getEnd(layout, covered[id], pointerSize);
+            computed[id] = std::move(layout);
+        });
+    }
+
+    // The member objects take the size of their class, the accesses they overlap are theirs
+    size_t fieldCount = 0;
+    for (class_id_t id = 0; id < graph.size(); ++id) {
+        if (!computed[id]) continue;
+        ClassLayout &layout = *computed[id];
+        if (!members[id].empty()) {
+            std::ranges::sort(members[id], {}, &LayoutField::offset);
+            std::vector<LayoutField> fields;
+            for (LayoutField &member : members[id]) {
+                if (computed[member.type]) member.size = computed[member.type]->size;
+                if (!fields.empty() && member.offset < fields.back().offset +
+                                                           static_cast<int64_t>(fields.back().size))
+                    continue;
+                fields.push_back(member);
+                covered[id].emplace_back(member.offset, member.offset + member.size);
+            }
+            for (const LayoutField &field : layout.fields)
+                if (!isCovered(covered[id], field.offset)) fields.push_back(field);
+            std::ranges::sort(fields, {}, &LayoutField::offset);
+            layout.fields = std::move(fields);
+            layout.size = getEnd(layout, covered[id], pointerSize);
+        }
+        fieldCount += layout.fields.size();
+        this->layouts.push_back(std::move(layout));
+    }
+
+    logInfo("Recovered the layout of {} classes, {} fields, from {} constructors and destructors",
+            this->layouts.size(), fieldCount, built.size());
+}
+
+void LayoutRecovery::checkpoint(size_t done, size_t total) {
+    if (!this->observer) return;
+    if (this->observer->isCancelled()) throw RunCancelled();
+    this->observer->progress(Phase::LAYOUTS, done, total);
+}
+
+}  // namespace skald
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "compact_graph.h"
+#include "records.h"
+#include "run_observer.h"
+#include "thread_pool.h"
+#include "types.h"
+
+namespace skald {
+
+class Skald;
+
+// Load or store through the object, `size` bytes at `offset`
+struct FieldAccess {
+    int64_t offset;
+    uint32_t size;
+};
+
+// Call through the vtable of the object, or of one of its subobjects
+struct VirtualCall {
+    address_t site;  // Address of the call instruction
+    int64_t object;  // Offset of the vptr in the object
+    int64_t slot;    // Offset of the function pointer from the address point
+};
+
+// What a function does with the object passed as its first argument (`this`)
+struct FunctionSummary {
+    std::vector<std::pair<int64_t, address_t>> constantStores;  // Offset and constant stored
+    std::vector<FieldAccess> accesses;                          // Every other load and store
+    std::vector<std::pair<address_t, int64_t>> calls;  // Callee and offset of the object passed
+    std::vector<VirtualCall> virtualCalls;
+};
+
+// Code analysis the layout recovery and the call resolution are built on. Only the plugin has one,
+// from the IL of Binary Ninja
+class CodeSource {
+   public:
+    virtual ~CodeSource() = default;
+
+    // Start of the functions whose code references `address`
+    virtual std::vector<address_t> getReferencingFunctions(address_t address) = 0;
+
+    // Summary of the function starting at `function`, nullopt if it has not been analyzed. Called
+    // concurrently
+    virtual std::optional<FunctionSummary> summarize(address_t function) = 0;
+};
+
+struct LayoutBase {
+    class_id_t id;
+    int64_t offset;
+    bool isVirtual;
+};
+
+struct LayoutField {
+    int64_t offset;
+    uint64_t size;
+    class_id_t type = NO_CLASS;  // Class of a member object, built by one of its constructors
+};
+
+// Layout of the objects of a class, as far as its constructors and destructors tell
+struct ClassLayout {
+    class_id_t id;
+    uint64_t size;  // End of the last known member, without the tail padding
+    bool hasVptr;   // Not shared with a base at offset 0
+    std::vector<LayoutBase> bases;        // Direct bases
+    std::vector<LayoutField> fields;      // Sorted by offset, outside of the bases
+    std::vector<address_t> constructors;  // Constructors and destructors found, sorted
+};
+
+// Recovers the layout of the classes having a vtable. Their constructors and destructors are the
+// functions storing the address point of one of their vtables into the object, the members are
+// the offsets they access outside of the base subobjects. The functions are summarized in
+// parallel, the classes are then processed from the bases to the derived classes, level by level,
+// so that the layout of each base is computed once and reused by all the classes deriving from it
+class LayoutRecovery {
+   public:
+    LayoutRecovery(CodeSource &code, ThreadPool &pool) : code(code), pool(pool) {}
+
+    // `observer` must outlive the runs, nullptr to remove it
+    void setObserver(RunObserver *observer) { this->observer = observer; }
+
+    // Throws RunCancelled if the observer cancels the run
+    void run(const Skald &skald);
+
+    // Layouts of the classes having a primary vtable, sorted by class
+    const std::vector<ClassLayout> &getLayouts() const { return this->layouts; }
+
+   private:
+    CodeSource &code;
+    ThreadPool &pool;
+    RunObserver *observer = nullptr;
+    std::vector<ClassLayout> layouts;
+
+    // Reports the progress to the observer, throws RunCancelled if it was cancelled
+    void checkpoint(size_t done, size_t total);
+};
+
+}  // namespace skald
@@ -0,0 +1,101 @@
+#include "lazy_session.h"
+
+#include <fmt/format.h>
+
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+#include "binaryninjaapi.h"
+#include "log.h"
+#include "plugin_settings.h"
+#include "recovery_task.h"
+#include "skald.h"
+
+namespace skald {
+
+using BinaryNinja::BinaryView;
+using BinaryNinja::Ref;
+
+namespace {
+
+std::mutex sessionsMutex;
+std::unordered_map<BNBinaryView *, std::shared_ptr<LazySession>> sessions;
+
+}  // namespace
+
+LazySession::LazySession(Ref<BinaryView> view)
+    : _view(view), backend(view), cache(backend), skald(cache), annotator(view) {}
+
+std::shared_ptr<LazySession> LazySession::get(Ref<BinaryView> view) {
+    std::lock_guard lock(sessionsMutex);
+    std::shared_ptr<LazySession> &session = sessions[view->GetObject()];
+    if (!session) session.reset(new LazySession(view));
+    return session;
+}
+
+void LazySession::resolve(Ref<BinaryView> view, address_t address) {
+    std::thread([session = get(view), address] { session->run(address); }).detach();
+}
+
+void LazySession::close(BinaryView *view) {
+    std::lock_guard lock(sessionsMutex);
+    sessions.erase(view->GetObject());
+}
+
+LazySession::Lock LazySession::lock(BinaryView *view) {
+    std::shared_ptr<LazySession> session;
+    {
+        std::lock_guard lock(sessionsMutex);
+        auto it = sessions.find(view->GetObject());
+        if (it == sessions.end()) return {};
+        session = it->second;
+    }
+    std::unique_lock lock(session->mutex);
+    return {std::move(session), std::move(lock)};
+}
+
+void LazySession::run(address_t address) {
+    std::lock_guard lock(this->mutex);
+
+    // The recovery of the whole view resolves this class too
+    if (RecoveryTask::isRunning(this->_view)) {
+        logWarn("A recovery is running on this view, the class at {:#x} is left to it", address);
+        return;
+    }
+
+    // The settings may have changed since the previous request
+    const auto signatures =
+        RecoveryTask::getSignatures(PluginSettings::read(this->_view).signatures);
+    this->skald.setSignatures(signatures);
+    this->annotator.setSignatures(signatures);
+
+    Ref<BinaryNinja::BackgroundTask> task(new BinaryNinja::BackgroundTask(
+        fmt::format("skald: resolving the class at {:#x}", address), false));
+
+    try {
+        // Only the records added by this request are applied
+        const size_t typeInfos = this->skald.getTypeInfos().size();
+        const size_t vtables = this->skald.getVtables().size();
+        const size_t vtts = this->skald.getVtts().size();
+        if (this->skald.resolve(address)) {
+            const Skald &skald = this->skald;
+            this->annotator.applyTypeInfos(std::span(skald.getTypeInfos()).subspan(typeInfos));
+            this->annotator.applyVtables(std::span(skald.getVtables()).subspan(vtables));
+            this->annotator.applyVtts(std::span(skald.getVtts()).subspan(vtts));
+            this->annotator.createMissingFunctions();
+        } else {
+            logWarn("No type_info or vtable found at {:#x}", address);
+        }
+    } catch (const std::exception &e) {
+        logError("Resolving the class at {:#x} failed: {}", address, e.what());
+    }
+    task->Finish();
+}
+
+}  // namespace skald
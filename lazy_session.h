@@ -0,0 +1,54 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+
+#include "annotator.h"
+#include "binary_view_backend.h"
+#include "binaryninjaapi.h"
+#include "page_cache.h"
+#include "skald.h"
+#include "types.h"
+
+namespace skald {
+
+// Lazy mode of a BinaryView: the classes are resolved one at a time, on request, instead of the
+// whole binary at once. The session of a view lives until the view is closed, so that each request
+// only pays for the classes the previous ones did not resolve
+class LazySession {
+   public:
+    // Resolve the class at `address` in a background thread, then apply the new records to the
+    // view. The requests made on the same view run one after the other, and are refused while a
+    // RecoveryTask is running on it
+    static void resolve(BinaryNinja::Ref<BinaryNinja::BinaryView> view, address_t address);
+
+    // Drops the session of `view`, which is being closed. A request still running keeps it alive
+    // until it ends
+    static void close(BinaryNinja::BinaryView *view);
+
+    // Returned by `lock()`, keeps the session alive as long as its mutex is held
+    struct Lock {
+        std::shared_ptr<LazySession> session;
+        std::unique_lock<std::mutex> lock;
+    };
+
+    // Waits for the request running on `view`, if any, and holds back the next ones until the
+    // lock is released. A RecoveryTask holds it for its whole run
+    static Lock lock(BinaryNinja::BinaryView *view);
+
+   private:
+    BinaryNinja::Ref<BinaryNinja::BinaryView> _view;
+    BinaryViewBackend backend;
+    PageCache cache;
+    Skald skald;
+    Annotator annotator;
+    std::mutex mutex;  // Held for a whole request
+
+    explicit LazySession(BinaryNinja::Ref<BinaryNinja::BinaryView> view);
+    void run(address_t address);
+
+    // Session of `view`, created on the first request
+    static std::shared_ptr<LazySession> get(BinaryNinja::Ref<BinaryNinja::BinaryView> view);
+};
+
+}  // namespace skald
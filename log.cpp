@@ -0,0 +1,41 @@
+#include "log.h"
+
+#include <cstdio>
+#include <string>
+#include <utility>
+
+namespace skald {
+
+namespace {
+
+const char *levelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::DEBUG:
+            return "debug";
+        case LogLevel::INFO:
+            return "info";
+        case LogLevel::WARNING:
+            return "warning";
+        default:
+            return "error";
+    }
+}
+
+log_sink_t sink = [](LogLevel level, const std::string &message) {
+    std::fprintf(stderr, "[%s] %s\n", levelName(level), message.c_str());
+};
+LogLevel minLevel = LogLevel::INFO;
+
+}  // namespace
+
+void setLogSink(log_sink_t newSink) { sink = std::move(newSink); }
+
+void setLogLevel(LogLevel level) { minLevel = level; }
+
+bool isLogEnabled(LogLevel level) { return level >= minLevel; }
+
+void log(LogLevel level, const std::string &message) {
+    if (isLogEnabled(level) && sink) sink(level, message);
+}
+
+}  // namespace skald
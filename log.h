@@ -0,0 +1,47 @@
+#pragma once
+
+#include <fmt/format.h>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+
+namespace skald {
+
+enum class LogLevel : uint32_t { DEBUG, INFO, WARNING, ERROR };
+
+// Destination of the log messages. The plugin forwards them to the Binary Ninja log, the CLI
+// prints them on stderr
+typedef std::function<void(LogLevel, const std::string &)> log_sink_t;
+
+void setLogSink(log_sink_t sink);
+void setLogLevel(LogLevel level);
+bool isLogEnabled(LogLevel level);
+void log(LogLevel level, const std::string &message);
+
+template <typename... Args>
+void logDebug(fmt::format_string<Args...> format, Args &&...args) {
+    if (isLogEnabled(LogLevel::DEBUG))
+        log(LogLevel::DEBUG, fmt::format(format, std::forward<Args>(args)...));
+}
+
+template <typename... Args>
+void logInfo(fmt::format_string<Args...> format, Args &&...args) {
+    if (isLogEnabled(LogLevel::INFO))
+        log(LogLevel::INFO, fmt::format(format, std::forward<Args>(args)...));
+}
+
+template <typename... Args>
+void logWarn(fmt::format_string<Args...> format, Args &&...args) {
+    if (isLogEnabled(LogLevel::WARNING))
+        log(LogLevel::WARNING, fmt::format(format, std::forward<Args>(args)...));
+}
+
+template <typename... Args>
+void logError(fmt::format_string<Args...> format, Args &&...args) {
+    if (isLogEnabled(LogLevel::ERROR))
+        log(LogLevel::ERROR, fmt::format(format, std::forward<Args>(args)...));
+}
+
+}  // namespace skald
@@ -0,0 +1,39 @@
+#include "mapped_file.h"
+
+#include <fcntl.h>
+#include <fmt/format.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <stdexcept>
+
+namespace skald {
+
+MappedFile::MappedFile(const std::filesystem::path &path) {
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) throw std::runtime_error(fmt::format("Cannot open `{}`", path.string()));
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw std::runtime_error(fmt::format("Cannot open `{}`", path.string()));
+    }
+    this->size = st.st_size;
+    if (this->size == 0) {
+        close(fd);
+        return;
+    }
+
+    void *mapping = mmap(nullptr, this->size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+        throw std::runtime_error(fmt::format("Cannot map `{}`", path.string()));
+    this->mapping = static_cast<const uint8_t *>(mapping);
+}
+
+MappedFile::~MappedFile() {
+    if (this->mapping) munmap(const_cast<uint8_t *>(this->mapping), this->size);
+}
+
+}  // namespace skald
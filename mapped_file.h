@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+
+namespace skald {
+
+// Read-only mapping of a whole file, the formats meant to be loaded in place are read through it
+class MappedFile {
+   public:
+    // Throws std::runtime_error if the file can not be opened or mapped
+    explicit MappedFile(const std::filesystem::path &path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    std::span<const uint8_t> data() const { return {this->mapping, this->size}; }
+
+   private:
+    const uint8_t *mapping = nullptr;
+    size_t size = 0;
+};
+
+}  // namespace skald
@@ -0,0 +1,84 @@
+#include "page_cache.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+
+#include "backend.h"
+
+namespace skald {
+
+PageCache::PageCache(Backend &backend, size_t capacity)
+    : backend(backend),
+      capacity(std::max<size_t>(capacity, 1)),
+      generation(backend.getGeneration()) {}
+
+void PageCache::invalidate() {
+    std::lock_guard lock(this->mutex);
+    this->lru.clear();
+    this->pages.clear();
+}
+
+PageCache::page_t PageCache::getPage(address_t base) {
+    {
+        std::lock_guard lock(this->mutex);
+
+        // The binary changed since the pages were cached
+        const uint64_t current = this->backend.getGeneration();
+        if (current != this->generation) {
+            this->lru.clear();
+            this->pages.clear();
+            this->generation = current;
+        }
+
+        if (auto it = this->pages.find(base); it != this->pages.end()) {
+            this->lru.splice(this->lru.begin(), this->lru, it->second);
+            return *it->second;
+        }
+    }
+
+    // Miss. Fetch the page without holding the lock, another thread might do the same but the
+    // result is identical
+    auto page = std::make_shared<Page>();
+    page->base = base;
+    page->bytes.resize(PAGE_SIZE);
+    page->bytes.resize(this->backend.read(page->bytes.data(), base, PAGE_SIZE));
+
+    std::lock_guard lock(this->mutex);
+    if (auto it = this->pages.find(base); it != this->pages.end()) return *it->second;
+
+    this->lru.push_front(page);
+    this->pages[base] = this->lru.begin();
+    if (this->lru.size() > this->capacity) {
+        this->pages.erase(this->lru.back()->base);
+        this->lru.pop_back();
+    }
+    return page;
+}
+
+size_t PageCache::read(void *dest, address_t address, size_t len) {
+    auto *out = static_cast<uint8_t *>(dest);
+    size_t done = 0;
+
+    while (done < len) {
+        const address_t current = address + done;
+        const address_t base = current & ~static_cast<address_t>(PAGE_SIZE - 1);
+        const page_t page = this->getPage(base);
+
+        // Beyond the readable part of the page, let the backend decide about it
+        const size_t offset = current - base;
+        if (offset >= page->bytes.size())
+            return done + this->backend.read(out + done, current, len - done);
+
+        const size_t chunk = std::min(len - done, page->bytes.size() - offset);
+        std::memcpy(out + done, page->bytes.data() + offset, chunk);
+        done += chunk;
+    }
+
+    return done;
+}
+
+}  // namespace skald
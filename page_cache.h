@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "backend.h"
+
+namespace skald {
+
+// Read-through cache in front of a backend whose reads are expensive (e.g. a call through the
+// Binary Ninja FFI). Memory is fetched in large pages and the least recently used ones are
+// evicted. The whole cache is dropped whenever the backend reports a new generation, that is when
+// the content of the binary changes. Every other query is forwarded as is
+class PageCache : public Backend {
+   public:
+    static constexpr size_t PAGE_SIZE = 0x10000;
+
+    explicit PageCache(Backend &backend, size_t capacity = 64);
+
+    void invalidate();
+
+    std::vector<Section> getSections() override { return this->backend.getSections(); }
+    std::vector<Section> getSegments() override { return this->backend.getSegments(); }
+    RelocationTable getRelocations() override { return this->backend.getRelocations(); }
+    size_t read(void *dest, address_t address, size_t len) override;
+    bool isValidOffset(address_t address) override { return this->backend.isValidOffset(address); }
+    bool isOffsetReadable(address_t address) override {
+        return this->backend.isOffsetReadable(address);
+    }
+    bool isOffsetExecutable(address_t address) override {
+        return this->backend.isOffsetExecutable(address);
+    }
+    std::optional<Section> getSectionAt(address_t address) override {
+        return this->backend.getSectionAt(address);
+    }
+    uint64_t getGeneration() override { return this->backend.getGeneration(); }
+    Abi getAbi() override { return this->backend.getAbi(); }
+
+   private:
+    struct Page {
+        address_t base;
+        std::vector<uint8_t> bytes;  // Shorter than PAGE_SIZE if the page is not fully readable
+    };
+    typedef std::shared_ptr<const Page> page_t;
+
+    Backend &backend;
+    size_t capacity;
+
+    std::mutex mutex;
+    std::list<page_t> lru;  // Most recently used first
+    std::unordered_map<address_t, std::list<page_t>::iterator> pages;
+    uint64_t generation;
+
+    page_t getPage(address_t base);
+};
+
+}  // namespace skald
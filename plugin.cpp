@@ -0,0 +1,57 @@
+#include <string>
+
+#include "binaryninjaapi.h"
+#include "lazy_session.h"
+#include "log.h"
+#include "plugin_settings.h"
+#include "recovery_task.h"
+
+extern "C" {
+// Tells Binary Ninja which version of the API you compiled against
+BN_DECLARE_CORE_ABI_VERSION
+
+// Function run on plugin startup, do simple initialization here (Settings, BinaryViewTypes, etc)
+// BINARYNINJAPLUGIN bool CorePluginInit() { return skald::Skald::get_instance().init(); }
+BINARYNINJAPLUGIN bool CorePluginInit() {
+    // Forward the logs to Binary Ninja. The debug messages are left out, they are formatted on the
+    // hot paths of the recovery
+    skald::setLogLevel(skald::LogLevel::INFO);
+    skald::setLogSink([](skald::LogLevel level, const std::string &message) {
+        switch (level) {
+            case skald::LogLevel::DEBUG:
+                BinaryNinja::LogDebug("%s", message.c_str());
+                break;
+            case skald::LogLevel::INFO:
+                BinaryNinja::LogInfo("%s", message.c_str());
+                break;
+            case skald::LogLevel::WARNING:
+                BinaryNinja::LogWarn("%s", message.c_str());
+                break;
+            default:
+                BinaryNinja::LogError("%s", message.c_str());
+        }
+    });
+
+    BinaryNinja::LogDebug("Initializing skald plugin");
+    skald::PluginSettings::registerSettings();
+
+    // The lazy sessions hold the classes resolved on a view, until it is closed
+    BinaryNinja::BinaryViewType::RegisterBinaryViewFinalizationEvent(
+        [](BinaryNinja::BinaryView *view) { skald::LazySession::close(view); });
+
+    BinaryNinja::PluginCommand::Register(
+        "skald", "RTTI recovery plugin", [](BinaryNinja::BinaryView *view) {
+            // The recovery runs in background, the UI stays responsive
+            skald::RecoveryTask::start(view);
+        });
+    BinaryNinja::PluginCommand::RegisterForAddress(
+        "skald\\Resolve here",
+        "Recover only the class of the type_info or vtable at this address, with its bases and "
+        "derived classes",
+        [](BinaryNinja::BinaryView *view, uint64_t address) {
+            skald::LazySession::resolve(view, address);
+        });
+
+    return true;
+}
+}
@@ -0,0 +1,65 @@
+#include "plugin_settings.h"
+
+#include <fmt/format.h>
+
+#include <cstdint>
+#include <string>
+
+#include "binaryninjaapi.h"
+
+namespace skald {
+
+using BinaryNinja::BinaryView;
+using BinaryNinja::Ref;
+
+namespace {
+
+// `value` is the default, as JSON
+void registerSetting(BinaryNinja::Settings &settings, const char *key, const char *title,
+                     const char *type, const char *value, const char *description) {
+    settings.RegisterSetting(
+        key, fmt::format(R"({{"title": "{}", "type": "{}", "default": {}, "description": "{}"}})",
+                         title, type, value, description));
+}
+
+}  // namespace
+
+void PluginSettings::registerSettings() {
+    Ref<BinaryNinja::Settings> settings = BinaryNinja::Settings::Instance();
+    settings->RegisterGroup("skald", "Skald");
+    registerSetting(*settings, "skald.memoryBudget", "Streaming memory budget", "number", "0",
+                    "MiB of records held at once in streaming mode, for the binaries too large to "
+                    "hold every record. 0 runs the regular recovery, the only one recovering the "
+                    "layouts and the virtual calls.");
+    registerSetting(*settings, "skald.streamingUndo", "Undo actions in streaming mode", "boolean",
+                    "true",
+                    "Record undo actions for the definitions committed in streaming mode. They "
+                    "cost memory on the largest binaries.");
+    registerSetting(*settings, "skald.signaturePack", "Signature pack", "string", R"("")",
+                    "Path of a signature pack written by skald-pack. The functions of the known "
+                    "classes are named after the symbols of the reference builds.");
+    registerSetting(*settings, "skald.replayTrace", "Replay trace", "string", R"("")",
+                    "Path of a replay trace recording the queries made to the view, to analyze "
+                    "the run again with skald-cli or skald-bench. The results of the previous run "
+                    "are not reused while recording.");
+    registerSetting(*settings, "skald.exportPath", "Hierarchy export", "string", R"("")",
+                    "Path the recovered hierarchy is exported to after each run: JSON for .json, "
+                    "Graphviz for .dot or .gv, the mappable binary format of skald otherwise.");
+    registerSetting(*settings, "skald.chromeTrace", "Chrome trace", "string", R"("")",
+                    "Path of a Chrome trace of the timings of each run. Only written by a build "
+                    "with SKALD_INSTRUMENTATION.");
+}
+
+PluginSettings PluginSettings::read(Ref<BinaryView> view) {
+    Ref<BinaryNinja::Settings> settings = BinaryNinja::Settings::Instance();
+    PluginSettings values;
+    values.memoryBudget = settings->Get<uint64_t>("skald.memoryBudget", view);
+    values.streamingUndo = settings->Get<bool>("skald.streamingUndo", view);
+    values.signatures = settings->Get<std::string>("skald.signaturePack", view);
+    values.record = settings->Get<std::string>("skald.replayTrace", view);
+    values.exportPath = settings->Get<std::string>("skald.exportPath", view);
+    values.trace = settings->Get<std::string>("skald.chromeTrace", view);
+    return values;
+}
+
+}  // namespace skald
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "binaryninjaapi.h"
+
+namespace skald {
+
+// Options of the plugin, registered as Binary Ninja settings under `skald.` so that they can be
+// changed from the settings UI, for every view or for a single one
+struct PluginSettings {
+    uint64_t memoryBudget = 0;  // MiB of records held at once in streaming mode, 0 to disable it
+    bool streamingUndo = true;  // Undo actions for the definitions committed in streaming mode
+    std::string signatures;     // Signature pack, empty if none
+    std::string record;         // Replay trace recording the queries of the run, empty if none
+    std::string exportPath;     // Export of the hierarchy, empty if none
+    std::string trace;          // Chrome trace of an instrumented build, empty if none
+
+    // Called once, when the plugin is loaded
+    static void registerSettings();
+
+    // Values for `view`, read when a task starts
+    static PluginSettings read(BinaryNinja::Ref<BinaryNinja::BinaryView> view);
+};
+
+}  // namespace skald
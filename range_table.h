@@ -0,0 +1,35 @@
+#pragma once
+
+#include <algorithm>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "backend.h"
+
+namespace skald {
+
+// Flat table of non overlapping address ranges (sections or segments) sorted by address, built
+// once so that the lookups do not need to query the backend
+class RangeTable {
+   public:
+    RangeTable() = default;
+    explicit RangeTable(std::vector<Section> ranges) : ranges(std::move(ranges)) {
+        std::ranges::sort(this->ranges, {}, &Section::start);
+    }
+
+    // Range containing `address`, nullptr if there is none
+    const Section *find(address_t address) const {
+        auto it = std::ranges::upper_bound(this->ranges, address, {}, &Section::start);
+        if (it == this->ranges.begin()) return nullptr;
+        --it;
+        return address < it->end ? &*it : nullptr;
+    }
+
+    std::span<const Section> get() const { return this->ranges; }
+
+   private:
+    std::vector<Section> ranges;
+};
+
+}  // namespace skald
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "inheritance_graph.h"
+#include "rtti.h"
+#include "signature_pack.h"
+#include "types.h"
+
+namespace skald {
+
+// A std::type_info object found in the binary
+struct TypeInfoRecord {
+    address_t address = 0;
+    TypeInfo type = CLASS_TYPE_INFO;
+    uint32_t baseCount = 0;     // Number of `__base_info` entries, only for VMI_CLASS_TYPE_INFO
+    std::string name{};         // Mangled name pointed by `__type_name`
+    address_t nameAddress = 0;  // Value of `__type_name`
+    std::vector<edge_t> bases{};
+    bool cached = false;  // Restored from a previous run
+
+    // Offset of each base in the object. For the virtual bases, offset of their vbase offset
+    // relative to the address point of the vtable (`__offset_flags >> 8`)
+    std::vector<int64_t> baseOffsets{};
+};
+
+// Role of a vtable in its group, the vtables of a class laid out one after the other
+enum class VtableKind : uint32_t {
+    PRIMARY,       // Used by the object and its primary bases
+    SECONDARY,     // Used by a base subobject at a non-zero offset
+    CONSTRUCTION,  // Used while the class is constructed as a base of `owner`
+};
+
+// A vtable found in the binary
+struct VtableRecord {
+    address_t address = 0;      // Address of the first virtual function pointer
+    address_t rttiAddress = 0;  // Address of the type_info of the class
+    std::string className{};
+    std::vector<address_t> functions{};  // Virtual function pointers
+    bool cached = false;                 // Restored from a previous run
+
+    VtableKind kind = VtableKind::PRIMARY;
+    int64_t offsetToTop = 0;         // Negated offset of the subobject using the vtable
+    std::string subobject{};         // Base class of the subobject if not the class itself, mangled
+    std::string owner{};             // Complete class of the construction vtables, mangled
+    std::vector<int64_t> offsets{};  // vcall and vbase offsets preceding `offset_to_top`
+
+    // Class of the signature pack given to `Skald` matching this one, only for a primary vtable
+    uint32_t signature = NO_SIGNATURE;
+};
+
+// A VTT: the address points of the vtables used by the constructors of a class having virtual
+// bases, those of the class and the construction vtables of its bases
+struct VttRecord {
+    address_t address;
+    address_t rttiAddress;  // Address of the type_info of the class
+    std::string className;
+    std::vector<address_t> entries;
+};
+
+}  // namespace skald
@@ -0,0 +1,247 @@
+#include "recovery_task.h"
+
+#include <fmt/format.h>
+
+#include <cstddef>
+#include <exception>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+#include "annotator.h"
+#include "binary_view_backend.h"
+#include "binary_view_code_source.h"
+#include "binaryninjaapi.h"
+#include "call_resolution.h"
+#include "hierarchy_export.h"
+#include "instrumentation.h"
+#include "layout_recovery.h"
+#include "lazy_session.h"
+#include "log.h"
+#include "page_cache.h"
+#include "plugin_settings.h"
+#include "result_cache.h"
+#include "run_observer.h"
+#include "signature_pack.h"
+#include "skald.h"
+#include "trace_backend.h"
+
+namespace skald {
+
+using BinaryNinja::BinaryView;
+using BinaryNinja::Ref;
+
+namespace {
+
+// Metadata holding the results of the previous run on the view
+constexpr const char *CACHE_KEY = "skald.cache";
+
+// Records committed per undo action in streaming mode
+constexpr size_t STREAMING_BATCH_SIZE = 4096;
+
+// Latest task started on each view
+std::mutex tasksMutex;
+std::unordered_map<BNBinaryView *, std::shared_ptr<RecoveryTask>> tasks;
+
+// Signature packs in use, by path. They are unmapped once no run uses them anymore
+struct LoadedPack {
+    std::filesystem::file_time_type modified;
+    std::weak_ptr<const SignaturePack> pack;
+};
+std::mutex packsMutex;
+std::unordered_map<std::string, LoadedPack> packs;
+
+std::string_view phaseName(Phase phase) {
+    switch (phase) {
+        case Phase::RELOCATIONS:
+            return "scanning relocations";
+        case Phase::RTTI:
+            return "parsing RTTI";
+        case Phase::VTABLES:
+            return "sizing vtables";
+        case Phase::LAYOUTS:
+            return "recovering layouts";
+        default:
+            return "resolving virtual calls";
+    }
+}
+
+}  // namespace
+
+RecoveryTask::RecoveryTask(Ref<BinaryView> view)
+    : _view(view),
+      task(new BinaryNinja::BackgroundTask("skald: starting", true)),
+      annotator(view),
+      finished(this->done.get_future().share()) {}
+
+void RecoveryTask::start(Ref<BinaryView> view) {
+    std::shared_ptr<RecoveryTask> task(new RecoveryTask(view));
+    std::shared_ptr<RecoveryTask> previous;
+    {
+        std::lock_guard lock(tasksMutex);
+        previous = std::exchange(tasks[view->GetObject()], task);
+    }
+    if (previous) {
+        logInfo("Cancelling the recovery already running on this view");
+        previous->task->Cancel();
+    }
+
+    std::thread([task, previous] {
+        if (previous) previous->finished.wait();
+        task->run();
+
+        {
+            std::lock_guard lock(tasksMutex);
+            auto it = tasks.find(task->_view->GetObject());
+            if (it != tasks.end() && it->second == task) tasks.erase(it);
+        }
+        task->done.set_value();
+    }).detach();
+}
+
+bool RecoveryTask::isRunning(BinaryView *view) {
+    std::lock_guard lock(tasksMutex);
+    return tasks.contains(view->GetObject());
+}
+
+std::shared_ptr<const SignaturePack> RecoveryTask::getSignatures(const std::string &path) {
+    if (path.empty()) return nullptr;
+    std::error_code ec;
+    const std::filesystem::file_time_type modified = std::filesystem::last_write_time(path, ec);
+
+    // A failed load is not cached, the next run tries again
+    std::lock_guard lock(packsMutex);
+    LoadedPack &loaded = packs[path];
+    if (auto pack = loaded.pack.lock(); pack && loaded.modified == modified) return pack;
+    try {
+        auto pack = std::make_shared<const SignaturePack>(path);
+        logInfo("Loaded the signatures of {} classes from {}", pack->size(), path);
+        loaded = {modified, pack};
+        return pack;
+    } catch (const std::exception &e) {
+        logError("Cannot load the signature pack: {}", e.what());
+        return nullptr;
+    }
+}
+
+void RecoveryTask::run() {
+    // A lazy request applying its records to the view ends first, the next ones are refused
+    const LazySession::Lock lazy = LazySession::lock(this->_view);
+    const PluginSettings settings = PluginSettings::read(this->_view);
+
+    try {
+        // Cancelled before even starting, a newer task is already waiting
+        if (this->task->IsCancelled()) throw RunCancelled();
+
+        resetInstrumentation();
+        BinaryViewBackend backend(_view);
+
+        // Record the queries made to the view, to replay the run without Binary Ninja. The
+        // recorder sits below the page cache so that the trace holds whole pages
+        const bool record = !settings.record.empty();
+        TraceRecorder recorder(backend);
+        PageCache cache(record ? static_cast<Backend &>(recorder) : backend);
+        Skald skald(cache);
+        skald.setObserver(this);
+        const std::shared_ptr<const SignaturePack> signatures = getSignatures(settings.signatures);
+        skald.setSignatures(signatures);
+        this->annotator.setSignatures(signatures);
+
+        // Streaming mode for the binaries too large to hold every record, with a budget in MiB.
+        // The definitions are committed in bounded batches, optionally without undo actions
+        const bool streaming = settings.memoryBudget != 0;
+        if (streaming) {
+            skald.setStreaming(StreamingOptions{settings.memoryBudget << 20, {}});
+            this->annotator.setBatching(STREAMING_BATCH_SIZE, settings.streamingUndo);
+            logInfo("Streaming mode, about {} MiB of records held at once",
+                    settings.memoryBudget);
+        }
+
+        // A trace is only complete if nothing was restored from the cache. A streaming run keeps
+        // no records to store in the cache
+        skald.setCaching(!streaming);
+        Ref<BinaryNinja::Metadata> stored = _view->QueryMetadata(CACHE_KEY);
+        if (stored && stored->IsRaw() && !record && !streaming) {
+            if (auto previous = deserializeResultCache(stored->GetRaw()))
+                skald.setCache(std::move(*previous));
+        }
+
+        skald.run();
+        if (record) {
+            recorder.save(settings.record);
+            logInfo("Queries to the view recorded in {}", settings.record);
+        }
+
+        if (streaming) {
+            // The layouts and the calls are recovered from the vtables, which were not kept
+            logInfo("Recovered {} classes, no layouts nor virtual calls in streaming mode",
+                    skald.getInheritanceGraph().size());
+        } else {
+            _view->StoreMetadata(
+                CACHE_KEY,
+                new BinaryNinja::Metadata(serializeResultCache(skald.getResultCache())), true);
+            logInfo("Recovered {} type_info objects and {} vtables", skald.getTypeInfos().size(),
+                    skald.getVtables().size());
+
+            // The functions referenced by the vtables have all been created and analyzed by now
+            BinaryViewCodeSource code(_view);
+            LayoutRecovery layouts(code, skald.getThreadPool());
+            layouts.setObserver(this);
+            layouts.run(skald);
+            this->annotator.applyLayouts(skald.getInheritanceGraph(), layouts.getLayouts());
+
+            CallResolution calls(code, skald.getThreadPool());
+            calls.setObserver(this);
+            calls.run(skald);
+            this->annotator.applyCalls(calls.getCalls());
+        }
+
+        // For the tools working on the hierarchy outside of Binary Ninja, the format is picked
+        // from the extension
+        if (!settings.exportPath.empty()) {
+            exportHierarchy(skald, settings.exportPath, getExportFormat(settings.exportPath));
+            logInfo("Hierarchy exported to {}", settings.exportPath);
+        }
+    } catch (const RunCancelled &) {
+        logInfo("Recovery cancelled");
+    } catch (const std::exception &e) {
+        logError("Recovery failed: {}", e.what());
+    }
+
+    if (INSTRUMENTATION_ENABLED) {
+        logInfo("Timings and API calls of the recovery:\n{}", formatInstrumentationSummary());
+        if (!settings.trace.empty() && !writeTrace(settings.trace))
+            logError("Cannot write the trace to {}", settings.trace);
+    }
+    this->task->Finish();
+}
+
+void RecoveryTask::progress(Phase phase, size_t done, size_t total) {
+    this->task->SetProgressText(fmt::format("skald: {} ({}/{})", phaseName(phase), done, total));
+}
+
+void RecoveryTask::typeInfosAdded(const Skald &skald,
+                                  std::span<const TypeInfoRecord> typeInfos) {
+    this->annotator.applyTypeInfos(typeInfos);
+}
+
+void RecoveryTask::phaseCompleted(const Skald &skald, Phase phase) {
+    if (phase == Phase::VTABLES) {
+        this->annotator.applyVtts(skald.getVtts());
+        this->annotator.createMissingFunctions();
+    }
+}
+
+void RecoveryTask::vtablesAdded(const Skald &skald, std::span<const VtableRecord> vtables) {
+    this->annotator.applyVtables(vtables);
+}
+
+bool RecoveryTask::isCancelled() { return this->task->IsCancelled(); }
+
+}  // namespace skald
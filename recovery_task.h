@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <future>
+#include <memory>
+#include <span>
+#include <string>
+
+#include "annotator.h"
+#include "binaryninjaapi.h"
+#include "run_observer.h"
+#include "signature_pack.h"
+
+namespace skald {
+
+// Recovery running on a BinaryView in a background thread, reported as a cancellable Binary Ninja
+// task. The records are applied to the view in batches, as soon as they are recovered
+class RecoveryTask : public RunObserver {
+   public:
+    // Starts a recovery on `view`. A recovery already running on the same view is cancelled and
+    // the new one starts once it has stopped
+    static void start(BinaryNinja::Ref<BinaryNinja::BinaryView> view);
+
+    // Whether a recovery is pending or running on `view`
+    static bool isRunning(BinaryNinja::BinaryView *view);
+
+    // Signature pack at `path`, shared by the views using it and loaded again once rewritten.
+    // nullptr if `path` is empty or the pack can not be loaded
+    static std::shared_ptr<const SignaturePack> getSignatures(const std::string &path);
+
+    void progress(Phase phase, size_t done, size_t total) override;
+    void typeInfosAdded(const Skald &skald, std::span<const TypeInfoRecord> typeInfos) override;
+    void phaseCompleted(const Skald &skald, Phase phase) override;
+    void vtablesAdded(const Skald &skald, std::span<const VtableRecord> vtables) override;
+    bool isCancelled() override;
+
+   private:
+    BinaryNinja::Ref<BinaryNinja::BinaryView> _view;
+    BinaryNinja::Ref<BinaryNinja::BackgroundTask> task;
+    Annotator annotator;
+    std::promise<void> done;
+    std::shared_future<void> finished;  // Ready once `run()` has returned
+
+    explicit RecoveryTask(BinaryNinja::Ref<BinaryNinja::BinaryView> view);
+    void run();
+};
+
+}  // namespace skald
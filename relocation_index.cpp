@@ -0,0 +1,70 @@
+#include "relocation_index.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "backend.h"
+#include "rtti.h"
+
+namespace skald {
+
+RelocationIndex::RelocationIndex(RelocationTable table, uint32_t pointerSize)
+    : symbols(std::move(table.symbols)) {
+    const auto symbolCount = static_cast<uint32_t>(this->symbols.size());
+
+    // Counting sort of the relocations by symbol
+    this->offsets.assign(symbolCount + 1, 0);
+    for (const auto &rel : table.relocations)
+        if (rel.symbol < symbolCount) ++this->offsets[rel.symbol + 1];
+    for (uint32_t i = 0; i < symbolCount; ++i) this->offsets[i + 1] += this->offsets[i];
+
+    this->sites.resize(this->offsets.back());
+    std::vector<uint32_t> fill(this->offsets.begin(), this->offsets.end() - 1);
+    for (const auto &rel : table.relocations)
+        if (rel.symbol < symbolCount) this->sites[fill[rel.symbol]++] = rel.address;
+
+    // Classify each symbol once
+    std::vector<TypeInfo> types(symbolCount);
+    for (uint32_t i = 0; i < symbolCount; ++i) {
+        std::sort(this->sites.begin() + this->offsets[i],
+                  this->sites.begin() + this->offsets[i + 1]);
+        types[i] = classifyTypeInfoVtable(this->symbols[i]);
+    }
+
+    // The vtable pointer of a type_info object is the address point of the vtable of its class,
+    // the other sites are not objects (the GOT entries of these vtables). Those whose addend is
+    // unknown are kept
+    const int64_t addressPoint = int64_t{2} * pointerSize;
+    for (const auto &rel : table.relocations) {
+        if (rel.symbol >= symbolCount || types[rel.symbol] == TypeInfo::UNSUPPORTED) continue;
+        if (rel.addend == UNKNOWN_ADDEND || rel.addend == addressPoint)
+            this->typeInfos.emplace_back(rel.address, types[rel.symbol]);
+    }
+
+    std::ranges::sort(this->typeInfos);
+    auto [first, last] =
+        std::ranges::unique(this->typeInfos, {}, &std::pair<address_t, TypeInfo>::first);
+    this->typeInfos.erase(first, last);
+
+    this->symbolsByName.resize(symbolCount);
+    for (uint32_t i = 0; i < symbolCount; ++i) this->symbolsByName[i] = i;
+    std::ranges::sort(this->symbolsByName, {}, [&](uint32_t id) -> std::string_view {
+        return this->symbols[id];
+    });
+}
+
+std::span<const address_t> RelocationIndex::getSites(std::string_view symbol) const {
+    auto it = std::ranges::lower_bound(this->symbolsByName, symbol, {},
+                                       [&](uint32_t id) -> std::string_view {
+                                           return this->symbols[id];
+                                       });
+    if (it == this->symbolsByName.end() || this->symbols[*it] != symbol) return {};
+    return std::span(this->sites).subspan(this->offsets[*it],
+                                          this->offsets[*it + 1] - this->offsets[*it]);
+}
+
+}  // namespace skald
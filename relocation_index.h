@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "backend.h"
+#include "rtti.h"
+
+namespace skald {
+
+// Index of the relocations by target symbol, built in a single sweep over the relocation table.
+// The type_info vtable symbols are classified once per symbol instead of once per relocation
+class RelocationIndex {
+   public:
+    RelocationIndex() = default;
+    // `pointerSize` is the one of the binary, the type_info objects point two words into the
+    // vtable of their class
+    RelocationIndex(RelocationTable table, uint32_t pointerSize);
+
+    // Addresses patched by a relocation targeting `symbol`, sorted
+    std::span<const address_t> getSites(std::string_view symbol) const;
+
+    // Every type_info object (a relocation against the vtable of a type_info class, past its
+    // `offset_to_top` and RTTI pointer) with its type, sorted by address. The GOT entries of these
+    // vtables are left out
+    const std::vector<std::pair<address_t, TypeInfo>> &getTypeInfos() const {
+        return this->typeInfos;
+    }
+
+   private:
+    std::vector<std::string> symbols;
+    std::vector<uint32_t> symbolsByName;  // Symbol ids sorted by name
+
+    // Sites of the symbol `i` are `sites[offsets[i]] ... sites[offsets[i + 1] - 1]`
+    std::vector<uint32_t> offsets;
+    std::vector<address_t> sites;
+
+    std::vector<std::pair<address_t, TypeInfo>> typeInfos;
+};
+
+}  // namespace skald
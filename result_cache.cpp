@@ -0,0 +1,271 @@
+#include "result_cache.h"
+
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "backend.h"
+#include "log.h"
+#include "records.h"
+#include "thread_pool.h"
+
+namespace skald {
+
+namespace {
+
+constexpr uint32_t MAGIC = 0x444c4b53;  // "SKLD"
+constexpr uint32_t VERSION = 2;
+
+// Bytes of data hashed by each task
+constexpr uint64_t CHUNK_SIZE = 0x100000;
+
+// Fast non cryptographic hash, it only has to notice a change in the data
+constexpr uint64_t mix(uint64_t hash, uint64_t value) {
+    return std::rotl((hash ^ value) * 0x9e3779b97f4a7c15ull, 31);
+}
+
+uint64_t hashChunk(std::span<const uint8_t> bytes) {
+    uint64_t hash = bytes.size();
+    size_t i = 0;
+    for (; i + 8 <= bytes.size(); i += 8) {
+        uint64_t word;
+        std::memcpy(&word, bytes.data() + i, 8);
+        hash = mix(hash, word);
+    }
+    if (i == bytes.size()) return hash;
+    uint64_t tail = 0;
+    std::memcpy(&tail, bytes.data() + i, bytes.size() - i);
+    return mix(hash, tail);
+}
+
+// Little endian encoding of the cache, independent from the host
+class Writer {
+   public:
+    template <std::unsigned_integral T>
+    void put(T value) {
+        for (size_t i = 0; i < sizeof(T); ++i) this->data.push_back(value >> (8 * i) & 0xff);
+    }
+
+    void put(std::string_view value) {
+        this->put<uint32_t>(value.size());
+        this->data.insert(this->data.end(), value.begin(), value.end());
+    }
+
+    std::vector<uint8_t> data;
+};
+
+class Reader {
+   public:
+    explicit Reader(std::span<const uint8_t> data) : data(data) {}
+
+    template <std::unsigned_integral T>
+    T get() {
+        this->require(sizeof(T));
+        T value = 0;
+        for (size_t i = 0; i < sizeof(T); ++i) value |= T{this->data[this->position++]} << (8 * i);
+        return value;
+    }
+
+    std::string getString() {
+        const uint32_t size = this->get<uint32_t>();
+        this->require(size);
+        std::string value(this->data.begin() + this->position,
+                          this->data.begin() + this->position + size);
+        this->position += size;
+        return value;
+    }
+
+    // Number of elements of a sequence, checked against the remaining data so that a corrupted
+    // count does not trigger a huge allocation
+    size_t getCount(size_t elementSize) {
+        const uint64_t count = this->get<uint64_t>();
+        if (count > (this->data.size() - this->position) / elementSize)
+            throw std::out_of_range("Truncated result cache");
+        return count;
+    }
+
+    bool atEnd() const { return this->position == this->data.size(); }
+
+   private:
+    std::span<const uint8_t> data;
+    size_t position = 0;
+
+    void require(size_t size) const {
+        if (size > this->data.size() - this->position)
+            throw std::out_of_range("Truncated result cache");
+    }
+};
+
+}  // namespace
+
+uint64_t hashLayout(const std::vector<Section> &sections, const std::vector<Section> &segments,
+                    const std::vector<std::pair<address_t, TypeInfo>> &typeInfos) {
+    uint64_t hash = VERSION;
+    for (const auto *ranges : {&sections, &segments}) {
+        hash = mix(hash, ranges->size());
+        for (const Section &range : *ranges) {
+            hash = mix(hash, range.start);
+            hash = mix(hash, range.end);
+            hash = mix(hash, range.flags);
+            hash = mix(hash, hashChunk({reinterpret_cast<const uint8_t *>(range.name.data()),
+                                        range.name.size()}));
+        }
+    }
+    hash = mix(hash, typeInfos.size());
+    for (const auto &[address, type] : typeInfos) hash = mix(mix(hash, address), type);
+    return hash;
+}
+
+std::vector<std::pair<address_t, uint64_t>> hashSections(Backend &backend, ThreadPool &pool,
+                                                         const std::vector<Section> &sections) {
+    // Split the sections in chunks hashed in parallel, then combine them in order
+    std::vector<std::pair<size_t, address_t>> chunks;
+    for (size_t i = 0; i < sections.size(); ++i)
+        for (address_t addr = sections[i].start; addr < sections[i].end; addr += CHUNK_SIZE)
+            chunks.emplace_back(i, addr);
+
+    std::vector<uint64_t> chunkHashes(chunks.size());
+    pool.parallelFor(chunks.size(), [&](size_t i) {
+        const auto [section, start] = chunks[i];
+        std::vector<uint8_t> bytes(std::min(CHUNK_SIZE, sections[section].end - start));
+        bytes.resize(backend.read(bytes.data(), start, bytes.size()));
+        chunkHashes[i] = hashChunk(bytes);
+    });
+
+    std::vector<std::pair<address_t, uint64_t>> hashes;
+    for (const Section &section : sections)
+        hashes.emplace_back(section.start, mix(section.start, section.end));
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        uint64_t &hash = hashes[chunks[i].first].second;
+        hash = mix(hash, chunkHashes[i]);
+    }
+    return hashes;
+}
+
+std::vector<uint8_t> serializeResultCache(const ResultCache &cache) {
+    Writer writer;
+    writer.put(MAGIC);
+    writer.put(VERSION);
+    writer.put(cache.layoutHash);
+
+    writer.put<uint64_t>(cache.sectionHashes.size());
+    for (const auto &[start, hash] : cache.sectionHashes) {
+        writer.put(start);
+        writer.put(hash);
+    }
+
+    writer.put<uint64_t>(cache.typeInfos.size());
+    for (const TypeInfoRecord &record : cache.typeInfos) {
+        writer.put(record.address);
+        writer.put<uint32_t>(record.type);
+        writer.put(record.baseCount);
+        writer.put(record.name);
+        writer.put(record.nameAddress);
+        writer.put<uint64_t>(record.bases.size());
+        for (size_t i = 0; i < record.bases.size(); ++i) {
+            writer.put(record.bases[i].first);
+            writer.put<uint32_t>(record.bases[i].second);
+            writer.put<uint64_t>(record.baseOffsets[i]);
+        }
+    }
+
+    writer.put<uint64_t>(cache.vtableCandidates.size());
+    for (const auto &[rtti, slot] : cache.vtableCandidates) {
+        writer.put(rtti);
+        writer.put(slot);
+    }
+
+    writer.put<uint64_t>(cache.vtables.size());
+    for (const VtableRecord &record : cache.vtables) {
+        writer.put(record.address);
+        writer.put(record.rttiAddress);
+        writer.put(record.className);
+        writer.put<uint64_t>(record.functions.size());
+        for (address_t function : record.functions) writer.put(function);
+        writer.put<uint32_t>(static_cast<uint32_t>(record.kind));
+        writer.put<uint64_t>(record.offsetToTop);
+        writer.put(record.subobject);
+        writer.put(record.owner);
+        writer.put<uint64_t>(record.offsets.size());
+        for (int64_t offset : record.offsets) writer.put<uint64_t>(offset);
+    }
+
+    return std::move(writer.data);
+}
+
+std::optional<ResultCache> deserializeResultCache(std::span<const uint8_t> data) {
+    try {
+        Reader reader(data);
+        if (reader.get<uint32_t>() != MAGIC || reader.get<uint32_t>() != VERSION) {
+            logInfo("Ignoring the result cache of a different version");
+            return std::nullopt;
+        }
+
+        ResultCache cache;
+        cache.layoutHash = reader.get<uint64_t>();
+
+        cache.sectionHashes.resize(reader.getCount(16));
+        for (auto &[start, hash] : cache.sectionHashes) {
+            start = reader.get<uint64_t>();
+            hash = reader.get<uint64_t>();
+        }
+
+        cache.typeInfos.resize(reader.getCount(36));
+        for (TypeInfoRecord &record : cache.typeInfos) {
+            record.address = reader.get<uint64_t>();
+            record.type = static_cast<TypeInfo>(reader.get<uint32_t>());
+            record.baseCount = reader.get<uint32_t>();
+            record.name = reader.getString();
+            record.nameAddress = reader.get<uint64_t>();
+            record.bases.resize(reader.getCount(20));
+            record.baseOffsets.resize(record.bases.size());
+            for (size_t i = 0; i < record.bases.size(); ++i) {
+                record.bases[i].first = reader.get<uint64_t>();
+                record.bases[i].second = static_cast<EdgeFlag>(reader.get<uint32_t>());
+                record.baseOffsets[i] = static_cast<int64_t>(reader.get<uint64_t>());
+            }
+            record.cached = true;
+        }
+
+        cache.vtableCandidates.resize(reader.getCount(16));
+        for (auto &[rtti, slot] : cache.vtableCandidates) {
+            rtti = reader.get<uint64_t>();
+            slot = reader.get<uint64_t>();
+        }
+
+        cache.vtables.resize(reader.getCount(56));
+        for (VtableRecord &record : cache.vtables) {
+            record.address = reader.get<uint64_t>();
+            record.rttiAddress = reader.get<uint64_t>();
+            record.className = reader.getString();
+            record.functions.resize(reader.getCount(8));
+            for (address_t &function : record.functions) function = reader.get<uint64_t>();
+            record.kind = static_cast<VtableKind>(reader.get<uint32_t>());
+            record.offsetToTop = static_cast<int64_t>(reader.get<uint64_t>());
+            record.subobject = reader.getString();
+            record.owner = reader.getString();
+            record.offsets.resize(reader.getCount(8));
+            for (int64_t &offset : record.offsets)
+                offset = static_cast<int64_t>(reader.get<uint64_t>());
+            record.cached = true;
+        }
+
+        if (!reader.atEnd()) throw std::out_of_range("Trailing data in result cache");
+        return cache;
+    } catch (const std::out_of_range &e) {
+        logWarn("Ignoring a corrupted result cache: {}", e.what());
+        return std::nullopt;
+    }
+}
+
+}  // namespace skald
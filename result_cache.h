@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "backend.h"
+#include "records.h"
+#include "rtti.h"
+#include "thread_pool.h"
+
+namespace skald {
+
+// Results of a previous run together with the fingerprint of the binary they were computed on.
+// What lies in a section whose content did not change is reused as is, the rest is parsed again
+struct ResultCache {
+    // Sections, segments and type_info objects. When it differs nothing is reused
+    uint64_t layoutHash = 0;
+    std::vector<std::pair<address_t, uint64_t>> sectionHashes;  // Section start, content hash
+
+    std::vector<TypeInfoRecord> typeInfos;                          // Sorted by address
+    std::vector<std::pair<address_t, address_t>> vtableCandidates;  // type_info, RTTI slot
+    std::vector<VtableRecord> vtables;
+};
+
+// Fingerprint of the memory layout and of the type_info objects found from the relocations
+uint64_t hashLayout(const std::vector<Section> &sections, const std::vector<Section> &segments,
+                    const std::vector<std::pair<address_t, TypeInfo>> &typeInfos);
+
+// Content hash of each section, computed in parallel
+std::vector<std::pair<address_t, uint64_t>> hashSections(Backend &backend, ThreadPool &pool,
+                                                         const std::vector<Section> &sections);
+
+std::vector<uint8_t> serializeResultCache(const ResultCache &cache);
+
+// std::nullopt if the data is truncated or was written by a different version
+std::optional<ResultCache> deserializeResultCache(std::span<const uint8_t> data);
+
+}  // namespace skald
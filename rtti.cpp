@@ -0,0 +1,72 @@
+#include "rtti.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+
+namespace skald {
+
+namespace {
+
+using namespace std::literals;
+
+// Mangled names of the vtables of the type_info derived classes
+constexpr std::string_view CXXABI_VTABLE_PREFIX = "_ZTVN10__cxxabiv1"sv;
+constexpr std::array<std::pair<std::string_view, TypeInfo>, 10> TYPE_INFO_CLASSES{{
+    {"_ZTVN10__cxxabiv116__enum_type_infoE"sv, TypeInfo::ENUM_TYPE_INFO},
+    {"_ZTVN10__cxxabiv117__class_type_infoE"sv, TypeInfo::CLASS_TYPE_INFO},
+    {"_ZTVN10__cxxabiv117__array_type_infoE"sv, TypeInfo::ARRAY_TYPE_INFO},
+    {"_ZTVN10__cxxabiv121__vmi_class_type_infoE"sv, TypeInfo::VMI_CLASS_TYPE_INFO},
+    {"_ZTVN10__cxxabiv120__si_class_type_infoE"sv, TypeInfo::SI_CLASS_TYPE_INFO},
+    {"_ZTVN10__cxxabiv120__function_type_infoE"sv, TypeInfo::FUNCTION_TYPE_INFO},
+    {"_ZTVN10__cxxabiv119__pointer_type_infoE"sv, TypeInfo::POINTER_TYPE_INFO},
+    {"_ZTVN10__cxxabiv117__pbase_type_infoE"sv, TypeInfo::PBASE_TYPE_INFO},
+    {"_ZTVN10__cxxabiv123__fundamental_type_infoE"sv, TypeInfo::FUNDAMENTAL_TYPE_INFO},
+    {"_ZTVN10__cxxabiv129__pointer_to_member_type_infoE"sv, TypeInfo::POINTER_TO_MEMBER_TYPE_INFO},
+}};
+
+// FNV-1a over the part of the name following the common prefix
+constexpr uint32_t hashName(std::string_view name) {
+    uint32_t hash = 2166136261u;
+    for (char c : name.substr(CXXABI_VTABLE_PREFIX.size())) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Smallest table size for which `hashName` has no collisions on TYPE_INFO_CLASSES
+constexpr size_t findTableSize() {
+    for (size_t size = TYPE_INFO_CLASSES.size();; ++size) {
+        bool collision = false;
+        for (size_t i = 0; i < TYPE_INFO_CLASSES.size() && !collision; ++i)
+            for (size_t j = 0; j < i && !collision; ++j)
+                collision = hashName(TYPE_INFO_CLASSES[i].first) % size ==
+                            hashName(TYPE_INFO_CLASSES[j].first) % size;
+        if (!collision) return size;
+    }
+}
+
+constexpr size_t TABLE_SIZE = findTableSize();
+static_assert(TABLE_SIZE <= 64, "The perfect hash table for the type_info classes is too sparse");
+
+// Perfect hash table, empty slots have an empty name
+constexpr auto TYPE_INFO_TABLE = [] {
+    std::array<std::pair<std::string_view, TypeInfo>, TABLE_SIZE> table{};
+    for (auto &slot : table) slot = {""sv, TypeInfo::UNSUPPORTED};
+    for (const auto &entry : TYPE_INFO_CLASSES) table[hashName(entry.first) % TABLE_SIZE] = entry;
+    return table;
+}();
+
+}  // namespace
+
+TypeInfo classifyTypeInfoVtable(std::string_view symbol) {
+    if (!symbol.starts_with(CXXABI_VTABLE_PREFIX)) return TypeInfo::UNSUPPORTED;
+
+    const auto &[name, type] = TYPE_INFO_TABLE[hashName(symbol) % TABLE_SIZE];
+    return name == symbol ? type : TypeInfo::UNSUPPORTED;
+}
+
+}  // namespace skald
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+
+#include "abi.h"
+
+namespace skald {
+
+enum TypeInfo : uint32_t {
+    CLASS_TYPE_INFO,
+    VMI_CLASS_TYPE_INFO,
+    SI_CLASS_TYPE_INFO,
+    FUNCTION_TYPE_INFO,
+    PBASE_TYPE_INFO,
+    POINTER_TYPE_INFO,
+    FUNDAMENTAL_TYPE_INFO,
+    ARRAY_TYPE_INFO,
+    ENUM_TYPE_INFO,
+    POINTER_TO_MEMBER_TYPE_INFO,
+    UNSUPPORTED,
+};
+
+// Compile-time descriptors of the type_info layouts of the Itanium C++ ABI (2.9.5) for the ABI
+// `A`. Each field is a `Field` carrying its type and offset, `SIZE` is the size of the fixed part
+// of the object. The offsets follow from the pointer size: a `long` is as wide as a pointer and
+// the `unsigned int` fields are 4 bytes on all the targets
+template <typename T, uint64_t Offset>
+struct Field {
+    typedef T type;
+    static constexpr uint64_t offset = Offset;
+};
+
+template <typename A>
+struct ClassTypeInfoLayout {
+    typedef A abi_t;
+    typedef Field<typename A::pointer_t, 0> vtable;
+    typedef Field<typename A::pointer_t, A::POINTER_SIZE> typeName;
+    static constexpr uint64_t SIZE = 2 * A::POINTER_SIZE;
+};
+
+template <typename A>
+struct SiClassTypeInfoLayout : ClassTypeInfoLayout<A> {
+    typedef Field<typename A::pointer_t, 2 * A::POINTER_SIZE> baseType;
+    static constexpr uint64_t SIZE = 3 * A::POINTER_SIZE;
+};
+
+template <typename A>
+struct BaseClassTypeInfoLayout {
+    typedef A abi_t;
+    typedef Field<typename A::pointer_t, 0> baseType;
+    typedef Field<typename A::offset_t, A::POINTER_SIZE> offsetFlags;
+    static constexpr uint64_t SIZE = 2 * A::POINTER_SIZE;
+
+    static constexpr int64_t VIRTUAL_MASK = 0x1;
+    static constexpr int64_t PUBLIC_MASK = 0x2;
+    static constexpr int64_t FLAGS_MASK = 0xff;
+    static constexpr int OFFSET_SHIFT = 8;
+};
+
+template <typename A>
+struct VmiClassTypeInfoLayout : ClassTypeInfoLayout<A> {
+    typedef Field<uint32_t, 2 * A::POINTER_SIZE> flags;
+    typedef Field<uint32_t, 2 * A::POINTER_SIZE + 4> baseCount;
+    // Followed by `baseCount` BaseClassTypeInfoLayout
+    static constexpr uint64_t BASE_INFO = 2 * A::POINTER_SIZE + 8;
+    static constexpr uint64_t SIZE = BASE_INFO;
+};
+
+template <typename A>
+struct PbaseTypeInfoLayout : ClassTypeInfoLayout<A> {
+    typedef Field<uint32_t, 2 * A::POINTER_SIZE> flags;
+    typedef Field<typename A::pointer_t,
+                  std::max<uint64_t>(2 * A::POINTER_SIZE + 4, 3 * A::POINTER_SIZE)>
+        pointee;  // Aligned after `flags`
+    static constexpr uint64_t SIZE = pointee::offset + A::POINTER_SIZE;
+};
+
+template <typename A>
+struct PointerToMemberTypeInfoLayout : PbaseTypeInfoLayout<A> {
+    typedef Field<typename A::pointer_t, PbaseTypeInfoLayout<A>::SIZE> context;
+    static constexpr uint64_t SIZE = context::offset + A::POINTER_SIZE;
+};
+
+// Largest fixed part among the type_info layouts of all the ABIs
+constexpr uint64_t MAX_TYPE_INFO_SIZE = PointerToMemberTypeInfoLayout<ItaniumLe64>::SIZE;
+
+// Decode the fields of `Layout` directly from the raw bytes of the object, without copying them
+template <typename Layout>
+class LayoutView {
+   public:
+    // `bytes` must hold at least `Layout::SIZE` bytes
+    explicit LayoutView(std::span<const uint8_t> bytes) : bytes(bytes.data()) {}
+
+    template <typename F>
+    typename F::type get() const {
+        static_assert(F::offset + sizeof(typename F::type) <= Layout::SIZE,
+                      "Field outside of the layout");
+        typename F::type value;
+        std::memcpy(&value, this->bytes + F::offset, sizeof(value));
+        return fromOrder<Layout::abi_t::ORDER>(value);
+    }
+
+   private:
+    const uint8_t *bytes;
+};
+
+// Type of the std::type_info derived class whose vtable is `symbol` (e.g.
+// `_ZTVN10__cxxabiv117__class_type_infoE`). UNSUPPORTED if it is not one of them
+TypeInfo classifyTypeInfoVtable(std::string_view symbol);
+
+// Size in bytes of a type_info object
+template <typename A>
+constexpr uint64_t typeInfoSize(TypeInfo type, uint32_t baseCount) {
+    switch (type) {
+        case VMI_CLASS_TYPE_INFO:
+            return VmiClassTypeInfoLayout<A>::SIZE +
+                   BaseClassTypeInfoLayout<A>::SIZE * static_cast<uint64_t>(baseCount);
+        case SI_CLASS_TYPE_INFO:
+            return SiClassTypeInfoLayout<A>::SIZE;
+        case PBASE_TYPE_INFO:
+        case POINTER_TYPE_INFO:
+            return PbaseTypeInfoLayout<A>::SIZE;
+        case POINTER_TO_MEMBER_TYPE_INFO:
+            return PointerToMemberTypeInfoLayout<A>::SIZE;
+        default:
+            return ClassTypeInfoLayout<A>::SIZE;
+    }
+}
+
+}  // namespace skald
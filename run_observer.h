@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+
+#include "records.h"
+
+namespace skald {
+
+class Skald;
+
+// Phases of a run, in execution order
+enum class Phase { RELOCATIONS, RTTI, VTABLES, LAYOUTS, CALLS };
+
+// Thrown out of `Skald::run()` when the observer cancels it
+class RunCancelled : public std::runtime_error {
+   public:
+    RunCancelled() : std::runtime_error("Run cancelled") {}
+};
+
+// Follows a run of `Skald`, `LayoutRecovery` or `CallResolution`. Every method is called from the
+// thread executing the run
+class RunObserver {
+   public:
+    virtual ~RunObserver() = default;
+
+    // `done` items out of `total` have been processed in `phase`
+    virtual void progress(Phase phase, size_t done, size_t total) {}
+
+    // The records produced by `phase` are complete and can be used
+    virtual void phaseCompleted(const Skald &skald, Phase phase) {}
+
+    // New type_info objects have been parsed: all of them at once, or one chunk at a time in
+    // streaming mode. The inheritance graph is only complete at `phaseCompleted(RTTI)`
+    virtual void typeInfosAdded(const Skald &skald, std::span<const TypeInfoRecord> typeInfos) {}
+
+    // New vtables have been recovered, called once per level of the inheritance graph, once per
+    // batch of classes in streaming mode
+    virtual void vtablesAdded(const Skald &skald, std::span<const VtableRecord> vtables) {}
+
+    // Polled between two batches of work, the run stops as soon as it returns true
+    virtual bool isCancelled() { return false; }
+};
+
+}  // namespace skald
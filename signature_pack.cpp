@@ -0,0 +1,168 @@
+#include "signature_pack.h"
+
+#include <fmt/format.h>
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "mapped_file.h"
+
+namespace skald {
+
+namespace {
+
+constexpr uint64_t MAGIC = 0x4b4341504c4b53;  // "SKLPACK"
+constexpr uint32_t VERSION = 1;
+
+// FNV-1a
+constexpr uint64_t hashName(std::string_view name) {
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : name) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Offsets of the tables following the header
+struct Sections {
+    uint64_t buckets, classes, strings, text, end;
+
+    explicit Sections(const SignaturePack::Header &header) {
+        this->buckets = sizeof(SignaturePack::Header);
+        this->classes = (this->buckets + uint64_t{4} * header.bucketCount + 7) & ~uint64_t{7};
+        this->strings = this->classes + sizeof(SignaturePack::PackedClass) * header.classCount;
+        this->text = this->strings + sizeof(SignaturePack::PackedString) * header.stringCount;
+        this->end = this->text + header.textSize;
+    }
+};
+
+}  // namespace
+
+SignaturePack::SignaturePack(const std::filesystem::path &path) : file(path) {
+    if constexpr (std::endian::native != std::endian::little)
+        throw std::runtime_error("Signature packs are only supported on little endian hosts");
+
+    // Everything is checked once here, the lookups trust the indexes and the offsets
+    const auto invalid = [&](std::string_view reason) {
+        return std::runtime_error(
+            fmt::format("`{}` is not a valid signature pack: {}", path.string(), reason));
+    };
+    const std::span<const uint8_t> bytes = this->file.data();
+    if (bytes.size() < sizeof(Header)) throw invalid("truncated");
+    this->header = reinterpret_cast<const Header *>(bytes.data());
+    if (this->header->magic != MAGIC || this->header->version != VERSION)
+        throw invalid("wrong magic or version");
+    if (!std::has_single_bit(this->header->bucketCount) ||
+        this->header->bucketCount <= this->header->classCount)
+        throw invalid("wrong bucket count");
+    // Bounded first, the end of the text can not wrap around
+    if (this->header->textSize > bytes.size()) throw invalid("truncated");
+    const Sections sections(*this->header);
+    if (sections.end > bytes.size()) throw invalid("truncated");
+
+    this->buckets = reinterpret_cast<const uint32_t *>(bytes.data() + sections.buckets);
+    this->classes = reinterpret_cast<const PackedClass *>(bytes.data() + sections.classes);
+    this->strings = reinterpret_cast<const PackedString *>(bytes.data() + sections.strings);
+    this->text = reinterpret_cast<const char *>(bytes.data() + sections.text);
+
+    const uint64_t stringCount = this->header->stringCount;
+    for (uint32_t i = 0; i < this->header->bucketCount; ++i)
+        if (this->buckets[i] > this->header->classCount) throw invalid("wrong bucket");
+    for (uint32_t i = 0; i < this->header->classCount; ++i) {
+        const PackedClass &packed = this->classes[i];
+        if (packed.name >= stringCount ||
+            uint64_t{packed.firstBase} + packed.baseCount > stringCount ||
+            uint64_t{packed.firstFunction} + packed.slotCount > stringCount)
+            throw invalid("wrong class");
+    }
+    for (uint64_t i = 0; i < stringCount; ++i)
+        if (uint64_t{this->strings[i].offset} + this->strings[i].length > this->header->textSize)
+            throw invalid("wrong string");
+}
+
+uint32_t SignaturePack::match(std::string_view name,
+                              std::span<const std::string_view> bases) const {
+    const uint64_t hash = hashName(name);
+    const uint32_t mask = this->header->bucketCount - 1;
+    for (uint32_t probe = 0, i = hash & mask; probe <= mask; ++probe, i = (i + 1) & mask) {
+        if (this->buckets[i] == 0) break;
+        const uint32_t index = this->buckets[i] - 1;
+        if (this->classes[index].hash != hash || this->getName(index) != name) continue;
+
+        // Another version of the class than the one of the reference build
+        if (this->getBaseCount(index) != bases.size()) return NO_SIGNATURE;
+        for (size_t base = 0; base < bases.size(); ++base)
+            if (this->getBase(index, base) != bases[base]) return NO_SIGNATURE;
+        return index;
+    }
+    return NO_SIGNATURE;
+}
+
+void SignaturePack::write(const std::filesystem::path &path,
+                          std::span<const ClassSignature> classes) {
+    if constexpr (std::endian::native != std::endian::little)
+        throw std::runtime_error("Signature packs are only supported on little endian hosts");
+
+    std::vector<PackedClass> packed;
+    std::vector<PackedString> strings;
+    std::string text;
+    std::unordered_map<std::string_view, uint32_t> offsets;  // In `text`, of the strings added
+    const auto addString = [&](std::string_view value) {
+        auto [it, inserted] = offsets.try_emplace(value, static_cast<uint32_t>(text.size()));
+        if (inserted) text += value;
+        strings.push_back({it->second, static_cast<uint32_t>(value.size())});
+        return static_cast<uint32_t>(strings.size() - 1);
+    };
+
+    std::unordered_set<std::string_view> names;
+    for (const ClassSignature &signature : classes) {
+        if (!names.insert(signature.name).second) continue;
+        PackedClass entry{hashName(signature.name), addString(signature.name), 0, 0, 0, 0, 0};
+        entry.firstBase = strings.size();
+        entry.baseCount = signature.bases.size();
+        for (const std::string &base : signature.bases) addString(base);
+        entry.firstFunction = strings.size();
+        entry.slotCount = signature.functions.size();
+        for (const std::string &function : signature.functions) addString(function);
+        packed.push_back(entry);
+    }
+
+    // At most half full, the probes stay short
+    Header header{MAGIC, VERSION, static_cast<uint32_t>(packed.size()),
+                  std::bit_ceil(static_cast<uint32_t>(packed.size() * 2 + 1)),
+                  static_cast<uint32_t>(strings.size()), text.size()};
+    std::vector<uint32_t> buckets(header.bucketCount, 0);
+    for (uint32_t i = 0; i < packed.size(); ++i) {
+        uint32_t bucket = packed[i].hash & (header.bucketCount - 1);
+        while (buckets[bucket] != 0) bucket = (bucket + 1) & (header.bucketCount - 1);
+        buckets[bucket] = i + 1;
+    }
+
+    const Sections sections(header);
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    const auto put = [&](const void *data, size_t size) {
+        file.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+    };
+    put(&header, sizeof(header));
+    put(buckets.data(), buckets.size() * sizeof(uint32_t));
+    const uint64_t padding = sections.classes - sections.buckets - buckets.size() * 4;
+    put("\0\0\0\0\0\0\0", padding);
+    put(packed.data(), packed.size() * sizeof(PackedClass));
+    put(strings.data(), strings.size() * sizeof(PackedString));
+    put(text.data(), text.size());
+    if (!file.flush())
+        throw std::runtime_error(fmt::format("Cannot write the pack `{}`", path.string()));
+}
+
+}  // namespace skald
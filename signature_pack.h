@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "mapped_file.h"
+
+namespace skald {
+
+constexpr uint32_t NO_SIGNATURE = UINT32_MAX;
+
+// Class of a reference build, as written to a signature pack
+struct ClassSignature {
+    std::string name;                    // Mangled, as in `TypeInfoRecord::name`
+    std::vector<std::string> bases;      // Mangled names of the direct bases, in order
+    std::vector<std::string> functions;  // Symbol of each slot of the primary vtable, or empty
+};
+
+// Signatures of well-known classes (standard libraries, Boost, Qt...) generated by `skald-pack`
+// from unstripped reference builds. The file is mapped read-only and searched in place through an
+// open addressing hash table: loading a pack only checks its bounds, nothing is copied
+class SignaturePack {
+   public:
+    // Throws std::runtime_error if the file can not be read or is not a valid pack
+    explicit SignaturePack(const std::filesystem::path &path);
+
+    // The first class of a name wins. Throws std::runtime_error on I/O errors
+    static void write(const std::filesystem::path &path, std::span<const ClassSignature> classes);
+
+    size_t size() const { return this->header->classCount; }
+
+    // Class named `name` whose direct bases are `bases`, in order. NO_SIGNATURE if there is none
+    uint32_t match(std::string_view name, std::span<const std::string_view> bases) const;
+
+    std::string_view getName(uint32_t index) const {
+        return this->getString(this->classes[index].name);
+    }
+    size_t getBaseCount(uint32_t index) const { return this->classes[index].baseCount; }
+    std::string_view getBase(uint32_t index, size_t base) const {
+        return this->getString(this->classes[index].firstBase + base);
+    }
+    // Slots of the primary vtable, the symbols of their functions are empty when unknown
+    size_t getSlotCount(uint32_t index) const { return this->classes[index].slotCount; }
+    std::string_view getFunction(uint32_t index, size_t slot) const {
+        return this->getString(this->classes[index].firstFunction + slot);
+    }
+
+    // On-disk structures, little endian
+    struct Header {
+        uint64_t magic;
+        uint32_t version;
+        uint32_t classCount;
+        uint32_t bucketCount;  // Power of two
+        uint32_t stringCount;
+        uint64_t textSize;
+    };
+    struct PackedClass {
+        uint64_t hash;  // Of the name
+        uint32_t name;  // Indexes in the strings
+        uint32_t firstBase;
+        uint32_t baseCount;
+        uint32_t firstFunction;
+        uint32_t slotCount;
+        uint32_t reserved;
+    };
+    struct PackedString {
+        uint32_t offset;  // In the text
+        uint32_t length;
+    };
+
+   private:
+    MappedFile file;
+
+    const Header *header = nullptr;
+    const uint32_t *buckets = nullptr;  // Index of the class plus one, 0 when empty
+    const PackedClass *classes = nullptr;
+    const PackedString *strings = nullptr;
+    const char *text = nullptr;
+
+    std::string_view getString(uint32_t index) const {
+        return {this->text + this->strings[index].offset, this->strings[index].length};
+    }
+};
+
+}  // namespace skald
@@ -1,431 +1,883 @@
 #include "skald.h"
 
-#include <fmt/format.h>
-
-#include <any>
-#include <array>
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
-#include <queue>
+#include <cstring>
+#include <filesystem>
+#include <iterator>
+#include <memory>
+#include <optional>
 #include <ranges>
+#include <span>
 #include <string>
 #include <string_view>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
-#include "binaryninjaapi.h"
+#include "abi.h"
+#include "backend.h"
+#include "compact_graph.h"
 #include "inheritance_graph.h"
+#include "instrumentation.h"
+#include "log.h"
+#include "result_cache.h"
+#include "rtti.h"
+#include "spill_file.h"
 
 namespace skald {
 
-using BinaryNinja::BaseStructure;
-using BinaryNinja::DataVariable;
-using BinaryNinja::QualifiedName;
-using BinaryNinja::Ref;
-using BinaryNinja::Structure;
-using BinaryNinja::StructureBuilder;
-using BinaryNinja::Type;
+namespace {
 
-Skald::Skald(BinaryNinja::BinaryView* view) : _view(view), accessor(view) {}
+// Number of type_info objects parsed between two checkpoints
+constexpr size_t RTTI_BATCH_SIZE = 4096;
 
-void Skald::run() {
-    // TODO add mutex to avoid multiple skald instances to run at the same time
+// Memory held by a parsed type_info record with its name and its bases, roughly. It sizes the
+// chunks of the streaming mode
+constexpr size_t TYPE_INFO_FOOTPRINT = 512;
+
+// Number of classes of a level processed between two checkpoints
+constexpr size_t VTABLE_BATCH_SIZE = 1024;
+
+// Largest number of vcall and vbase offsets preceding a secondary vtable of a group
+constexpr uint64_t MAX_VTABLE_OFFSETS = 256;
+
+// Largest object (in bytes) for which a vbase offset is considered plausible
+constexpr int64_t MAX_OFFSET = 1 << 24;
+
+// Limit on the base subobjects walked for a class, the non-virtual diamonds grow exponentially
+constexpr size_t MAX_SUBOBJECTS = 4096;
+
+bool contains(std::span<const class_id_t> ids, class_id_t id) {
+    return std::ranges::find(ids, id) != ids.end();
+}
+
+// Only the construction vtables have null slots, their destructors are left out. The vtables of a
+// class that may have some are scanned past them, and cut at the first one unless the VTTs tell
+// that they are construction vtables: a null slot followed by functions can be the null
+// `offset_to_top` and RTTI pointer of a vtable without RTTI
+void endAtNull(VtableRecord &vtable) {
+    auto it = std::ranges::find(vtable.functions, 0);
+    if (it == vtable.functions.end()) return;
+    vtable.functions.erase(it, vtable.functions.end());
+    vtable.signature = NO_SIGNATURE;  // Matched with the scanned slots
+}
+
+// Ranges the records are read within: the sections, or the segments of a binary without any
+RangeTable readableRanges(Backend &backend) {
+    std::vector<Section> sections = backend.getSections();
+    return RangeTable(sections.empty() ? backend.getSegments() : std::move(sections));
+}
+
+// A class in the spill file of the streaming mode: this header, the name then the bases
+struct SpilledClass {
+    address_t address;
+    uint32_t nameSize;
+    uint32_t baseCount;
+};
+
+void spillClass(SpillFile &spill, const TypeInfoRecord &record) {
+    spill.append(SpilledClass{record.address, static_cast<uint32_t>(record.name.size()),
+                              static_cast<uint32_t>(record.bases.size())});
+    spill.append(std::span(reinterpret_cast<const uint8_t *>(record.name.data()),
+                           record.name.size()));
+    for (size_t i = 0; i < record.bases.size(); ++i)
+        spill.append(ClassBase{record.bases[i].first, record.bases[i].second,
+                               i < record.baseOffsets.size() ? record.baseOffsets[i] : 0});
+}
+
+// The entries reference the mapping of the spill file
+std::vector<ClassEntry> readSpilledClasses(std::span<const uint8_t> data) {
+    std::vector<ClassEntry> classes;
+    for (size_t offset = 0; offset < data.size();) {
+        SpilledClass header;
+        std::memcpy(&header, data.data() + offset, sizeof(header));
+        offset += sizeof(header);
+        const std::string_view name(reinterpret_cast<const char *>(data.data() + offset),
+                                    header.nameSize);
+        offset += (header.nameSize + 7) & ~size_t{7};
+        const std::span bases(reinterpret_cast<const ClassBase *>(data.data() + offset),
+                              header.baseCount);
+        offset += sizeof(ClassBase) * header.baseCount;
+        classes.push_back({header.address, name, bases});
+    }
+    return classes;
+}
 
-    BinaryNinja::LogDebug("Searching for RTTI");
+}  // namespace
 
-    const std::string id = _view->BeginUndoActions();
+Skald::Skald(Backend &backend, size_t threads)
+    : backend(backend), abi(backend.getAbi()), accessor(backend), pool(threads) {}
+
+void Skald::run() {
+    dispatchAbi(this->abi, [&]<typename A>() { this->runFor<A>(); });
+}
+
+template <typename A>
+void Skald::runFor() {
+    SKALD_TIMED_SCOPE("run");
+    logDebug("Searching for RTTI");
 
     // Search for RTTI entry point by looking at the relocations
-    for (auto [start, end] : _view->GetRelocationRanges()) {
-        for (const auto& rel : _view->GetRelocationsAt(start)) {
-            const auto symbol = rel->GetSymbol();
+    this->checkpoint(Phase::RELOCATIONS, 0, 1);
+    {
+        SKALD_TIMED_SCOPE("relocation scan");
+        this->relocations = RelocationIndex(this->backend.getRelocations(), A::POINTER_SIZE);
+        this->sections = readableRanges(this->backend);
+    }
+    const auto &candidates = this->relocations.getTypeInfos();
+    this->checkpoint(Phase::RELOCATIONS, 1, 1);
+
+    // Fingerprint the binary and find the sections that did not change since the previous run
+    if (this->caching) {
+        SKALD_TIMED_SCOPE("fingerprint");
+        const std::vector<Section> sections = this->backend.getSections();
+        std::vector<Section> dataSections;
+        for (const Section &section : sections)
+            if (!(section.flags & SectionFlag::EXECUTABLE) &&
+                section.flags & SectionFlag::READABLE)
+                dataSections.push_back(section);
+        this->layoutHash = hashLayout(sections, this->backend.getSegments(), candidates);
+        this->sectionHashes = hashSections(this->backend, this->pool, dataSections);
+
+        if (this->previous.layoutHash == this->layoutHash) {
+            std::vector<Section> unchanged;
+            for (size_t i = 0; i < dataSections.size(); ++i)
+                if (std::ranges::find(this->previous.sectionHashes, this->sectionHashes[i]) !=
+                    this->previous.sectionHashes.end())
+                    unchanged.push_back(dataSections[i]);
+            logInfo("{} of {} data sections are unchanged since the previous run",
+                    unchanged.size(), dataSections.size());
+            this->unchanged = RangeTable(std::move(unchanged));
+
+            for (size_t i = 0; i < this->previous.vtables.size(); ++i)
+                this->previousVtables.emplace(this->previous.vtables[i].address, i);
+        } else if (!this->previous.sectionHashes.empty()) {
+            logInfo("The binary layout changed since the previous run, nothing is reused");
+        }
+    }
 
-            if (!symbol)  // No symbol for this relocation, just skip it
-                continue;
+    // Read the RTTI objects in parallel, one batch at a time. Nothing is modified in this phase,
+    // each worker only fills its own slot so that the result does not depend on the scheduling.
+    // In streaming mode the records are handed to the observer and spilled one chunk at a time,
+    // only the extent of the type_info objects is kept
+    std::shared_ptr<SpillFile> spill;
+    size_t chunkSize = candidates.size();
+    if (this->streaming) {
+        const std::filesystem::path &directory = this->streaming->spillDirectory;
+        spill = std::make_shared<SpillFile>(directory.empty()
+                                                ? std::filesystem::temp_directory_path()
+                                                : directory);
+        chunkSize = std::max(RTTI_BATCH_SIZE, this->streaming->memoryBudget / TYPE_INFO_FOOTPRINT);
+    }
+    std::vector<address_t> typeInfoStarts;
+    std::vector<address_t> typeInfoEnds;
+    for (size_t chunk = 0; chunk < candidates.size(); chunk += chunkSize) {
+        const auto chunkCandidates =
+            std::span(candidates).subspan(chunk, std::min(chunkSize, candidates.size() - chunk));
+        std::vector<TypeInfoRecord> records(chunkCandidates.size());
+        for (size_t first = 0; first < records.size(); first += RTTI_BATCH_SIZE) {
+            this->checkpoint(Phase::RTTI, chunk + first, candidates.size());
+            SKALD_TIMED_SCOPE("rtti parse");
+            const size_t count = std::min(RTTI_BATCH_SIZE, records.size() - first);
+            this->pool.parallelFor(count, [&](size_t j) {
+                const size_t i = first + j;
+                const auto [address, type] = chunkCandidates[i];
+                auto it = std::ranges::lower_bound(this->previous.typeInfos, address, {},
+                                                   &TypeInfoRecord::address);
+                if (it != this->previous.typeInfos.end() && it->address == address &&
+                    it->type == type &&
+                    this->isUnchanged(address, address + typeInfoSize<A>(type, it->baseCount)) &&
+                    this->isUnchanged(it->nameAddress, it->nameAddress + it->name.size() + 1))
+                    records[i] = *it;
+                else
+                    records[i] = this->parseRTTI<A>(address, type);
+            });
+        }
 
-            this->parseRTTI(start, symbol->GetRawName());
+        for (const TypeInfoRecord &record : records) {
+            typeInfoStarts.push_back(record.address);
+            typeInfoEnds.push_back(record.address + typeInfoSize<A>(record.type, record.baseCount));
+        }
+        if (spill) {
+            SKALD_TIMED_SCOPE("rtti spill");
+            for (const TypeInfoRecord &record : records) spillClass(*spill, record);
+            if (this->observer) this->observer->typeInfosAdded(*this, records);
+        } else {
+            this->typeinfoClasses = std::move(records);
+        }
+    }
+    this->checkpoint(Phase::RTTI, candidates.size(), candidates.size());
+
+    // Build the inheritance graph following the address order, exactly like a serial run. It is
+    // frozen once complete, the later phases only read it
+    {
+        SKALD_TIMED_SCOPE("graph build");
+        if (spill) {
+            spill->map();
+            this->inheritanceGraph = CompactGraph(readSpilledClasses(spill->data()), spill);
+        } else {
+            std::vector<ClassBase> bases;
+            for (const TypeInfoRecord &record : this->typeinfoClasses)
+                for (size_t i = 0; i < record.bases.size(); ++i)
+                    bases.push_back({record.bases[i].first, record.bases[i].second,
+                                     i < record.baseOffsets.size() ? record.baseOffsets[i] : 0});
+            std::vector<ClassEntry> classes;
+            size_t first = 0;
+            for (const TypeInfoRecord &record : this->typeinfoClasses) {
+                classes.push_back({record.address, record.name,
+                                   std::span(bases).subspan(first, record.bases.size())});
+                first += record.bases.size();
+            }
+            this->inheritanceGraph = CompactGraph(classes);
         }
     }
+    if (this->observer && !spill) this->observer->typeInfosAdded(*this, this->typeinfoClasses);
+    this->completed(Phase::RTTI);
 
     // Parse vtables
-    BinaryNinja::LogDebug("Searching for vtables");
-
-    // Queue for BFS
-    std::queue<node_identifier_t> queue =
-        this->inheritanceGraph.getRoots() |
-        std::views::transform([](const Node& node) -> node_identifier_t { return node.id; }) |
-        std::ranges::to<std::queue>();
-
-    // Node parents' counter
-    std::unordered_map<node_identifier_t, size_t> counters;
-
-    // Each object that has a RTTI can potentially have a vtable, hence do a BFS on the class
-    // inheritance polytree. It is mandatory that the parents are accessed before the children
-    while (!queue.empty()) {
-        // Pop current node
-        const Node& node = this->inheritanceGraph.getNodeById(queue.front());
-        queue.pop();
-
-        // Find the vtable for the current node by looking at the data references that are not part
-        // of a type_info struct
-        for (uint64_t addr : _view->GetDataReferences(node.rttiAddress)) {
-            DataVariable var;
-            _view->GetDataVariableAtAddress(addr, var);
-
-            // RTTI type previously defined. Skip it
-            if (var.type->GetString().find("_class_type") != std::string::npos) continue;
-
-            // Create vtable struct
-            this->parseVtable(addr);
-        }
+    logDebug("Searching for vtables");
+    const size_t nodeCount = this->inheritanceGraph.size();
+    this->checkpoint(Phase::VTABLES, 0, nodeCount);
+
+    // Locate all the potential vtables at once
+    {
+        SKALD_TIMED_SCOPE("vtable discovery");
+        this->vtableCandidates =
+            VtableIndex(A{}, this->backend, this->pool, typeInfoStarts, typeInfoEnds,
+                        this->unchanged, this->previous.vtableCandidates);
+
+        // A vtable ends at the latest where another vtable (its `offset_to_top`) or a type_info
+        // starts
+        std::vector<address_t> stops = typeInfoStarts;
+        for (address_t slot : this->vtableCandidates.getSlots())
+            stops.push_back(slot - A::POINTER_SIZE);
+        this->vtableScanner = VtableScanner(this->backend, std::move(stops));
+    }
 
-        // Add the children to the queue
-        for (const auto& [childId, e_flags] : node.children) {
-            // On the first encounter initialize the parents' counter
-            if (!counters.contains(childId))
-                counters[childId] = this->inheritanceGraph.getNodeById(childId).parents.size();
+    // Each object that has a RTTI can potentially have vtables. It is mandatory that the parents
+    // are accessed before the children: the levels of the polytree are processed in order, the
+    // classes of a level in parallel
+    size_t visited = 0;
+    std::vector<std::pair<class_id_t, vtable_groups_t>> deferred;
+    for (size_t level = 0; level < this->inheritanceGraph.getLevelCount(); ++level) {
+        const auto classes = this->inheritanceGraph.getLevel(level);
+        const size_t first = this->vtables.size();
+
+        for (size_t start = 0; start < classes.size(); start += VTABLE_BATCH_SIZE) {
+            this->checkpoint(Phase::VTABLES, visited, nodeCount);
+            SKALD_TIMED_SCOPE("vtable sizing");
+            const auto batch =
+                classes.subspan(start, std::min(VTABLE_BATCH_SIZE, classes.size() - start));
+
+            // Create the vtable structs for the current nodes
+            std::vector<vtable_groups_t> found(batch.size());
+            this->pool.parallelFor(
+                batch.size(), [&](size_t i) { found[i] = this->parseVtableGroups<A>(batch[i]); });
+
+            // Merged in the topological order, the result does not depend on the scheduling. A
+            // class with virtual bases can also have construction vtables, the VTTs tell which
+            // group is its own
+            for (size_t i = 0; i < batch.size(); ++i) {
+                if (found[i].size() > 1 && !this->getVirtualBases(batch[i]).empty()) {
+                    deferred.emplace_back(batch[i], std::move(found[i]));
+                    continue;
+                }
+                for (auto &group : found[i]) {
+                    for (VtableRecord &vtable : group) {
+                        endAtNull(vtable);
+                        this->markCached(vtable);
+                        this->vtables.push_back(std::move(vtable));
+                    }
+                }
+            }
+            visited += batch.size();
 
-            --counters[childId];         // Reduce the number of remeaning parents by one
-            if (counters[childId] == 0)  // No parents left, it can be safely explored
-                queue.push(childId);
+            // The vtables held are bounded by a batch in streaming mode, by a level otherwise
+            if (this->streaming) this->vtablesAdded(first);
         }
+
+        this->vtablesAdded(first);
     }
 
     // Parse VTT
+    {
+        SKALD_TIMED_SCOPE("vtt parse");
+        const size_t first = this->vtables.size();
+        this->parseVtts<A>(deferred);
+        this->vtablesAdded(first);
+    }
+
+    this->checkpoint(Phase::VTABLES, nodeCount, nodeCount);
+    this->completed(Phase::VTABLES);
 
-    _view->CommitUndoActions(id);
+    // Everything useful has been copied by now
+    this->previous = ResultCache();
+    this->previousVtables.clear();
+    this->flushedVtables = {};
 }
 
-void Skald::parseVtable(uint64_t typeInfoPointer) {
-    uint64_t rttiAddr = std::any_cast<uint64_t>(
-        this->accessor.readValue(Type::IntegerType(8, false, "uin64_t"), typeInfoPointer));
-    auto curr_section = _view->GetSectionsAt(typeInfoPointer);
-
-    uint64_t vtableStart = typeInfoPointer + 8;
-
-    try {
-        Node& node = this->inheritanceGraph.getNodeByAddr(rttiAddr);
-
-        // if there are no children or there is only one and it is public non-virtual
-        if (node.isLeaf() ||
-            (node.children.size() == 1 && node.children[0].second & EdgeFlag::PUBLIC &&
-             !(node.children[0].second & EdgeFlag::VIRTUAL))) {
-            // offset_to_top
-            // RTTI pointer
-            // vtable
-            uint64_t method = std::any_cast<uint64_t>(
-                this->accessor.readValue(Type::IntegerType(8, false, "uint64_t"), vtableStart));
-            uint32_t vtableSize = 0;
-
-            // There is no reliable way of knowing how large a vtable is but to rely on heuristics
-            while (_view->IsOffsetExecutable(method)) {
-                ++vtableSize;
-
-                // Read next method in vtable
-                uint64_t next_method_ptr = vtableStart + 8 * vtableSize;
-                if (!_view->IsValidOffset(next_method_ptr) ||
-                    !_view->IsOffsetReadable(next_method_ptr) ||
-                    _view->GetSectionsAt(next_method_ptr) != curr_section)
-                    break;
-                method = std::any_cast<uint64_t>(this->accessor.readValue(
-                    Type::IntegerType(8, false, "uint64_t"), next_method_ptr));
+bool Skald::resolve(address_t address) {
+    return dispatchAbi(this->abi, [&]<typename A>() { return this->resolveFor<A>(address); });
+}
+
+template <typename A>
+bool Skald::resolveFor(address_t address) {
+    SKALD_TIMED_SCOPE("resolve");
+    if (!this->lazy.ready) {
+        SKALD_TIMED_SCOPE("relocation scan");
+        this->relocations = RelocationIndex(this->backend.getRelocations(), A::POINTER_SIZE);
+        this->sections = readableRanges(this->backend);
+        this->lazy.ready = true;
+    }
+
+    const auto rttiAddress = this->findTypeInfo<A>(address);
+    std::vector<address_t> added;
+    if (!rttiAddress || !this->parseLazy<A>(*rttiAddress, added)) {
+        logDebug("No class found at {:#x}", address);
+        return false;
+    }
+
+    // Each sweep collects the RTTI slots of the classes added since the previous one and the
+    // classes deriving from the current generation, which form the next one. Their bases are
+    // parsed on the way, only the classes reached from `address` are ever searched
+    std::vector<address_t> generation;
+    if (!this->lazy.expanded.contains(*rttiAddress)) generation.push_back(*rttiAddress);
+    std::vector<address_t> classes;
+    while (!added.empty() || !generation.empty()) {
+        SKALD_TIMED_SCOPE("lazy sweep");
+        const std::unordered_set<address_t> sweeping(added.begin(), added.end());
+        const std::unordered_set<address_t> expanding(generation.begin(), generation.end());
+        std::vector<address_t> targets(sweeping.begin(), sweeping.end());
+        targets.insert(targets.end(), expanding.begin(), expanding.end());
+        std::ranges::sort(targets);
+        targets.erase(std::ranges::unique(targets).begin(), targets.end());
+        classes.insert(classes.end(), added.begin(), added.end());
+        this->lazy.expanded.insert(generation.begin(), generation.end());
+        added.clear();
+        generation.clear();
+
+        for (const auto &[location, value] : findPointers<A>(this->backend, this->pool, targets)) {
+            bool inside = false;
+            const auto derived = this->getDerivedAt<A>(location, inside);
+            if (derived && expanding.contains(value)) {
+                if (this->parseLazy<A>(*derived, added) && !this->lazy.expanded.contains(*derived))
+                    generation.push_back(*derived);
+            } else if (!inside && sweeping.contains(value)) {
+                this->lazy.pointers.emplace_back(location, value);
             }
+        }
+    }
 
-            BinaryNinja::LogInfo("vtable size = %d", vtableSize);
-            std::string className = this->accessor.readString(rttiAddr, "__type_name");
-            auto it = className.begin();
-            while (it != className.end() && *it >= '0' && *it <= '9') ++it;
-            std::string_view classNameDemangled = std::string_view(it, className.end());
-            auto type = this->createVtableType(classNameDemangled, vtableStart, vtableSize);
+    if (!classes.empty()) this->sizeVtablesLazy<A>(classes);
+    logInfo("Resolved the class at {:#x}, {} new classes", *rttiAddress, classes.size());
+    return true;
+}
 
-            // Assign variable
-            _view->DefineUserDataVariable(vtableStart, type->WithConfidence(0xff));
+ResultCache Skald::getResultCache() const {
+    ResultCache cache{this->layoutHash, this->sectionHashes, this->typeinfoClasses, {},
+                      this->vtables};
+    const auto rttiAddresses = this->vtableCandidates.getRttiAddresses();
+    const auto slots = this->vtableCandidates.getSlots();
+    for (size_t i = 0; i < slots.size(); ++i)
+        cache.vtableCandidates.emplace_back(rttiAddresses[i], slots[i]);
+    return cache;
+}
 
-            // Create user symbol
-            auto* symbol =
-                new BinaryNinja::Symbol(BNSymbolType::DataSymbol,
-                                        fmt::format("vtable_{}", classNameDemangled), vtableStart);
-            _view->DefineUserSymbol(symbol);
+void Skald::checkpoint(Phase phase, size_t done, size_t total) {
+    if (!this->observer) return;
+    if (this->observer->isCancelled()) throw RunCancelled();
+    this->observer->progress(phase, done, total);
+}
+
+void Skald::completed(Phase phase) {
+    if (this->observer) this->observer->phaseCompleted(*this, phase);
+}
 
-            BinaryNinja::LogDebug("Found vtable at addr 0x%lx for RTTI at address 0x%lx (%s)",
-                                  vtableStart, rttiAddr, className.c_str());
+void Skald::vtablesAdded(size_t first) {
+    if (this->observer && first < this->vtables.size())
+        this->observer->vtablesAdded(*this, std::span(this->vtables).subspan(first));
+    if (!this->streaming) return;
 
-        } else {
-            BinaryNinja::LogDebug("Found vtable at addr 0x%lx for RTTI at address 0x%lx",
-                                  vtableStart, rttiAddr);
+    // Only the address points are kept, for the VTTs
+    for (const VtableRecord &vtable : this->vtables)
+        this->flushedVtables.push_back({vtable.address, vtable.rttiAddress, vtable.offsetToTop == 0,
+                                        vtable.kind == VtableKind::CONSTRUCTION});
+    this->vtables.clear();
+}
+
+bool Skald::isUnchanged(address_t start, address_t end) const {
+    const Section *section = this->unchanged.find(start);
+    return section && end <= section->end;
+}
 
-            BinaryNinja::LogInfo("Node at address %p has %lu children", (void*)rttiAddr,
-                                 node.children.size());
+std::vector<class_id_t> Skald::getVirtualBases(class_id_t id) const {
+    std::vector<class_id_t> virtualBases;
+    std::vector<class_id_t> pending{id};
+    std::vector<class_id_t> seen{id};
+    while (!pending.empty() && seen.size() < MAX_SUBOBJECTS) {
+        const class_id_t current = pending.back();
+        pending.pop_back();
+        for (const CompactEdge &edge : this->inheritanceGraph.getChildren(current)) {
+            if (edge.flags & EdgeFlag::VIRTUAL && !contains(virtualBases, edge.target))
+                virtualBases.push_back(edge.target);
+            if (contains(seen, edge.target)) continue;
+            seen.push_back(edge.target);
+            pending.push_back(edge.target);
         }
-    } catch (const std::invalid_argument& e) {
-        BinaryNinja::LogWarn("Node at address %p is not present in graph", (void*)rttiAddr);
     }
+    return virtualBases;
 }
 
-Ref<Type> Skald::createVtableType(const std::string_view& className, uint64_t startAddr,
-                                  uint32_t size) {
-    StructureBuilder vtableBuilder;
-    vtableBuilder.SetPropagateDataVariableReferences(true);  // same as __vtable or __data_var_ref
-
-    // Add each function pointer
-    for (uint64_t funPtr = startAddr; funPtr < startAddr + 8 * size; funPtr += 8) {
-        uint64_t addr = std::any_cast<uint64_t>(
-            this->accessor.readValue(Type::IntegerType(8, false, "uint64_t"), funPtr));
-        // Get function at current address
-        auto functions = _view->GetAnalysisFunctionsForAddress(addr);
-        if (functions.empty()) {  // No function defined. Create it
-            BinaryNinja::LogInfo("No functions at addr %p. Creating one for default platform",
-                                 (void*)addr);
-            functions.push_back(_view->CreateUserFunction(_view->GetDefaultPlatform(), addr));
-        } else if (functions.size() > 1) {  // More than one function, pick the first one
-            BinaryNinja::LogWarn(
-                "More than one function defined at address %p. Optimistically picking the first "
-                "one",
-                (void*)addr);
+bool Skald::isBaseOf(class_id_t base, class_id_t id) const {
+    std::vector<class_id_t> pending{id};
+    std::vector<class_id_t> seen{id};
+    while (!pending.empty() && seen.size() < MAX_SUBOBJECTS) {
+        const class_id_t current = pending.back();
+        pending.pop_back();
+        for (const CompactEdge &edge : this->inheritanceGraph.getChildren(current)) {
+            if (edge.target == base) return true;
+            if (contains(seen, edge.target)) continue;
+            seen.push_back(edge.target);
+            pending.push_back(edge.target);
         }
-
-        // Recover previous type definition for the function
-        auto functionType = functions[0]->GetType();
-        auto retType = functionType->GetChildType();
-        auto params = functionType->GetParameters();
-        // Use a `void * this` for the time being
-        if (params.empty()) params.resize(1);
-        params[0] = {"this", Type::PointerType(_view->GetDefaultArchitecture(), Type::VoidType())};
-
-        // Create the new function type
-        auto newFunType = Type::FunctionType(
-            retType, _view->GetDefaultPlatform()->GetDefaultCallingConvention(), params);
-
-        // Adding method to the vtable
-        BinaryNinja::LogDebug("Adding function `%s (*%s)(void *this, ...)`",
-                              retType->GetString().c_str(),
-                              functions[0]->GetSymbol()->GetShortName().c_str());
-        vtableBuilder.AddMember(Type::PointerType(_view->GetDefaultArchitecture(), newFunType),
-                                functions[0]->GetSymbol()->GetShortName());
     }
-
-    // Create the type `vtable_for_className`
-    Ref<Structure> vtableStruct = vtableBuilder.Finalize();
-    QualifiedName typeName = QualifiedName(fmt::format("vtable_{}_t", className));
-    _view->DefineUserType(typeName, Type::StructureType(vtableStruct));
-
-    return _view->GetTypeByName(typeName);
+    return false;
 }
 
-Ref<Type> Skald::defineClassType() {
-    QualifiedName typeName = QualifiedName("__class_type");
-    const auto type = _view->GetTypeByName(typeName);
-    if (!!type) return type;  // Define it once
-
-    StructureBuilder typeInfoBuilder;
-    typeInfoBuilder.AddMember(
-        Type::PointerType(this->_view->GetDefaultArchitecture(), Type::VoidType()), "type_info");
-    typeInfoBuilder.AddMember(Type::PointerType(this->_view->GetDefaultArchitecture(),
-                                                Type::IntegerType(1, false, "char")),
-                              "__type_name");
-    Ref<Structure> typeInfoStruct = typeInfoBuilder.Finalize();
-    this->_view->DefineUserType(typeName, Type::StructureType(typeInfoStruct));
-
-    return _view->GetTypeByName(typeName);
+uint32_t Skald::matchSignature(class_id_t id) const {
+    std::vector<std::string_view> bases;
+    for (const CompactEdge &edge : this->inheritanceGraph.getChildren(id))
+        bases.push_back(this->inheritanceGraph.getName(edge.target));
+    return this->signatures->match(this->inheritanceGraph.getName(id), bases);
 }
 
-Ref<Type> Skald::defineBaseClass() {
-    QualifiedName typeName = QualifiedName("__base_class_type_info");
-    const auto type = _view->GetTypeByName(typeName);
-    if (!!type) return type;  // Define it once
-
-    StructureBuilder typeBuilder;
-    typeBuilder.AddMember(Type::PointerType(_view->GetDefaultArchitecture(), Type::VoidType()),
-                          "__base_type");
-    typeBuilder.AddMember(Type::IntegerType(8, false, "uint64_t"), "__offset_flags");
-    Ref<Structure> typeStruct = typeBuilder.Finalize();
-    _view->DefineUserType(typeName, Type::StructureType(typeStruct));
+template <typename A>
+Skald::vtable_groups_t Skald::parseVtableGroups(class_id_t id) {
+    constexpr uint64_t POINTER_SIZE = A::POINTER_SIZE;
+    const address_t rttiAddr = this->inheritanceGraph.getAddress(id);
+    const std::string_view name = this->inheritanceGraph.getName(id);
+    const size_t virtualBases = this->getVirtualBases(id).size();
+
+    // A group starts with the primary vtable (`offset_to_top` 0), preceded by the vbase offsets of
+    // the class. The secondary vtables follow right after it, each one preceded by its vcall and
+    // vbase offsets
+    vtable_groups_t groups;
+    address_t groupEnd = 0;  // End of the last vtable of the current group
+    for (address_t slot : this->vtableCandidates.getCandidates(rttiAddr)) {
+        VtableRecord vtable{.address = slot + POINTER_SIZE,
+                            .rttiAddress = rttiAddr,
+                            .className = std::string(name)};
+        vtable.offsetToTop = this->accessor.readOffset<A>(slot - POINTER_SIZE);
+
+        size_t offsetCount = virtualBases;
+        if (vtable.offsetToTop != 0) {
+            if (groups.empty() || slot - POINTER_SIZE < groupEnd ||
+                slot - POINTER_SIZE - groupEnd > POINTER_SIZE * MAX_VTABLE_OFFSETS) {
+                logDebug("Vtable at {:#x} ({}) is not part of a group", vtable.address, name);
+                continue;
+            }
+            vtable.kind = VtableKind::SECONDARY;
+            offsetCount = (slot - POINTER_SIZE - groupEnd) / POINTER_SIZE;
+        }
+        std::vector<uint64_t> offsets(offsetCount);
+        this->accessor.readPointers<A>(slot - POINTER_SIZE * (offsetCount + 1), offsets);
+        for (uint64_t offset : offsets)
+            vtable.offsets.push_back(static_cast<typename A::offset_t>(offset));
+
+        // A known class only takes the symbols of the reference build if it has as many slots,
+        // another version of the class would get them on the wrong slots
+        if (vtable.kind == VtableKind::PRIMARY && this->signatures)
+            vtable.signature = this->matchSignature(id);
+
+        // The extent only depends on the content of the section holding the vtable. The previous
+        // run may have had another pack, the vtables of the known classes are always scanned
+        auto it = this->previousVtables.find(vtable.address);
+        if (vtable.signature == NO_SIGNATURE && it != this->previousVtables.end() &&
+            this->previous.vtables[it->second].rttiAddress == rttiAddr &&
+            this->isUnchanged(slot, vtable.address)) {
+            vtable.functions = this->previous.vtables[it->second].functions;
+        } else {
+            vtable.functions =
+                this->vtableScanner.scan<A>(this->accessor, slot, virtualBases != 0);
+        }
+        if (vtable.signature != NO_SIGNATURE &&
+            this->signatures->getSlotCount(vtable.signature) != vtable.functions.size())
+            vtable.signature = NO_SIGNATURE;
+
+        logDebug("Found vtable at addr {:#x} for RTTI at address {:#x} ({}), {} functions",
+                 vtable.address, rttiAddr, name, vtable.functions.size());
+        groupEnd = vtable.address + POINTER_SIZE * vtable.functions.size();
+        if (vtable.kind == VtableKind::PRIMARY) groups.emplace_back();
+        groups.back().push_back(std::move(vtable));
+    }
 
-    return _view->GetTypeByName(typeName);
+    for (auto &group : groups) this->resolveSubobjects<A>(id, group);
+    return groups;
 }
 
-Ref<Type> Skald::defineVmiClassType(uint32_t base_count) {
-    QualifiedName typeName = QualifiedName(fmt::format("__vmi_class_type_{}", base_count));
-    const auto type = _view->GetTypeByName(typeName);
-    if (!!type) return type;  // Define it once
-
-    // Define inner struct
-    const auto baseClassTypeInfo = this->defineBaseClass();
-
-    StructureBuilder typeInfoBuilder;
-    typeInfoBuilder.AddMember(
-        Type::PointerType(this->_view->GetDefaultArchitecture(), Type::VoidType()), "type_info");
-    typeInfoBuilder.AddMember(Type::PointerType(this->_view->GetDefaultArchitecture(),
-                                                Type::IntegerType(1, false, "char")),
-                              "__type_name");
-    typeInfoBuilder.AddMember(Type::IntegerType(4, false, "unsigned int"), "__flags");
-    typeInfoBuilder.AddMember(Type::IntegerType(4, false, "unsigned int"), "__base_count");
-    typeInfoBuilder.AddMember(Type::ArrayType(baseClassTypeInfo, base_count), "__base_info");
-    Ref<Structure> typeInfoStruct = typeInfoBuilder.Finalize();
-    this->_view->DefineUserType(typeName, Type::StructureType(typeInfoStruct));
-
-    return _view->GetTypeByName(typeName);
+template <typename A>
+void Skald::resolveSubobjects(class_id_t id, std::vector<VtableRecord> &group) {
+    if (group.size() < 2) return;
+
+    // Offsets of the base subobjects in preorder, the outermost class comes first when several
+    // share an offset. A virtual base is placed by its vbase offset, read from the vtable of the
+    // subobject inheriting it, the non-virtual ones by the offset from `__offset_flags`
+    std::vector<std::pair<int64_t, class_id_t>> subobjects;
+    std::vector<class_id_t> virtualBases;
+    std::vector<std::pair<int64_t, class_id_t>> pending{{0, id}};
+    while (!pending.empty() && subobjects.size() < MAX_SUBOBJECTS) {
+        const auto [offset, current] = pending.back();
+        pending.pop_back();
+
+        const auto children = this->inheritanceGraph.getChildren(current);
+        const size_t first = pending.size();
+        for (const CompactEdge &edge : children) {
+            int64_t baseOffset = offset + edge.offset;
+            if (edge.flags & EdgeFlag::VIRTUAL) {
+                if (contains(virtualBases, edge.target)) continue;
+                auto vtable = std::ranges::find(group, -offset, &VtableRecord::offsetToTop);
+                if (vtable == group.end()) continue;
+                const int64_t vbaseOffset =
+                    this->accessor.readOffset<A>(vtable->address + edge.offset);
+                // Negative when the virtual base is laid out before the subobject
+                baseOffset = offset + vbaseOffset;
+                if (baseOffset < 0 || baseOffset >= MAX_OFFSET) continue;
+                virtualBases.push_back(edge.target);
+            }
+            subobjects.emplace_back(baseOffset, edge.target);
+            pending.emplace_back(baseOffset, edge.target);
+        }
+        std::reverse(pending.begin() + first, pending.end());  // Left to right
+    }
+
+    for (VtableRecord &vtable : group) {
+        auto it = std::ranges::find(subobjects, -vtable.offsetToTop,
+                                    &std::pair<int64_t, class_id_t>::first);
+        if (vtable.offsetToTop != 0 && it != subobjects.end())
+            vtable.subobject = this->inheritanceGraph.getName(it->second);
+    }
 }
 
-Ref<Type> Skald::defineSiClassType() {
-    QualifiedName typeName = QualifiedName("__si_class_type");
-    const auto type = _view->GetTypeByName(typeName);
-    if (!!type) return type;  // Define it once
-
-    StructureBuilder typeInfoBuilder;
-    typeInfoBuilder.AddMember(Type::PointerType(_view->GetDefaultArchitecture(), Type::VoidType()),
-                              "type_info");
-    typeInfoBuilder.AddMember(
-        Type::PointerType(_view->GetDefaultArchitecture(), Type::IntegerType(1, false, "char")),
-        "__type_name");
-    typeInfoBuilder.AddMember(Type::PointerType(_view->GetDefaultArchitecture(), Type::VoidType()),
-                              "__base_type");
-    Ref<Structure> typeInfoStruct = typeInfoBuilder.Finalize();
-    _view->DefineUserType(typeName, Type::StructureType(typeInfoStruct));
-
-    return _view->GetTypeByName(typeName);
+std::optional<TypeInfo> Skald::getClassTypeInfo(address_t address) const {
+    const auto &typeInfos = this->relocations.getTypeInfos();
+    auto it = std::ranges::lower_bound(typeInfos, address, {},
+                                       &std::pair<address_t, TypeInfo>::first);
+    if (it == typeInfos.end() || it->first != address) return std::nullopt;
+    if (it->second != TypeInfo::CLASS_TYPE_INFO && it->second != TypeInfo::SI_CLASS_TYPE_INFO &&
+        it->second != TypeInfo::VMI_CLASS_TYPE_INFO)
+        return std::nullopt;
+    return it->second;
 }
 
-Ref<Type> Skald::definePbaseClassType() {
-    QualifiedName typeName = QualifiedName("__pbase_class_type");
-    const auto type = _view->GetTypeByName(typeName);
-    if (!!type) return type;  // Define it once
-
-    StructureBuilder typeInfoBuilder;
-    typeInfoBuilder.AddMember(Type::PointerType(_view->GetDefaultArchitecture(), Type::VoidType()),
-                              "type_info");
-    typeInfoBuilder.AddMember(
-        Type::PointerType(_view->GetDefaultArchitecture(), Type::IntegerType(1, false, "char")),
-        "__type_name");
-    typeInfoBuilder.AddMember(Type::IntegerType(4, false, "unsigned int"), "__flags");
-    typeInfoBuilder.AddMember(Type::PointerType(_view->GetDefaultArchitecture(), Type::VoidType()),
-                              "__pointee");
-    Ref<Structure> typeInfoStruct = typeInfoBuilder.Finalize();
-    _view->DefineUserType(typeName, Type::StructureType(typeInfoStruct));
-
-    return _view->GetTypeByName(typeName);
+template <typename A>
+std::optional<address_t> Skald::findTypeInfo(address_t address) {
+    if (this->getClassTypeInfo(address)) return address;
+    for (address_t slot : {address - A::POINTER_SIZE, address}) {
+        const address_t rttiAddress = this->accessor.readPointer<A>(slot);
+        if (this->getClassTypeInfo(rttiAddress)) return rttiAddress;
+    }
+
+    // From the first vcall or vbase offset to the last function
+    for (const VtableRecord &vtable : this->vtables)
+        if (address >= vtable.address - A::POINTER_SIZE * (vtable.offsets.size() + 2) &&
+            address < vtable.address + A::POINTER_SIZE * vtable.functions.size())
+            return vtable.rttiAddress;
+    return std::nullopt;
 }
 
-Ref<Type> Skald::definePointerToMemberClassType() {
-    QualifiedName typeName = QualifiedName("__pointer_to_member_type_info");
-    const auto type = _view->GetTypeByName(typeName);
-    if (!!type) return type;  // Define it once
+template <typename A>
+bool Skald::parseLazy(address_t address, std::vector<address_t> &added) {
+    if (this->lazy.parsed.contains(address)) return true;
+    const auto type = this->getClassTypeInfo(address);
+    if (!type) return false;
+
+    TypeInfoRecord record = this->parseRTTI<A>(address, *type);
+    this->lazy.graph.addNode(record.name, record.address, record.bases, record.baseOffsets);
+    this->lazy.parsed.insert(address);
+    added.push_back(address);
 
-    StructureBuilder typeInfoBuilder;
-    typeInfoBuilder.SetBaseStructures({BaseStructure(this->definePbaseClassType(), 0)});
-    typeInfoBuilder.AddMember(Type::PointerType(_view->GetDefaultArchitecture(), Type::VoidType()),
-                              "__context");
-    Ref<Structure> typeInfoStruct = typeInfoBuilder.Finalize();
-    _view->DefineUserType(typeName, Type::StructureType(typeInfoStruct));
+    // The bases defined in other modules stay as nameless nodes, as in `run()`
+    for (const auto &[base, flags] : record.bases) this->parseLazy<A>(base, added);
+    this->typeinfoClasses.push_back(std::move(record));
+    return true;
+}
 
-    return _view->GetTypeByName(typeName);
+template <typename A>
+std::optional<address_t> Skald::getDerivedAt(address_t address, bool &inside) {
+    typedef VmiClassTypeInfoLayout<A> vmi_t;
+    typedef BaseClassTypeInfoLayout<A> base_t;
+    const auto &typeInfos = this->relocations.getTypeInfos();
+    auto it = std::ranges::upper_bound(typeInfos, address, {},
+                                       &std::pair<address_t, TypeInfo>::first);
+    inside = false;
+    if (it == typeInfos.begin()) return std::nullopt;
+    const auto [start, type] = *std::prev(it);
+
+    uint32_t baseCount = 0;
+    if (type == TypeInfo::VMI_CLASS_TYPE_INFO)
+        baseCount = fromOrder<A::ORDER>(
+            this->accessor.readValue<uint32_t>(start + vmi_t::baseCount::offset));
+    inside = address < start + typeInfoSize<A>(type, baseCount);
+    if (!inside) return std::nullopt;
+
+    const uint64_t offset = address - start;
+    if (type == TypeInfo::SI_CLASS_TYPE_INFO &&
+        offset == SiClassTypeInfoLayout<A>::baseType::offset)
+        return start;
+    if (type == TypeInfo::VMI_CLASS_TYPE_INFO && offset >= vmi_t::BASE_INFO &&
+        (offset - vmi_t::BASE_INFO) % base_t::SIZE == base_t::baseType::offset)
+        return start;
+    return std::nullopt;
 }
 
-void Skald::parseRTTI(unsigned long address, const std::string& symbolName) {
-    // Mangled names of type_info derived classes
-    using namespace std::literals;
-    static constexpr const std::array<std::pair<std::string_view, TypeInfo>, 10> type_info_classes{{
-        {"_ZTVN10__cxxabiv116__enum_type_infoE"sv, TypeInfo::ENUM_TYPE_INFO},
-        {"_ZTVN10__cxxabiv117__class_type_infoE"sv, TypeInfo::CLASS_TYPE_INFO},
-        {"_ZTVN10__cxxabiv117__array_type_infoE"sv, TypeInfo::ARRAY_TYPE_INFO},
-        {"_ZTVN10__cxxabiv121__vmi_class_type_infoE"sv, TypeInfo::VMI_CLASS_TYPE_INFO},
-        {"_ZTVN10__cxxabiv120__si_class_type_infoE"sv, TypeInfo::SI_CLASS_TYPE_INFO},
-        {"_ZTVN10__cxxabiv120__function_type_infoE"sv, TypeInfo::FUNCTION_TYPE_INFO},
-        {"_ZTVN10__cxxabiv119__pointer_type_infoE"sv, TypeInfo::POINTER_TYPE_INFO},
-        {"_ZTVN10__cxxabiv117__pbase_type_infoE"sv, TypeInfo::PBASE_TYPE_INFO},
-        {"_ZTVN10__cxxabiv123__fundamental_type_infoE"sv, TypeInfo::FUNDAMENTAL_TYPE_INFO},
-        {"_ZTVN10__cxxabiv129__pointer_to_member_type_infoE"sv,
-         TypeInfo::POINTER_TO_MEMBER_TYPE_INFO},
-    }};
-
-    if (symbolName.find("_ZTVN10__cxxabiv1") == std::string::npos) return;  // Not a type_info class
-
-    TypeInfo derivedType = TypeInfo::UNSUPPORTED;
-    for (const auto& type_info : type_info_classes)
-        if (symbolName == type_info.first) derivedType = type_info.second;
-
-    this->typeinfoClasses.push_back(address);
-
-    Ref<Type> type;
-    switch (derivedType) {
-        case CLASS_TYPE_INFO:
-        case FUNDAMENTAL_TYPE_INFO:
-        case ARRAY_TYPE_INFO:
-        case ENUM_TYPE_INFO:
-        case FUNCTION_TYPE_INFO:
-            type = this->defineClassType();
-            break;
-        case VMI_CLASS_TYPE_INFO: {
-            // Read uint32_t at address + 0x14, that's base_count
-            uint32_t base_count;
-            _view->Read(static_cast<void*>(&base_count), address + 0x14, 4);
-            type = this->defineVmiClassType(base_count);
-            break;
+template <typename A>
+void Skald::sizeVtablesLazy(std::span<const address_t> addresses) {
+    SKALD_TIMED_SCOPE("vtable sizing");
+
+    // Rebuilt from all the classes known so far, the records keep addresses and not ids
+    this->inheritanceGraph = CompactGraph(this->lazy.graph);
+    this->vtableCandidates = VtableIndex(A{}, this->backend, this->lazy.pointers);
+    std::vector<address_t> stops;
+    for (const auto &[address, type] : this->relocations.getTypeInfos()) stops.push_back(address);
+    for (address_t slot : this->vtableCandidates.getSlots())
+        stops.push_back(slot - A::POINTER_SIZE);
+    this->vtableScanner = VtableScanner(this->backend, std::move(stops));
+
+    // Derived classes first, as in `run()`
+    const std::unordered_set<address_t> wanted(addresses.begin(), addresses.end());
+    std::vector<class_id_t> classes;
+    for (class_id_t id : this->inheritanceGraph.getTopologicalOrder())
+        if (wanted.contains(this->inheritanceGraph.getAddress(id))) classes.push_back(id);
+    std::vector<vtable_groups_t> found(classes.size());
+    this->pool.parallelFor(classes.size(),
+                           [&](size_t i) { found[i] = this->parseVtableGroups<A>(classes[i]); });
+
+    const size_t first = this->vtables.size();
+    bool virtualInheritance = false;
+    std::vector<std::pair<class_id_t, vtable_groups_t>> deferred;
+    for (size_t i = 0; i < classes.size(); ++i) {
+        const bool virtualBases = !this->getVirtualBases(classes[i]).empty();
+        virtualInheritance |= virtualBases;
+        if (found[i].size() > 1 && virtualBases) {
+            deferred.emplace_back(classes[i], std::move(found[i]));
+            continue;
+        }
+        for (auto &group : found[i]) {
+            for (VtableRecord &vtable : group) {
+                endAtNull(vtable);
+                this->vtables.push_back(std::move(vtable));
+            }
         }
-        case SI_CLASS_TYPE_INFO:
-            type = this->defineSiClassType();
-            break;
-        case PBASE_TYPE_INFO:
-        case POINTER_TYPE_INFO:
-            type = this->definePbaseClassType();
-            break;
-        case POINTER_TO_MEMBER_TYPE_INFO:
-            type = this->definePointerToMemberClassType();
-            break;
-        default:
-            BinaryNinja::LogDebug("Unsupported std::type_info derived class at address %p.",
-                                  (void*)address);
-            this->typeinfoClasses.pop_back();  // Remove the class from the list
-            return;
     }
+    if (virtualInheritance) {
+        SKALD_TIMED_SCOPE("vtt parse");
+        this->parseVtts<A>(deferred);
+    }
+    this->vtablesAdded(first);
+}
 
-    // Define variable
-    _view->DefineUserDataVariable(address, type->WithConfidence(0xff));
-
-    // Read content of RTTI
-    auto rtti = this->accessor.readVar(address);
-    auto className = this->accessor.readString(address, "__type_name");
-    BinaryNinja::LogDebug("Found RTTI at address 0x%lx named `%s`", address, className.c_str());
-
-    // Add the node in the inheritance graph
-    if (rtti.contains("__base_count")) {  // Contains >= 1 base class and they might be virtual
-        uint32_t baseCount = std::any_cast<uint32_t>(rtti["__base_count"]);
-        std::vector<edge_t> children(baseCount);
-        auto baseInfoArray = std::any_cast<std::vector<std::any>>(rtti["__base_info"]);
-        for (int i = 0; i < baseCount; ++i) {
-            auto baseInfo =
-                std::any_cast<std::unordered_map<std::string, std::any>>(baseInfoArray[i]);
-            children[i] = {
-                std::any_cast<uint64_t>(baseInfo["__base_type"]),
-                static_cast<EdgeFlag>(std::any_cast<uint64_t>(baseInfo["__offset_flags"]) & 0xff)};
+template <typename A>
+void Skald::parseVtts(std::vector<std::pair<class_id_t, vtable_groups_t>> &deferred) {
+    // Address point of every vtable. `group` indexes the groups of `deferred`, in order
+    struct AddressPoint {
+        address_t address;
+        class_id_t id;
+        uint32_t group;
+        bool primary;
+        bool construction;  // Told apart by a previous call to `resolve()`
+    };
+    constexpr uint32_t NO_GROUP = UINT32_MAX;
+
+    std::vector<AddressPoint> points;
+    for (const VtableRecord &vtable : this->vtables)
+        points.push_back({vtable.address, this->inheritanceGraph.find(vtable.rttiAddress),
+                          NO_GROUP, vtable.offsetToTop == 0,
+                          vtable.kind == VtableKind::CONSTRUCTION});
+    for (const FlushedVtable &vtable : this->flushedVtables)
+        points.push_back({vtable.address, this->inheritanceGraph.find(vtable.rttiAddress),
+                          NO_GROUP, vtable.primary, vtable.construction});
+    uint32_t groupCount = 0;
+    for (const auto &[id, groups] : deferred) {
+        for (const auto &group : groups) {
+            for (const VtableRecord &vtable : group)
+                points.push_back(
+                    {vtable.address, id, groupCount, vtable.offsetToTop == 0, false});
+            ++groupCount;
+        }
+    }
+    std::ranges::sort(points, {}, &AddressPoint::address);
+
+    // Only the classes with virtual bases have a VTT
+    bool virtualInheritance = false;
+    for (class_id_t id = 0; id < this->inheritanceGraph.size() && !virtualInheritance; ++id)
+        for (const CompactEdge &edge : this->inheritanceGraph.getChildren(id))
+            virtualInheritance |= (edge.flags & EdgeFlag::VIRTUAL) != 0;
+
+    // A VTT is an array of address points: the primary vtable of the class, then its secondary
+    // vtables and the construction vtables of its bases, in any order
+    std::vector<class_id_t> owners(groupCount, NO_CLASS);  // Class whose VTT uses each group
+    std::vector<address_t> targets;
+    for (const AddressPoint &point : points) targets.push_back(point.address);
+    const auto pointers = virtualInheritance
+                              ? findPointers<A>(this->backend, this->pool, targets)
+                              : std::vector<std::pair<address_t, address_t>>();
+    const auto lookup = [&](address_t address) {
+        return &*std::ranges::lower_bound(points, address, {}, &AddressPoint::address);
+    };
+    // In lazy mode the VTT of a derived class not resolved yet is broken at its first entry, the
+    // rest would pass for VTTs of its bases. A VTT never follows an address point unless it
+    // follows another VTT
+    const auto isSubVtt = [&](address_t address) {
+        if (!this->lazy.ready) return false;
+        const address_t previous = this->accessor.readPointer<A>(address - A::POINTER_SIZE);
+        auto point = std::ranges::lower_bound(points, previous, {}, &AddressPoint::address);
+        if ((point == points.end() || point->address != previous) &&
+            !this->isUnknownAddressPoint<A>(previous))
+            return false;
+        return std::ranges::none_of(this->vtts, [&](const VttRecord &vtt) {
+            return vtt.address + A::POINTER_SIZE * vtt.entries.size() == address;
+        });
+    };
+    for (size_t i = 0; i < pointers.size();) {
+        const AddressPoint *start = lookup(pointers[i].second);
+        if (!start->primary || this->getVirtualBases(start->id).empty() ||
+            isSubVtt(pointers[i].first)) {
+            ++i;
+            continue;
         }
-        this->inheritanceGraph.addNode(className, address, children);
 
-    } else if (rtti.contains("__base_type")) {  // Contains only a single, public, non-virtual base
-        this->inheritanceGraph.addNode(
-            className, address,
-            {{{std::any_cast<uint64_t>(rtti["__base_type"]), EdgeFlag::PUBLIC}}});
+        VttRecord vtt{pointers[i].first, this->inheritanceGraph.getAddress(start->id),
+                      std::string(this->inheritanceGraph.getName(start->id)),
+                      {pointers[i].second}};
+        if (start->group != NO_GROUP && owners[start->group] == NO_CLASS)
+            owners[start->group] = start->id;
+        size_t j = i + 1;
+        for (; j < pointers.size() && pointers[j].first == pointers[j - 1].first + A::POINTER_SIZE;
+             ++j) {
+            const AddressPoint *entry = lookup(pointers[j].second);
+            if (entry->id == start->id) {
+                // The address point of a virtual base sharing the primary vptr is repeated
+                if (entry->group != start->group || (entry->primary && entry != start)) break;
+            } else {
+                // Construction vtables belong to the bases having several groups
+                if ((entry->group == NO_GROUP && !entry->construction) ||
+                    !this->isBaseOf(entry->id, start->id))
+                    break;
+                if (entry->group != NO_GROUP && owners[entry->group] == NO_CLASS)
+                    owners[entry->group] = start->id;
+            }
+            vtt.entries.push_back(pointers[j].second);
+        }
+        i = j;
+        // Found by a previous call to `resolve()`
+        if (std::ranges::find(this->vtts, vtt.address, &VttRecord::address) != this->vtts.end())
+            continue;
+        logDebug("Found VTT at addr {:#x} for RTTI at address {:#x} ({}), {} entries",
+                 vtt.address, vtt.rttiAddress, vtt.className, vtt.entries.size());
+        this->vtts.push_back(std::move(vtt));
+    }
 
-    } else {  // No base classes
-        this->inheritanceGraph.addNode(className, address, {});
+    // The groups not used by any VTT are taken as the own vtables of the class if it has none
+    uint32_t group = 0;
+    for (auto &[id, groups] : deferred) {
+        bool found = contains(std::span(owners).subspan(group, groups.size()), id);
+        for (auto &vtables : groups) {
+            class_id_t owner = owners[group++];
+            if (!found && owner == NO_CLASS) {
+                owner = id;
+                found = true;
+            }
+            for (VtableRecord &vtable : vtables) {
+                if (owner != id) {
+                    vtable.kind = VtableKind::CONSTRUCTION;
+                    if (owner != NO_CLASS) vtable.owner = this->inheritanceGraph.getName(owner);
+                } else {
+                    endAtNull(vtable);
+                }
+                this->markCached(vtable);
+                this->vtables.push_back(std::move(vtable));
+            }
+        }
     }
 }
 
-}  // namespace skald
+template <typename A>
+bool Skald::isUnknownAddressPoint(address_t address) {
+    const address_t rttiAddress = this->accessor.readPointer<A>(address - A::POINTER_SIZE);
+    return this->getClassTypeInfo(rttiAddress) &&
+           this->inheritanceGraph.find(rttiAddress) == NO_CLASS;
+}
 
-extern "C" {
-// Tells Binary Ninja which version of the API you compiled against
-BN_DECLARE_CORE_ABI_VERSION
+void Skald::markCached(VtableRecord &vtable) const {
+    auto it = this->previousVtables.find(vtable.address);
+    if (it == this->previousVtables.end()) return;
+    const VtableRecord &cached = this->previous.vtables[it->second];
+    vtable.cached = cached.rttiAddress == vtable.rttiAddress &&
+                    cached.className == vtable.className && cached.kind == vtable.kind &&
+                    cached.offsetToTop == vtable.offsetToTop &&
+                    cached.subobject == vtable.subobject && cached.owner == vtable.owner &&
+                    cached.functions == vtable.functions;
+}
 
-// Function run on plugin startup, do simple initialization here (Settings, BinaryViewTypes, etc)
-// BINARYNINJAPLUGIN bool CorePluginInit() { return skald::Skald::get_instance().init(); }
-BINARYNINJAPLUGIN bool CorePluginInit() {
-    BinaryNinja::LogDebug("Initializing skald plugin");
+template <typename A>
+TypeInfoRecord Skald::parseRTTI(address_t address, TypeInfo type) {
+    typedef BaseClassTypeInfoLayout<A> base_t;
+    typedef VmiClassTypeInfoLayout<A> vmi_t;
+
+    // Fetch the fixed part of the object with a single read, the fields are then decoded from the
+    // local copy through the layout descriptors
+    std::array<uint8_t, MAX_TYPE_INFO_SIZE> bytes{};
+    this->accessor.readBytes(address, std::span(bytes).first(typeInfoSize<A>(type, 0)));
+
+    TypeInfoRecord record{.address = address, .type = type};
+    const LayoutView<ClassTypeInfoLayout<A>> typeInfo(bytes);
+    record.nameAddress = typeInfo.template get<typename ClassTypeInfoLayout<A>::typeName>();
+    record.name = this->accessor.readString(record.nameAddress);
+    logDebug("Found RTTI at address {:#x} named `{}`", address, record.name);
+
+    // Collect the base classes
+    if (type == TypeInfo::VMI_CLASS_TYPE_INFO) {
+        // Contains >= 1 base class and they might be virtual
+        const LayoutView<vmi_t> vmi(bytes);
+        record.baseCount = vmi.template get<typename vmi_t::baseCount>();
+
+        // The count comes from the binary: the bases can not extend past the section of the
+        // type_info, and those that could not be read are dropped
+        const Section *section = this->sections.find(address);
+        const address_t basesStart = address + vmi_t::BASE_INFO;
+        const uint64_t available =
+            section && basesStart < section->end ? (section->end - basesStart) / base_t::SIZE : 0;
+        std::vector<uint8_t> baseInfo(base_t::SIZE *
+                                      std::min<uint64_t>(record.baseCount, available));
+        const size_t read = this->accessor.readBytes(basesStart, baseInfo);
+        if (read / base_t::SIZE < record.baseCount) {
+            logDebug("Only {} of the {} bases of the type_info at {:#x} can be read",
+                     read / base_t::SIZE, record.baseCount, address);
+            record.baseCount = read / base_t::SIZE;
+        }
+        record.bases.resize(record.baseCount);
+        record.baseOffsets.resize(record.baseCount);
+        for (uint32_t i = 0; i < record.baseCount; ++i) {
+            const LayoutView<base_t> base{std::span(baseInfo).subspan(base_t::SIZE * i)};
+            const int64_t offsetFlags = base.template get<typename base_t::offsetFlags>();
+            record.bases[i] = {
+                base.template get<typename base_t::baseType>(),
+                static_cast<EdgeFlag>(offsetFlags & base_t::FLAGS_MASK)};
+            record.baseOffsets[i] = offsetFlags >> base_t::OFFSET_SHIFT;
+        }
 
-    BinaryNinja::PluginCommand::Register(
-        "skald", "RTTI recovery plugin",
-        [](BinaryNinja::BinaryView* view) { skald::Skald(view).run(); });
+    } else if (type == TypeInfo::SI_CLASS_TYPE_INFO) {
+        // Contains only a single, public, non-virtual base
+        typedef SiClassTypeInfoLayout<A> si_t;
+        const LayoutView<si_t> si(bytes);
+        record.bases.push_back({si.template get<typename si_t::baseType>(), EdgeFlag::PUBLIC});
+        record.baseOffsets.push_back(0);
+    }
 
-    return true;
-}
+    return record;
 }
+
+}  // namespace skald
@@ -1,53 +1,207 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
 #include <string>
 #include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
-#include "binaryninjaapi.h"
+#include "abi.h"
+#include "backend.h"
+#include "compact_graph.h"
 #include "inheritance_graph.h"
+#include "range_table.h"
+#include "records.h"
+#include "relocation_index.h"
+#include "result_cache.h"
+#include "rtti.h"
+#include "run_observer.h"
+#include "signature_pack.h"
+#include "thread_pool.h"
 #include "type_accessor.h"
+#include "vtable_index.h"
+#include "vtable_scanner.h"
 
 namespace skald {
 
-enum TypeInfo : uint32_t {
-    CLASS_TYPE_INFO,
-    VMI_CLASS_TYPE_INFO,
-    SI_CLASS_TYPE_INFO,
-    FUNCTION_TYPE_INFO,
-    PBASE_TYPE_INFO,
-    POINTER_TYPE_INFO,
-    FUNDAMENTAL_TYPE_INFO,
-    ARRAY_TYPE_INFO,
-    ENUM_TYPE_INFO,
-    POINTER_TO_MEMBER_TYPE_INFO,
-    UNSUPPORTED,
+// Memory bounded run, for the binaries whose records do not fit in memory at once
+struct StreamingOptions {
+    size_t memoryBudget = size_t{256} << 20;  // Bytes of records held at once, roughly
+    std::filesystem::path spillDirectory;     // The temporary directory of the system if empty
 };
 
 class Skald {
    public:
-    Skald(BinaryNinja::BinaryView* view);
+    // `threads` is the number of threads used by the parallel phases, 0 means one per core
+    Skald(Backend &backend, size_t threads = 0);
     bool init();
+
+    // Throws RunCancelled if the observer cancels the run
     void run();
 
+    // Lazy alternative to `run()`: resolve the class of the type_info or vtable at `address`, its
+    // bases, its derived classes and their vtables, with pointer sweeps limited to those classes.
+    // The classes resolved by the previous calls are kept and not searched again, the records
+    // found are appended to `getTypeInfos()`, `getVtables()` and `getVtts()`. Returns false if
+    // there is no class at `address`
+    bool resolve(address_t address);
+
+    // `observer` must outlive the runs, nullptr to remove it
+    void setObserver(RunObserver *observer) { this->observer = observer; }
+
+    // Streaming mode of `run()`, nullopt to disable it. The type_info objects are parsed in
+    // address ordered chunks and the vtables flushed after each batch: the records only reach the
+    // observer, `getTypeInfos()` and `getVtables()` stay empty. The names and the bases of the
+    // classes are spilled to a temporary file, mapped back by the inheritance graph
+    void setStreaming(std::optional<StreamingOptions> options) {
+        this->streaming = std::move(options);
+    }
+
+    // Known classes, nullptr to remove them. The primary vtables of the classes of `signatures`
+    // whose bases and slot count match point to their class in `VtableRecord::signature`
+    void setSignatures(std::shared_ptr<const SignaturePack> signatures) {
+        this->signatures = std::move(signatures);
+    }
+
+    // Results of a previous run on the same binary, the records lying in the sections that did
+    // not change are taken from there instead of being parsed again. Enables the caching
+    void setCache(ResultCache cache) {
+        this->previous = std::move(cache);
+        this->caching = true;
+    }
+
+    // Fingerprint the data sections in `run()`, for `getResultCache()`. It reads every byte of
+    // them, so it is off unless enabled here or by `setCache()`
+    void setCaching(bool caching) { this->caching = caching; }
+
+    // Results of the last run, to be passed to `setCache()` of the next one. Only reusable if the
+    // caching was enabled
+    ResultCache getResultCache() const;
+
+    // Sorted by address after `run()`, in resolution order after `resolve()`. Empty after a run in
+    // streaming mode
+    const std::vector<TypeInfoRecord> &getTypeInfos() const { return this->typeinfoClasses; }
+    const std::vector<VtableRecord> &getVtables() const { return this->vtables; }
+    const std::vector<VttRecord> &getVtts() const { return this->vtts; }
+    const CompactGraph &getInheritanceGraph() const { return this->inheritanceGraph; }
+
+    // Idle outside of `run()`, the analyses of the results can use it
+    ThreadPool &getThreadPool() { return this->pool; }
+
+    // ABI of the binary, the engine is instantiated for it once per run
+    const Abi &getAbi() const { return this->abi; }
+
    private:
-    BinaryNinja::BinaryView* _view;
-    std::vector<uint64_t> typeinfoClasses;  // Vector containing the address of each typeinfo class
-    InheritanceGraph inheritanceGraph;      // Class inheritance graph
-    TypeAccessor accessor;                  // Accessor for reading values from typed variables
-
-    void parseVtable(uint64_t typeInfoPointer);
-    void parseRTTI(unsigned long address, const std::string& symbolName);
-    BinaryNinja::Ref<BinaryNinja::Type> createVtableType(const std::string_view& className,
-                                                         uint64_t addr, uint32_t size);
-
-    BinaryNinja::Ref<BinaryNinja::Type> defineClassType();
-    BinaryNinja::Ref<BinaryNinja::Type> defineBaseClass();
-    BinaryNinja::Ref<BinaryNinja::Type> defineVmiClassType(uint32_t base_count);
-    BinaryNinja::Ref<BinaryNinja::Type> defineSiClassType();
-    BinaryNinja::Ref<BinaryNinja::Type> definePbaseClassType();
-    BinaryNinja::Ref<BinaryNinja::Type> definePointerToMemberClassType();
+    Backend &backend;
+    Abi abi;
+    RelocationIndex relocations;                  // Relocations grouped by target symbol
+    VtableIndex vtableCandidates;                 // RTTI slots of the potential vtables
+    VtableScanner vtableScanner;                  // Computes the extent of the vtables
+    std::vector<TypeInfoRecord> typeinfoClasses;  // Every typeinfo class, sorted by address
+    std::vector<VtableRecord> vtables;            // Every vtable recovered
+    std::vector<VttRecord> vtts;                  // Every VTT recovered, sorted by address
+    CompactGraph inheritanceGraph;                // Class inheritance graph
+    TypeAccessor accessor;                        // Accessor for reading values from memory
+    RangeTable sections;  // Bound the reads of the records, the segments if there are no sections
+    ThreadPool pool;
+    RunObserver *observer = nullptr;
+    std::optional<StreamingOptions> streaming;
+    std::shared_ptr<const SignaturePack> signatures;
+
+    // Address points of the vtables already flushed in streaming mode, the VTTs refer to them
+    struct FlushedVtable {
+        address_t address;
+        address_t rttiAddress;
+        bool primary;
+        bool construction;
+    };
+    std::vector<FlushedVtable> flushedVtables;
+
+    bool caching = false;                                   // Sections fingerprinted by `run()`
+    ResultCache previous;                                   // Results of the previous run
+    RangeTable unchanged;                                   // Sections equal in the previous run
+    std::unordered_map<address_t, size_t> previousVtables;  // Address -> index in `previous`
+    uint64_t layoutHash = 0;
+    std::vector<std::pair<address_t, uint64_t>> sectionHashes;
+
+    // Classes of the lazy mode, kept between the calls to `resolve()`
+    struct LazyState {
+        bool ready = false;
+        InheritanceGraph graph;
+        std::unordered_set<address_t> parsed;    // Classes in `graph`, their RTTI slots searched
+        std::unordered_set<address_t> expanded;  // Classes whose derived classes were searched
+        std::vector<std::pair<address_t, address_t>> pointers;  // RTTI slots with their type_info
+    } lazy;
+
+    // Whether [start, end) lies in a single section that did not change since the previous run
+    bool isUnchanged(address_t start, address_t end) const;
+
+    // Reports the progress to the observer, throws RunCancelled if it was cancelled
+    void checkpoint(Phase phase, size_t done, size_t total);
+    void completed(Phase phase);
+    void vtablesAdded(size_t first);
+
+    // Groups of vtables of a class, one after the other in memory order
+    typedef std::vector<std::vector<VtableRecord>> vtable_groups_t;
+
+    // Distinct virtual bases of the class, direct or not
+    std::vector<class_id_t> getVirtualBases(class_id_t id) const;
+    // Whether `base` is a base of `id`, direct or not
+    bool isBaseOf(class_id_t base, class_id_t id) const;
+    // Class of the signature pack matching `id`, NO_SIGNATURE if there is none
+    uint32_t matchSignature(class_id_t id) const;
+
+    // `run()` and `resolve()` for the ABI `A`, the templates below are instantiated for each one
+    template <typename A>
+    void runFor();
+    template <typename A>
+    bool resolveFor(address_t address);
+
+    // Safe to call concurrently, the instance is not modified
+    template <typename A>
+    vtable_groups_t parseVtableGroups(class_id_t id);
+    template <typename A>
+    void resolveSubobjects(class_id_t id, std::vector<VtableRecord> &group);
+    template <typename A>
+    TypeInfoRecord parseRTTI(address_t address, TypeInfo type);
+
+    // Type of the class type_info object at `address`, nullopt if there is none
+    std::optional<TypeInfo> getClassTypeInfo(address_t address) const;
+    // type_info of the class at `address`: a type_info object, an address point, a RTTI slot or
+    // any word of a vtable already recovered
+    template <typename A>
+    std::optional<address_t> findTypeInfo(address_t address);
+    // Parse the type_info at `address` and its bases in lazy mode, the ones not parsed yet are
+    // appended to `added`. False if there is no class type_info at `address`
+    template <typename A>
+    bool parseLazy(address_t address, std::vector<address_t> &added);
+    // Class whose `__base_type` field is the word at `address`, nullopt if there is none. `inside`
+    // tells whether the word lies in any type_info object
+    template <typename A>
+    std::optional<address_t> getDerivedAt(address_t address, bool &inside);
+    // Vtables of the classes at `addresses`, which were never sized
+    template <typename A>
+    void sizeVtablesLazy(std::span<const address_t> addresses);
+
+    // Whether `address` is the address point of a vtable whose class is not in the graph. Only
+    // happens in lazy mode
+    template <typename A>
+    bool isUnknownAddressPoint(address_t address);
+
+    // Find the VTTs, which tell the own vtables of the classes in `deferred` from the
+    // construction ones, then add those vtables
+    template <typename A>
+    void parseVtts(std::vector<std::pair<class_id_t, vtable_groups_t>> &deferred);
+
+    // Whether the previous run recovered the same vtable
+    void markCached(VtableRecord &vtable) const;
 };
 
-}  // namespace skald
\ No newline at end of file
+}  // namespace skald
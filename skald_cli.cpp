@@ -0,0 +1,295 @@
+// Headless driver: recover the RTTI and the vtables of every ELF found in the given paths, without
+// going through Binary Ninja
+#include <fmt/format.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "compact_graph.h"
+#include "elf_backend.h"
+#include "hierarchy_export.h"
+#include "instrumentation.h"
+#include "log.h"
+#include "run_observer.h"
+#include "signature_pack.h"
+#include "skald.h"
+#include "trace_backend.h"
+#include "type_name_decoder.h"
+
+namespace {
+
+struct Options {
+    size_t threads = 0;
+    std::filesystem::path record;
+    std::filesystem::path output;  // Export of the hierarchy
+    bool demangle = false;
+    std::vector<skald::address_t> addresses;  // Resolved one by one instead of a full run
+    size_t memoryBudget = 0;                  // In MiB, 0 when not streaming
+    std::shared_ptr<const skald::SignaturePack> signatures;
+};
+
+void usage(const char *argv0) {
+    fmt::print(stderr,
+               "usage: {} [-v | -q] [-C] [-j threads] [-t trace.json] [-w replay]\n"
+               "       [-e export] [-m budget] [-s pack] [-a address]...\n"
+               "       <file | directory>...\n"
+               "\n"
+               "Dump the inheritance graph, the vtables and the VTTs recovered from each ELF\n"
+               "binary or replay trace. Directories are scanned recursively for ELF binaries.\n"
+               "\n"
+               "  -a  only resolve the class of the type_info or vtable at this address, with its\n"
+               "      bases and derived classes, instead of the whole binary (repeatable)\n"
+               "  -e  export the hierarchy, with the vtables and their slots, to this file:\n"
+               "      JSON for `.json`, Graphviz for `.dot` or `.gv`, skald's mappable binary\n"
+               "      format otherwise (a single binary only)\n"
+               "  -v  print debug and info messages\n"
+               "  -q  only print errors\n"
+               "  -C  print the class names as in the source (`foo::Bar<int>`) rather than\n"
+               "      mangled (`N3foo3BarIiEE`)\n"
+               "  -j  number of threads used for the analysis (default: one per core)\n"
+               "  -m  streaming mode: hold about this many MiB of records at once and print\n"
+               "      them as they are recovered, for the binaries too large for memory\n"
+               "  -s  signature pack written by skald-pack: the slots of the known classes are\n"
+               "      printed with the symbols of their functions\n"
+               "  -t  write a Chrome trace of the analysis and print a summary on stderr (needs\n"
+               "      a build with SKALD_INSTRUMENTATION)\n"
+               "  -w  record the queries made to the binary in a replay trace, that can be\n"
+               "      analyzed later in place of the binary (a single binary only)\n",
+               argv0);
+}
+
+// `names` is null when the names are printed mangled
+std::string_view displayName(skald::TypeNameDecoder *names, std::string_view mangled) {
+    return names ? names->decode(mangled) : mangled;
+}
+
+// `elf` is null when replaying a trace, which has no symbols
+std::string className(const skald::ElfBackend *elf, skald::TypeNameDecoder *names,
+                      const skald::CompactGraph &graph, skald::class_id_t id) {
+    if (!graph.getName(id).empty()) return std::string(displayName(names, graph.getName(id)));
+
+    // Class defined in another module, use the name of the imported type_info symbol
+    std::string_view symbol = elf ? elf->getSymbolAt(graph.getAddress(id)) : "";
+    if (symbol.starts_with("_ZTI")) symbol.remove_prefix(4);
+    return symbol.empty() ? "<unknown>" : std::string(displayName(names, symbol));
+}
+
+void printClasses(const skald::ElfBackend *elf, skald::TypeNameDecoder *names,
+                  const skald::CompactGraph &graph) {
+    for (skald::class_id_t id = 0; id < graph.size(); ++id) {
+        if (graph.getName(id).empty()) continue;  // Only declared as base of another class
+
+        std::string bases;
+        for (const auto &[baseId, flags, offset] : graph.getChildren(id)) {
+            bases += bases.empty() ? " : " : ", ";
+            bases += flags & skald::EdgeFlag::PUBLIC ? "public " : "private ";
+            if (flags & skald::EdgeFlag::VIRTUAL) bases += "virtual ";
+            bases += className(elf, names, graph, baseId);
+        }
+        fmt::print("class {:#x} {}{}\n", graph.getAddress(id),
+                   displayName(names, graph.getName(id)), bases);
+    }
+}
+
+// `signatures` is null when no pack was given
+void printVtables(skald::TypeNameDecoder *names, const skald::SignaturePack *signatures,
+                  std::span<const skald::VtableRecord> vtables) {
+    for (const auto &vtable : vtables) {
+        std::string kind = "vtable";
+        std::string name(displayName(names, vtable.className));
+        if (vtable.kind == skald::VtableKind::CONSTRUCTION) {
+            kind = "construction vtable";
+            name += " in ";
+            name += vtable.owner.empty() ? "<unknown>" : displayName(names, vtable.owner);
+        }
+        if (vtable.offsetToTop != 0) {
+            name += " for ";
+            name += vtable.subobject.empty() ? "<unknown>" : displayName(names, vtable.subobject);
+            name += fmt::format(" at {:#x}", -vtable.offsetToTop);
+        }
+        fmt::print("{} {:#x} {} [{}]\n", kind, vtable.address, name, vtable.functions.size());
+        for (size_t i = 0; i < vtable.functions.size(); ++i) {
+            std::string_view symbol;
+            if (vtable.signature != skald::NO_SIGNATURE &&
+                i < signatures->getSlotCount(vtable.signature))
+                symbol = signatures->getFunction(vtable.signature, i);
+            if (symbol.empty())
+                fmt::print("  [{}] {:#x}\n", i, vtable.functions[i]);
+            else
+                fmt::print("  [{}] {:#x} {}\n", i, vtable.functions[i], symbol);
+        }
+    }
+}
+
+void printVtts(skald::TypeNameDecoder *names, std::span<const skald::VttRecord> vtts) {
+    for (const auto &vtt : vtts) {
+        fmt::print("vtt {:#x} {} [{}]\n", vtt.address, displayName(names, vtt.className),
+                   vtt.entries.size());
+        for (size_t i = 0; i < vtt.entries.size(); ++i)
+            fmt::print("  [{}] {:#x}\n", i, vtt.entries[i]);
+    }
+}
+
+// Prints the records of a streaming run as they are recovered, in the same order as a full run
+class StreamingPrinter : public skald::RunObserver {
+   public:
+    StreamingPrinter(const std::filesystem::path &path, const skald::ElfBackend *elf,
+                     skald::TypeNameDecoder *names, const skald::SignaturePack *signatures)
+        : path(path), elf(elf), names(names), signatures(signatures) {}
+
+    void phaseCompleted(const skald::Skald &skald, skald::Phase phase) override {
+        if (phase != skald::Phase::RTTI) return;
+        fmt::print("# {}\n", this->path.string());
+        printClasses(this->elf, this->names, skald.getInheritanceGraph());
+    }
+
+    void vtablesAdded(const skald::Skald &skald,
+                      std::span<const skald::VtableRecord> vtables) override {
+        printVtables(this->names, this->signatures, vtables);
+    }
+
+   private:
+    const std::filesystem::path &path;
+    const skald::ElfBackend *elf;
+    skald::TypeNameDecoder *names;
+    const skald::SignaturePack *signatures;
+};
+
+void analyze(const std::filesystem::path &path, skald::Backend &backend,
+             const skald::ElfBackend *elf, const Options &options) {
+    skald::TypeNameDecoder decoder;
+    skald::TypeNameDecoder *names = options.demangle ? &decoder : nullptr;
+    skald::TraceRecorder recorder(backend);
+    skald::Skald skald(options.record.empty() ? backend : recorder, options.threads);
+
+    skald.setSignatures(options.signatures);
+
+    StreamingPrinter printer(path, elf, names, options.signatures.get());
+    const bool streaming = options.memoryBudget != 0 && options.addresses.empty();
+    if (streaming) {
+        skald.setStreaming(skald::StreamingOptions{options.memoryBudget << 20, {}});
+        skald.setObserver(&printer);
+    }
+
+    if (options.addresses.empty()) {
+        skald.run();
+    } else {
+        for (skald::address_t address : options.addresses)
+            if (!skald.resolve(address)) skald::logWarn("No class at {:#x}", address);
+    }
+    if (!options.record.empty()) recorder.save(options.record);
+    if (!options.output.empty())
+        skald::exportHierarchy(skald, options.output, skald::getExportFormat(options.output),
+                               names);
+
+    // The classes and the vtables of a streaming run have already been printed
+    if (!streaming) {
+        fmt::print("# {}\n", path.string());
+        printClasses(elf, names, skald.getInheritanceGraph());
+        printVtables(names, options.signatures.get(), skald.getVtables());
+    }
+    printVtts(names, skald.getVtts());
+    fmt::print("\n");
+}
+
+bool process(const std::filesystem::path &path, const Options &options) {
+    try {
+        if (skald::TraceBackend::isTrace(path)) {
+            skald::TraceBackend backend(path);
+            analyze(path, backend, nullptr, options);
+        } else {
+            skald::ElfBackend backend(path);
+            analyze(path, backend, &backend, options);
+        }
+        return true;
+    } catch (const std::exception &e) {
+        skald::logError("{}: {}", path.string(), e.what());
+        return false;
+    }
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    skald::setLogLevel(skald::LogLevel::WARNING);
+
+    std::vector<std::filesystem::path> paths;
+    Options options;
+    std::filesystem::path trace;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "-j") && i + 1 < argc) {
+            options.threads = std::strtoul(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "-t") && i + 1 < argc) {
+            trace = argv[++i];
+        } else if (!std::strcmp(argv[i], "-w") && i + 1 < argc) {
+            options.record = argv[++i];
+        } else if (!std::strcmp(argv[i], "-e") && i + 1 < argc) {
+            options.output = argv[++i];
+        } else if (!std::strcmp(argv[i], "-m") && i + 1 < argc) {
+            options.memoryBudget = std::strtoull(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "-s") && i + 1 < argc) {
+            try {
+                options.signatures = std::make_shared<skald::SignaturePack>(argv[++i]);
+            } catch (const std::exception &e) {
+                skald::logError("{}", e.what());
+                return 1;
+            }
+        } else if (!std::strcmp(argv[i], "-a") && i + 1 < argc) {
+            options.addresses.push_back(std::strtoull(argv[++i], nullptr, 0));
+        } else if (!std::strcmp(argv[i], "-C")) {
+            options.demangle = true;
+        } else if (!std::strcmp(argv[i], "-v")) {
+            skald::setLogLevel(skald::LogLevel::DEBUG);
+        } else if (!std::strcmp(argv[i], "-q")) {
+            skald::setLogLevel(skald::LogLevel::ERROR);
+        } else if (argv[i][0] == '-') {
+            usage(argv[0]);
+            return 2;
+        } else {
+            paths.emplace_back(argv[i]);
+        }
+    }
+    if (paths.empty() ||
+        ((!options.record.empty() || !options.output.empty()) && paths.size() != 1)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    bool ok = true;
+    for (const auto &path : paths) {
+        std::error_code ec;
+        if (!std::filesystem::is_directory(path, ec)) {
+            ok &= process(path, options);
+            continue;
+        }
+
+        // Only pick up the ELF files when walking a directory
+        for (auto it = std::filesystem::recursive_directory_iterator(
+                 path, std::filesystem::directory_options::skip_permission_denied, ec);
+             it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+            if (ec) break;
+            if (it->is_regular_file(ec) && skald::ElfBackend::isElf(it->path()))
+                ok &= process(it->path(), options);
+        }
+    }
+
+    if (!trace.empty()) {
+        if (!skald::INSTRUMENTATION_ENABLED)
+            skald::logWarn("Built without SKALD_INSTRUMENTATION, the trace is empty");
+        if (!skald::writeTrace(trace)) {
+            skald::logError("Cannot write the trace to {}", trace.string());
+            ok = false;
+        }
+        fmt::print(stderr, "{}", skald::formatInstrumentationSummary());
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,128 @@
+// Signature pack generator: recover the classes of unstripped reference builds of common libraries
+// and store them, with the symbols of their virtual functions, in a pack for `skald-cli -s` and
+// the plugin
+#include <fmt/format.h>
+
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "compact_graph.h"
+#include "elf_backend.h"
+#include "log.h"
+#include "records.h"
+#include "signature_pack.h"
+#include "skald.h"
+
+namespace {
+
+void usage(const char *argv0) {
+    fmt::print(stderr,
+               "usage: {} [-v | -q] -o output.pack <file | directory>...\n"
+               "\n"
+               "Write a signature pack of the classes having a vtable in each unstripped ELF\n"
+               "binary: their bases and the symbols of their virtual functions. Directories are\n"
+               "scanned recursively for ELF binaries. The first binary defining a class wins.\n"
+               "\n"
+               "  -o  pack to write\n"
+               "  -v  print debug and info messages\n"
+               "  -q  only print errors\n",
+               argv0);
+}
+
+// Symbol of the function at `address`. The Thumb functions have the lowest bit of their symbol set
+std::string_view functionSymbol(const skald::ElfBackend &elf, skald::address_t address) {
+    if (address == 0) return {};
+    const std::string_view symbol = elf.getSymbolAt(address);
+    return symbol.empty() ? elf.getSymbolAt(address | 1) : symbol;
+}
+
+bool process(const std::filesystem::path &path, std::vector<skald::ClassSignature> &classes) {
+    try {
+        skald::ElfBackend elf(path);
+        skald::Skald skald(elf);
+        skald.run();
+
+        const skald::CompactGraph &graph = skald.getInheritanceGraph();
+        size_t count = 0;
+        for (const skald::VtableRecord &vtable : skald.getVtables()) {
+            const skald::class_id_t id = graph.find(vtable.rttiAddress);
+            if (vtable.kind != skald::VtableKind::PRIMARY || id == skald::NO_CLASS ||
+                graph.getName(id).empty())
+                continue;
+            skald::ClassSignature &signature = classes.emplace_back();
+            signature.name = graph.getName(id);
+            for (const skald::CompactEdge &edge : graph.getChildren(id))
+                signature.bases.emplace_back(graph.getName(edge.target));
+            for (skald::address_t function : vtable.functions)
+                signature.functions.emplace_back(functionSymbol(elf, function));
+            ++count;
+        }
+        skald::logInfo("{}: {} classes", path.string(), count);
+        return true;
+    } catch (const std::exception &e) {
+        skald::logError("{}: {}", path.string(), e.what());
+        return false;
+    }
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    skald::setLogLevel(skald::LogLevel::WARNING);
+
+    std::vector<std::filesystem::path> paths;
+    std::filesystem::path output;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "-o") && i + 1 < argc) {
+            output = argv[++i];
+        } else if (!std::strcmp(argv[i], "-v")) {
+            skald::setLogLevel(skald::LogLevel::DEBUG);
+        } else if (!std::strcmp(argv[i], "-q")) {
+            skald::setLogLevel(skald::LogLevel::ERROR);
+        } else if (argv[i][0] == '-') {
+            usage(argv[0]);
+            return 2;
+        } else {
+            paths.emplace_back(argv[i]);
+        }
+    }
+    if (paths.empty() || output.empty()) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    bool ok = true;
+    std::vector<skald::ClassSignature> classes;
+    for (const auto &path : paths) {
+        std::error_code ec;
+        if (!std::filesystem::is_directory(path, ec)) {
+            ok &= process(path, classes);
+            continue;
+        }
+
+        // Only pick up the ELF files when walking a directory
+        for (auto it = std::filesystem::recursive_directory_iterator(
+                 path, std::filesystem::directory_options::skip_permission_denied, ec);
+             it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+            if (ec) break;
+            if (it->is_regular_file(ec) && skald::ElfBackend::isElf(it->path()))
+                ok &= process(it->path(), classes);
+        }
+    }
+
+    // Read back, to check the pack and count the classes left once the duplicates are dropped
+    try {
+        skald::SignaturePack::write(output, classes);
+        fmt::print("{} classes written to {}\n", skald::SignaturePack(output).size(),
+                   output.string());
+    } catch (const std::exception &e) {
+        skald::logError("{}", e.what());
+        return 1;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,79 @@
+#include "spill_file.h"
+
+#include <fcntl.h>
+#include <fmt/format.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <span>
+#include <stdexcept>
+#include <string>
+
+namespace skald {
+
+namespace {
+
+// Bytes buffered before a write
+constexpr size_t BUFFER_SIZE = 0x100000;
+
+}  // namespace
+
+SpillFile::SpillFile(const std::filesystem::path &directory) {
+    std::string path = (directory / "skald-spill-XXXXXX").string();
+    this->fd = mkstemp(path.data());
+    if (this->fd < 0)
+        throw std::runtime_error(fmt::format("Cannot create a spill file in `{}`: {}",
+                                             directory.string(), std::strerror(errno)));
+    unlink(path.c_str());
+    this->buffer.reserve(BUFFER_SIZE);
+}
+
+SpillFile::~SpillFile() {
+    if (this->mapping) munmap(this->mapping, this->mapped);
+    if (this->fd >= 0) close(this->fd);
+}
+
+uint64_t SpillFile::append(std::span<const uint8_t> bytes) {
+    if (this->mapping) throw std::logic_error("The spill file is already mapped");
+    const uint64_t offset = this->size;
+    const size_t padded = (bytes.size() + 7) & ~size_t{7};
+    if (this->buffer.size() + padded > BUFFER_SIZE) this->flush();
+    this->buffer.insert(this->buffer.end(), bytes.begin(), bytes.end());
+    this->buffer.resize(this->buffer.size() + padded - bytes.size());
+    this->size += padded;
+    return offset;
+}
+
+void SpillFile::flush() {
+    for (size_t done = 0; done < this->buffer.size();) {
+        const ssize_t written = write(this->fd, this->buffer.data() + done,
+                                      this->buffer.size() - done);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0)
+            throw std::runtime_error(
+                fmt::format("Cannot write the spill file: {}", std::strerror(errno)));
+        done += written;
+    }
+    this->buffer.clear();
+}
+
+void SpillFile::map() {
+    if (this->mapping) return;
+    this->flush();
+    std::vector<uint8_t>().swap(this->buffer);
+    if (this->size == 0) return;
+
+    void *mapping = mmap(nullptr, this->size, PROT_READ, MAP_SHARED, this->fd, 0);
+    if (mapping == MAP_FAILED)
+        throw std::runtime_error(
+            fmt::format("Cannot map the spill file: {}", std::strerror(errno)));
+    this->mapping = static_cast<uint8_t *>(mapping);
+    this->mapped = this->size;
+}
+
+}  // namespace skald
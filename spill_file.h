@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+namespace skald {
+
+// Append-only temporary file, read back through a memory mapping once it is complete. The pages
+// of the mapping are backed by the file: the kernel can drop them under memory pressure instead of
+// keeping them resident like the heap. The file is unlinked as soon as it is created, nothing is
+// left behind if the process dies
+class SpillFile {
+   public:
+    // Throws std::runtime_error if the file cannot be created in `directory`
+    explicit SpillFile(const std::filesystem::path &directory);
+    ~SpillFile();
+
+    SpillFile(const SpillFile &) = delete;
+    SpillFile &operator=(const SpillFile &) = delete;
+
+    // Offset of `bytes` in the file. Every append starts 8 bytes aligned
+    uint64_t append(std::span<const uint8_t> bytes);
+    template <typename T>
+    uint64_t append(const T &value) {
+        return this->append(std::span(reinterpret_cast<const uint8_t *>(&value), sizeof(T)));
+    }
+
+    // Map the file, nothing can be appended afterwards. Throws std::runtime_error on I/O errors
+    void map();
+    // Content of the file, empty before `map()`
+    std::span<const uint8_t> data() const { return {this->mapping, this->mapped}; }
+
+   private:
+    int fd = -1;
+    uint64_t size = 0;            // Appended so far, including `buffer`
+    std::vector<uint8_t> buffer;  // Not written yet
+    uint8_t *mapping = nullptr;
+    size_t mapped = 0;
+
+    void flush();
+};
+
+}  // namespace skald
@@ -0,0 +1,124 @@
+// Binary export of a synthetic hierarchy read back by HierarchyFile, against the results of Skald
+#include <fmt/format.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "compact_graph.h"
+#include "hierarchy_export.h"
+#include "records.h"
+#include "skald.h"
+#include "synthetic_backend.h"
+
+namespace {
+
+int failures = 0;
+
+void expect(bool condition, std::string_view what) {
+    if (condition) return;
+    fmt::print(stderr, "{}\n", what);
+    ++failures;
+}
+
+void compare(const skald::Skald &skald, const skald::HierarchyFile &file) {
+    const skald::CompactGraph &graph = skald.getInheritanceGraph();
+    expect(file.getPointerSize() == skald.getAbi().pointerSize, "wrong pointer size");
+    expect(file.size() == graph.size(), "wrong class count");
+    if (file.size() != graph.size()) return;
+
+    for (skald::class_id_t id = 0; id < graph.size(); ++id) {
+        const std::string where = fmt::format("class {} ({:#x})", id, graph.getAddress(id));
+        expect(file.getAddress(id) == graph.getAddress(id), where + ": wrong address");
+        expect(file.find(graph.getAddress(id)) == id, where + ": not found");
+        expect(file.getName(id) == graph.getName(id), where + ": wrong name");
+        const auto bases = file.getBases(id);
+        const auto expected = graph.getChildren(id);
+        expect(std::ranges::equal(bases, expected,
+                                  [](const auto &edge, const skald::CompactEdge &other) {
+                                      return edge.target == other.target &&
+                                             edge.flags == other.flags &&
+                                             edge.offset == other.offset;
+                                  }),
+               where + ": wrong bases");
+    }
+    expect(file.find(0) == skald::NO_CLASS, "found a class at 0");
+
+    const auto vtables = file.getVtables();
+    expect(vtables.size() == skald.getVtables().size(), "wrong vtable count");
+    if (vtables.size() != skald.getVtables().size()) return;
+    for (size_t i = 0; i < vtables.size(); ++i) {
+        const skald::VtableRecord &vtable = skald.getVtables()[i];
+        const std::string where = fmt::format("vtable {:#x}", vtable.address);
+        expect(vtables[i].address == vtable.address, where + ": wrong address");
+        expect(vtables[i].offsetToTop == vtable.offsetToTop, where + ": wrong offset to top");
+        expect(vtables[i].kind == vtable.kind, where + ": wrong kind");
+        expect(vtables[i].id == graph.find(vtable.rttiAddress), where + ": wrong class");
+        expect(std::ranges::equal(file.getSlots(vtables[i]), vtable.functions),
+               where + ": wrong slots");
+    }
+}
+
+// A truncated export is rejected when loaded
+void checkTruncated(const std::filesystem::path &path) {
+    const auto size = std::filesystem::file_size(path);
+    for (const auto cut : {size - 1, size / 2, uintmax_t{8}}) {
+        std::filesystem::resize_file(path, cut);
+        try {
+            skald::HierarchyFile file(path);
+            expect(false, fmt::format("loaded an export truncated to {} bytes", cut));
+        } catch (const std::runtime_error &) {
+        }
+    }
+}
+
+// An export whose text size wraps the end of the file around is rejected
+void checkWrappedText(const std::filesystem::path &path) {
+    std::vector<char> bytes(std::filesystem::file_size(path));
+    std::ifstream(path, std::ios::binary).read(bytes.data(), bytes.size());
+    std::vector<char> patched = bytes;
+    const uint64_t textSize = UINT64_MAX;
+    std::memcpy(patched.data() + offsetof(skald::HierarchyFile::Header, textSize), &textSize,
+                sizeof(textSize));
+    std::ofstream(path, std::ios::binary).write(patched.data(), patched.size());
+    try {
+        skald::HierarchyFile file(path);
+        expect(false, "loaded an export with a wrapping text size");
+    } catch (const std::runtime_error &) {
+    }
+    std::ofstream(path, std::ios::binary).write(bytes.data(), bytes.size());
+}
+
+}  // namespace
+
+int main() {
+    skald::HierarchyShape shape;
+    shape.classes = 2000;
+    skald::SyntheticBackend backend(shape);
+    skald::Skald skald(backend);
+    skald.run();
+    expect(skald.getInheritanceGraph().size() == shape.classes, "wrong recovered class count");
+
+    const auto path = std::filesystem::temp_directory_path() /
+                      fmt::format("skald-hierarchy-export-test-{}.bin", getpid());
+    skald::exportHierarchy(skald, path, skald::getExportFormat(path));
+    try {
+        compare(skald, skald::HierarchyFile(path));
+        checkWrappedText(path);
+        checkTruncated(path);
+    } catch (const std::exception &e) {
+        expect(false, e.what());
+    }
+    std::filesystem::remove(path);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "backend.h"
+
+namespace skald {
+
+// Image laid out by the tests section by section, little endian. Each section is also a segment
+class MemoryBackend : public Backend {
+   public:
+    // Zero-filled, the sections are added in the order of their addresses
+    void addSection(std::string name, address_t start, size_t size, SectionFlag flags) {
+        this->sections.push_back({std::move(name), start, start + size, flags});
+        this->contents.emplace_back(size);
+    }
+
+    template <typename T>
+    void write(address_t address, T value) {
+        this->write(address, &value, sizeof(value));
+    }
+    void writeString(address_t address, std::string_view text) {
+        this->write(address, text.data(), text.size());
+    }
+
+    // Relocation patching `address` against `symbol`
+    void addRelocation(address_t address, const std::string &symbol,
+                       int64_t addend = UNKNOWN_ADDEND) {
+        auto it = std::ranges::find(this->relocations.symbols, symbol);
+        if (it == this->relocations.symbols.end())
+            it = this->relocations.symbols.insert(it, symbol);
+        this->relocations.relocations.push_back(
+            {address, static_cast<uint32_t>(it - this->relocations.symbols.begin()), addend});
+    }
+
+    std::vector<Section> getSections() override { return this->sections; }
+    std::vector<Section> getSegments() override {
+        std::vector<Section> segments = this->sections;
+        for (Section &segment : segments) segment.name.clear();
+        return segments;
+    }
+    RelocationTable getRelocations() override { return this->relocations; }
+
+    size_t read(void *dest, address_t address, size_t len) override {
+        const Section *section = this->find(address);
+        if (!section) return 0;
+        const size_t size = std::min<uint64_t>(len, section->end - address);
+        std::memcpy(dest, this->getContent(*section) + (address - section->start), size);
+        return size;
+    }
+
+    bool isValidOffset(address_t address) override { return this->find(address) != nullptr; }
+    bool isOffsetReadable(address_t address) override { return this->find(address) != nullptr; }
+    bool isOffsetExecutable(address_t address) override {
+        const Section *section = this->find(address);
+        return section && section->flags & SectionFlag::EXECUTABLE;
+    }
+    std::optional<Section> getSectionAt(address_t address) override {
+        const Section *section = this->find(address);
+        if (!section) return std::nullopt;
+        return *section;
+    }
+
+   private:
+    std::vector<Section> sections;
+    std::vector<std::vector<uint8_t>> contents;
+    RelocationTable relocations;
+
+    const Section *find(address_t address) const {
+        for (const Section &section : this->sections)
+            if (section.start <= address && address < section.end) return &section;
+        return nullptr;
+    }
+    uint8_t *getContent(const Section &section) {
+        return this->contents[&section - this->sections.data()].data();
+    }
+    void write(address_t address, const void *data, size_t size) {
+        const Section *section = this->find(address);
+        std::memcpy(this->getContent(*section) + (address - section->start), data, size);
+    }
+};
+
+}  // namespace skald
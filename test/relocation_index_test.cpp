@@ -0,0 +1,60 @@
+// Relocation sites grouped by RelocationIndex, and the type_info objects told apart from them
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "backend.h"
+#include "relocation_index.h"
+#include "rtti.h"
+
+namespace {
+
+using skald::address_t;
+using skald::TypeInfo;
+
+int failures = 0;
+
+void expect(bool condition, std::string_view what) {
+    if (condition) return;
+    fmt::print(stderr, "{}\n", what);
+    ++failures;
+}
+
+}  // namespace
+
+int main() {
+    skald::RelocationTable table;
+    table.symbols = {"_ZTVN10__cxxabiv120__si_class_type_infoE", "malloc",
+                     "_ZTVN10__cxxabiv117__class_type_infoE"};
+    table.relocations = {
+        {0x3040, 0, 16},                     // type_info object, after its class
+        {0x3000, 2, 16},                     // type_info object
+        {0x5000, 2, 0},                      // GOT entry of the vtable
+        {0x5008, 0, 0},                      // GOT entry of the vtable
+        {0x5010, 1, 0},                      // GOT entry of a function
+        {0x3080, 2, 8},                      // Not at the address point
+        {0x3100, 2, skald::UNKNOWN_ADDEND},  // Kept, from a backend without the addends
+        {0x3200, skald::NO_SYMBOL, 16},
+    };
+    const skald::RelocationIndex index(table, 8);
+
+    const std::vector<std::pair<address_t, TypeInfo>> expected = {
+        {0x3000, TypeInfo::CLASS_TYPE_INFO},
+        {0x3040, TypeInfo::SI_CLASS_TYPE_INFO},
+        {0x3100, TypeInfo::CLASS_TYPE_INFO},
+    };
+    expect(index.getTypeInfos() == expected, "wrong type_info objects");
+
+    const std::vector<address_t> sites = {0x3000, 0x3080, 0x3100, 0x5000};
+    expect(std::ranges::equal(index.getSites("_ZTVN10__cxxabiv117__class_type_infoE"), sites),
+           "wrong sites of a vtable, sorted with all the addends");
+    expect(std::ranges::equal(index.getSites("malloc"), std::vector<address_t>{0x5010}),
+           "wrong sites of a function");
+    expect(index.getSites("free").empty(), "sites of an unknown symbol");
+    return failures ? 1 : 0;
+}
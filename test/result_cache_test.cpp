@@ -0,0 +1,142 @@
+// Result caches serialized and read back, and reused by the next run with or without a pack
+#include <fmt/format.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "backend.h"
+#include "memory_backend.h"
+#include "records.h"
+#include "result_cache.h"
+#include "signature_pack.h"
+#include "skald.h"
+
+namespace {
+
+using skald::address_t;
+
+int failures = 0;
+
+void expect(bool condition, std::string_view what) {
+    if (condition) return;
+    fmt::print(stderr, "{}\n", what);
+    ++failures;
+}
+
+constexpr address_t TEXT = 0x1000;
+constexpr address_t RODATA = 0x2000;
+constexpr address_t DATA = 0x3000;
+
+// The class `1A`, without bases, whose primary vtable has 4 functions
+skald::MemoryBackend makeImage() {
+    skald::MemoryBackend backend;
+    backend.addSection(".text", TEXT, 0x1000,
+                       skald::SectionFlag::READABLE | skald::SectionFlag::EXECUTABLE);
+    backend.addSection(".rodata", RODATA, 0x100, skald::SectionFlag::READABLE);
+    backend.addSection(".data.rel.ro", DATA, 0x200,
+                       skald::SectionFlag::READABLE | skald::SectionFlag::WRITABLE);
+    const address_t typeInfo = DATA + 0x100;
+    backend.write<uint64_t>(DATA + 8, typeInfo);
+    for (size_t i = 0; i < 4; ++i) backend.write<uint64_t>(DATA + 16 + 8 * i, TEXT + 16 * i);
+    backend.addRelocation(typeInfo, "_ZTVN10__cxxabiv117__class_type_infoE");
+    backend.write<uint64_t>(typeInfo + 8, RODATA);
+    backend.writeString(RODATA, "1A");
+    return backend;
+}
+
+void checkRoundTrip(const skald::ResultCache &cache) {
+    const auto restored = skald::deserializeResultCache(skald::serializeResultCache(cache));
+    if (!restored) {
+        expect(false, "result cache not read back");
+        return;
+    }
+    expect(restored->layoutHash == cache.layoutHash, "wrong layout hash");
+    expect(restored->sectionHashes == cache.sectionHashes, "wrong section hashes");
+    expect(restored->vtableCandidates == cache.vtableCandidates, "wrong vtable candidates");
+
+    expect(restored->typeInfos.size() == cache.typeInfos.size(), "wrong type_info count");
+    for (size_t i = 0; i < std::min(restored->typeInfos.size(), cache.typeInfos.size()); ++i) {
+        const skald::TypeInfoRecord &a = restored->typeInfos[i], &b = cache.typeInfos[i];
+        expect(a.address == b.address && a.type == b.type && a.baseCount == b.baseCount &&
+                   a.name == b.name && a.nameAddress == b.nameAddress && a.bases == b.bases &&
+                   a.baseOffsets == b.baseOffsets && a.cached,
+               fmt::format("wrong type_info at {:#x}", b.address));
+    }
+
+    expect(restored->vtables.size() == cache.vtables.size(), "wrong vtable count");
+    for (size_t i = 0; i < std::min(restored->vtables.size(), cache.vtables.size()); ++i) {
+        const skald::VtableRecord &a = restored->vtables[i], &b = cache.vtables[i];
+        expect(a.address == b.address && a.rttiAddress == b.rttiAddress &&
+                   a.className == b.className && a.functions == b.functions &&
+                   a.kind == b.kind && a.offsetToTop == b.offsetToTop &&
+                   a.subobject == b.subobject && a.owner == b.owner && a.offsets == b.offsets &&
+                   a.cached,
+               fmt::format("wrong vtable at {:#x}", b.address));
+    }
+
+    // Truncated data is rejected instead of read out of bounds
+    std::vector<uint8_t> data = skald::serializeResultCache(cache);
+    data.resize(data.size() / 2);
+    expect(!skald::deserializeResultCache(data), "truncated result cache accepted");
+}
+
+// Vtable of `1A` found by a run reusing `cache`, with `pack` if not nullptr
+skald::VtableRecord rerun(const skald::ResultCache &cache,
+                          std::shared_ptr<const skald::SignaturePack> pack) {
+    skald::MemoryBackend backend = makeImage();
+    skald::Skald skald(backend, 1);
+    skald.setCache(cache);
+    skald.setSignatures(std::move(pack));
+    skald.run();
+    if (skald.getVtables().size() != 1) {
+        expect(false, "wrong vtable count on the rerun");
+        return {};
+    }
+    return skald.getVtables()[0];
+}
+
+}  // namespace
+
+int main() {
+    skald::MemoryBackend backend = makeImage();
+    skald::Skald skald(backend, 1);
+    skald.setCaching(true);
+    skald.run();
+    skald::ResultCache cache = skald.getResultCache();
+    expect(cache.typeInfos.size() == 1 && cache.vtables.size() == 1, "wrong records cached");
+    expect(!cache.sectionHashes.empty(), "sections not fingerprinted");
+    checkRoundTrip(cache);
+    if (cache.vtables.size() != 1) return 1;
+
+    // The extent of an unchanged vtable is taken from the cache. It is shortened here to tell it
+    // apart from a new scan
+    cache.vtables[0].functions.pop_back();
+    const skald::VtableRecord reused = rerun(cache, nullptr);
+    expect(reused.cached && reused.functions.size() == 3, "cached extent not reused");
+
+    // A class of the pack is scanned again, its slot count is compared with the pack
+    const auto path = std::filesystem::temp_directory_path() /
+                      fmt::format("skald-result-cache-test-{}.pack", getpid());
+    try {
+        const std::vector<skald::ClassSignature> classes = {
+            {"1A", {}, {"_ZN1A1fEv", "_ZN1A1gEv", "_ZN1AD1Ev", "_ZN1AD0Ev"}},
+        };
+        skald::SignaturePack::write(path, classes);
+        const auto pack = std::make_shared<const skald::SignaturePack>(path);
+        const skald::VtableRecord known = rerun(cache, pack);
+        expect(known.functions.size() == 4, "cached extent reused for a class of the pack");
+        expect(known.signature != skald::NO_SIGNATURE, "class of the pack not matched");
+    } catch (const std::exception &e) {
+        expect(false, e.what());
+    }
+    std::filesystem::remove(path);
+    return failures ? 1 : 0;
+}
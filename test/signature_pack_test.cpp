@@ -0,0 +1,122 @@
+// Signature packs written and read back, and matched against the classes recovered by Skald
+#include <fmt/format.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "backend.h"
+#include "memory_backend.h"
+#include "records.h"
+#include "signature_pack.h"
+#include "skald.h"
+
+namespace {
+
+using skald::address_t;
+
+int failures = 0;
+
+void expect(bool condition, std::string_view what) {
+    if (condition) return;
+    fmt::print(stderr, "{}\n", what);
+    ++failures;
+}
+
+constexpr address_t TEXT = 0x1000;
+constexpr address_t RODATA = 0x2000;
+constexpr address_t DATA = 0x3000;
+
+// The class `1A`, without bases, whose primary vtable has `slots` functions
+skald::MemoryBackend makeImage(size_t slots) {
+    skald::MemoryBackend backend;
+    backend.addSection(".text", TEXT, 0x1000,
+                       skald::SectionFlag::READABLE | skald::SectionFlag::EXECUTABLE);
+    backend.addSection(".rodata", RODATA, 0x100, skald::SectionFlag::READABLE);
+    backend.addSection(".data.rel.ro", DATA, 0x200,
+                       skald::SectionFlag::READABLE | skald::SectionFlag::WRITABLE);
+    const address_t typeInfo = DATA + 0x100;
+    backend.write<uint64_t>(DATA + 8, typeInfo);
+    for (size_t i = 0; i < slots; ++i) backend.write<uint64_t>(DATA + 16 + 8 * i, TEXT + 16 * i);
+    backend.addRelocation(typeInfo, "_ZTVN10__cxxabiv117__class_type_infoE");
+    backend.write<uint64_t>(typeInfo + 8, RODATA);
+    backend.writeString(RODATA, "1A");
+    return backend;
+}
+
+// Signature of the primary vtable of `1A` found by Skald with `pack`
+uint32_t recover(size_t slots, std::shared_ptr<const skald::SignaturePack> pack) {
+    skald::MemoryBackend backend = makeImage(slots);
+    skald::Skald skald(backend, 1);
+    skald.setSignatures(std::move(pack));
+    skald.run();
+    const auto &vtables = skald.getVtables();
+    if (vtables.size() != 1 || vtables[0].functions.size() != slots) {
+        expect(false, fmt::format("wrong vtables recovered for {} slots", slots));
+        return skald::NO_SIGNATURE;
+    }
+    return vtables[0].signature;
+}
+
+// A pack whose text size wraps the end of the file around is rejected
+void checkWrappedText(const std::filesystem::path &path) {
+    std::vector<char> bytes(std::filesystem::file_size(path));
+    std::ifstream(path, std::ios::binary).read(bytes.data(), bytes.size());
+    const uint64_t textSize = UINT64_MAX;
+    std::memcpy(bytes.data() + offsetof(skald::SignaturePack::Header, textSize), &textSize,
+                sizeof(textSize));
+    std::ofstream(path, std::ios::binary).write(bytes.data(), bytes.size());
+    try {
+        skald::SignaturePack pack(path);
+        expect(false, "loaded a pack with a wrapping text size");
+    } catch (const std::runtime_error &) {
+    }
+}
+
+}  // namespace
+
+int main() {
+    const auto path = std::filesystem::temp_directory_path() /
+                      fmt::format("skald-signature-pack-test-{}.pack", getpid());
+    const std::vector<skald::ClassSignature> classes = {
+        {"1A", {}, {"_ZN1A1fEv", "_ZN1A1gEv", "_ZN1AD1Ev", "_ZN1AD0Ev"}},
+        {"1B", {"1A"}, {"_ZN1B1fEv", "", "_ZN1BD1Ev", "_ZN1BD0Ev"}},
+    };
+    try {
+        skald::SignaturePack::write(path, classes);
+        const auto pack = std::make_shared<const skald::SignaturePack>(path);
+        expect(pack->size() == 2, "wrong class count");
+
+        const std::string_view base = "1A";
+        const uint32_t a = pack->match("1A", {});
+        const uint32_t b = pack->match("1B", {&base, 1});
+        expect(a != skald::NO_SIGNATURE && b != skald::NO_SIGNATURE, "known class not matched");
+        expect(pack->match("1B", {}) == skald::NO_SIGNATURE, "matched with the wrong bases");
+        expect(pack->match("1C", {}) == skald::NO_SIGNATURE, "matched an unknown class");
+        if (b != skald::NO_SIGNATURE) {
+            expect(pack->getSlotCount(b) == 4, "wrong slot count");
+            expect(pack->getFunction(b, 0) == "_ZN1B1fEv" && pack->getFunction(b, 1).empty(),
+                   "wrong function symbols");
+        }
+
+        // Another version of the class has its own extent and none of the symbols
+        expect(recover(4, pack) == a, "vtable with as many slots as in the pack not matched");
+        expect(recover(5, pack) == skald::NO_SIGNATURE, "vtable with more slots matched");
+        expect(recover(3, pack) == skald::NO_SIGNATURE, "vtable with fewer slots matched");
+        checkWrappedText(path);
+    } catch (const std::exception &e) {
+        expect(false, e.what());
+    }
+    std::filesystem::remove(path);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,113 @@
+// Type names decoded by TypeNameDecoder, against the output of `c++filt -t` for the same manglings
+#include <fmt/format.h>
+
+#include <cstdio>
+#include <span>
+#include <string_view>
+
+#include "type_name_decoder.h"
+
+namespace {
+
+struct Case {
+    std::string_view mangled;
+    std::string_view expected;  // As printed by `c++filt -t`
+};
+
+// `_ZTS` names of the system libraries, without the prefix
+constexpr Case LIBRARY_NAMES[] = {
+    {"15debDscFileIndex", "debDscFileIndex"},
+    {"FNSt7__cxx1112basic_stringIcSt11char_traitsIcESaIcEEEvE",
+     "std::__cxx11::basic_string<char, std::char_traits<char>, std::allocator<char> > ()"},
+    {"N4absl7debian313time_internal4cctz12TimeZoneLibCE",
+     "absl::debian3::time_internal::cctz::TimeZoneLibC"},
+    {"N4llvm15MCAsmInfoDarwinE", "llvm::MCAsmInfoDarwin"},
+    {"N4llvm28DiagnosticInfoIROptimizationE", "llvm::DiagnosticInfoIROptimization"},
+    {"N4llvm2cl11opt_storageI6UseBFILb0ELb0EEE", "llvm::cl::opt_storage<UseBFI, false, false>"},
+    {"N4llvm2cl11opt_storageINS_19TargetTransformInfo18AddressingModeKindELb0ELb0EEE",
+     "llvm::cl::opt_storage<llvm::TargetTransformInfo::AddressingModeKind, false, false>"},
+    {"N4llvm2cl15OptionValueCopyINS_17PGOViewCountsTypeEEE",
+     "llvm::cl::OptionValueCopy<llvm::PGOViewCountsType>"},
+    {"N4llvm2cl3optI6UseBFILb0ENS0_6parserIS2_EEEUlRKS2_E_E",
+     "llvm::cl::opt<UseBFI, false, llvm::cl::parser<UseBFI> >::{lambda(UseBFI const&)#1}"},
+    {"N4llvm2cl3optINS_12DebuggerKindELb0ENS0_6parserIS2_EEEE",
+     "llvm::cl::opt<llvm::DebuggerKind, false, llvm::cl::parser<llvm::DebuggerKind> >"},
+    {"N4llvm2cl6parserINS_12DenormalMode16DenormalModeKindEEE",
+     "llvm::cl::parser<llvm::DenormalMode::DenormalModeKind>"},
+    {"N4llvm2cl6parserINS_9CFLAATypeEEE", "llvm::cl::parser<llvm::CFLAAType>"},
+    {"N4llvm3orc19EPCIndirectionUtils10ABISupportE", "llvm::orc::EPCIndirectionUtils::ABISupport"},
+    {"N4llvm3orc25EPCIndirectionUtilsAccessE", "llvm::orc::EPCIndirectionUtilsAccess"},
+    {"N4llvm3pdb16IPDBEnumChildrenINS0_13PDBSymbolDataEEE",
+     "llvm::pdb::IPDBEnumChildren<llvm::pdb::PDBSymbolData>"},
+    {"N4llvm3vfs21RedirectingFileSystem19DirectoryRemapEntryE",
+     "llvm::vfs::RedirectingFileSystem::DirectoryRemapEntry"},
+    {"N4llvm6detail23provider_format_adapterIRA16_KcEE",
+     "llvm::detail::provider_format_adapter<char const (&) [16]>"},
+    {"N4llvm6detail23provider_format_adapterIRA17_cEE",
+     "llvm::detail::provider_format_adapter<char (&) [17]>"},
+    {"N4llvm6object13ELFObjectFileINS0_7ELFTypeILNS_7support10endiannessE0ELb1EEEEE",
+     "llvm::object::ELFObjectFile<llvm::object::ELFType<(llvm::support::endianness)0, true> >"},
+    {"N4llvm7Win64EH18ARM64UnwindEmitterE", "llvm::Win64EH::ARM64UnwindEmitter"},
+    {"N4llvm9MemorySSA13CachingWalkerINS_14BatchAAResultsEEE",
+     "llvm::MemorySSA::CachingWalker<llvm::BatchAAResults>"},
+    {"N4llvm9MemorySSA13CachingWalkerINS_9AAResultsEEE",
+     "llvm::MemorySSA::CachingWalker<llvm::AAResults>"},
+    {"N5boost10wrapexceptINS_6system12system_errorEEE",
+     "boost::wrapexcept<boost::system::system_error>"},
+    {"N5boost6detail18sp_counted_impl_pdIPiNS_21checked_array_deleterIiEEEE",
+     "boost::detail::sp_counted_impl_pd<int*, boost::checked_array_deleter<int> >"},
+    {"N6LercNS9CntZImageE", "LercNS::CntZImage"},
+    {"NSt13__future_base7_ResultIvEE", "std::__future_base::_Result<void>"},
+    {"NSt8__detail12_CharMatcherINSt7__cxx1112regex_traitsIcEELb1ELb1EEE",
+     "std::__detail::_CharMatcher<std::__cxx11::regex_traits<char>, true, true>"},
+    {"St19_Sp_make_shared_tag", "std::_Sp_make_shared_tag"},
+    {"St8functionIFPN4llvm13DominatorTreeERKNS0_8FunctionEEE",
+     "std::function<llvm::DominatorTree* (llvm::Function const&)>"},
+};
+
+// The constructs rare in the libraries: arrays, members, local classes and template arguments
+constexpr Case CONSTRUCTS[] = {
+    {"A64_c", "char [64]"},
+    {"RA10_i", "int (&) [10]"},
+    {"3FooIA100_cE", "Foo<char [100]>"},
+    {"A_i", "int []"},
+    {"PA3_A4_i", "int (*) [3][4]"},
+    {"A4294967296_c", "char [4294967296]"},
+    {"N12_GLOBAL__N_13FooE", "(anonymous namespace)::Foo"},
+    {"*N12_GLOBAL__N_117io_error_categoryE", "(anonymous namespace)::io_error_category"},
+    {"M3FooFivE", "int (Foo::*)()"},
+    {"M3Fooi", "int Foo::*"},
+    {"PKM3FooKFivE", "int (Foo::* const*)() const"},
+    {"3FooIJicEE", "Foo<int, char>"},
+    {"Dn", "decltype(nullptr)"},
+    {"Z4mainE3Foo", "main::Foo"},
+    {"Z4mainE3Foo_0", "main::Foo"},
+    {"ZN3Foo3barEvE3Baz__12_", "Foo::bar()::Baz"},
+    {"ZN3Foo3barEvEUlvE_", "Foo::bar()::{lambda()#1}"},
+    {"ZN3Foo3barEvEUlvE0_", "Foo::bar()::{lambda()#2}"},
+    {"ZN3Foo3barEvEUt_", "Foo::bar()::{unnamed type#1}"},
+    {"3FooILi42EE", "Foo<42>"},
+    {"3FooILb1EE", "Foo<true>"},
+    {"3FooIPFvvEE", "Foo<void (*)()>"},
+    {"FvRA10_KcE", "void (char const (&) [10])"},
+    {"A99999999999999999999999_c", "char [99999999999999999999999]"},
+};
+
+// Number of cases not decoded as expected
+int check(skald::TypeNameDecoder &decoder, std::span<const Case> cases) {
+    int failures = 0;
+    for (const auto &[mangled, expected] : cases) {
+        const std::string_view decoded = decoder.decode(mangled);
+        if (decoded == expected) continue;
+        fmt::print(stderr, "{}: got `{}`, expected `{}`\n", mangled, decoded, expected);
+        ++failures;
+    }
+    return failures;
+}
+
+}  // namespace
+
+int main() {
+    skald::TypeNameDecoder decoder;
+    return check(decoder, LIBRARY_NAMES) + check(decoder, CONSTRUCTS) ? 1 : 0;
+}
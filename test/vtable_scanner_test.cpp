@@ -0,0 +1,126 @@
+// Extents of the vtables found by VtableScanner and Skald in small hand-made images
+#include <fmt/format.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "abi.h"
+#include "backend.h"
+#include "memory_backend.h"
+#include "skald.h"
+#include "type_accessor.h"
+#include "vtable_scanner.h"
+
+namespace {
+
+using skald::address_t;
+
+int failures = 0;
+
+void expect(bool condition, std::string_view what) {
+    if (condition) return;
+    fmt::print(stderr, "{}\n", what);
+    ++failures;
+}
+
+constexpr address_t TEXT = 0x1000;
+constexpr address_t RODATA = 0x2000;
+constexpr address_t DATA = 0x3000;
+
+// Code, names and an empty `.data.rel.ro` for the vtables
+skald::MemoryBackend makeImage() {
+    skald::MemoryBackend backend;
+    backend.addSection(".text", TEXT, 0x1000,
+                       skald::SectionFlag::READABLE | skald::SectionFlag::EXECUTABLE);
+    backend.addSection(".rodata", RODATA, 0x100, skald::SectionFlag::READABLE);
+    backend.addSection(".data.rel.ro", DATA, 0x200,
+                       skald::SectionFlag::READABLE | skald::SectionFlag::WRITABLE);
+    return backend;
+}
+
+// The slots from `address`
+void writeSlots(skald::MemoryBackend &backend, address_t address,
+                const std::vector<uint64_t> &slots) {
+    for (size_t i = 0; i < slots.size(); ++i) backend.write(address + 8 * i, slots[i]);
+}
+
+// A class with RTTI linked before a class built with `-fno-rtti`, whose vtable starts with a null
+// `offset_to_top` and RTTI pointer. The type_info of the first class follows
+void checkVtableWithoutRtti() {
+    skald::MemoryBackend backend = makeImage();
+    const address_t typeInfo = DATA + 0x58;
+    writeSlots(backend, DATA, {0, typeInfo, TEXT, TEXT + 0x10, TEXT + 0x20, TEXT + 0x30});
+    writeSlots(backend, DATA + 0x30, {0, 0, TEXT + 0x40, TEXT + 0x50, TEXT + 0x60});
+    backend.addRelocation(typeInfo, "_ZTVN10__cxxabiv117__class_type_infoE");
+    writeSlots(backend, typeInfo, {0, RODATA});
+    backend.writeString(RODATA, "1A");
+
+    skald::TypeAccessor accessor(backend);
+    const skald::VtableScanner scanner(backend, {typeInfo});
+    const auto functions = scanner.scan<skald::ItaniumLe64>(accessor, DATA + 8);
+    expect(functions.size() == 4, fmt::format("scanned {} slots, expected 4", functions.size()));
+
+    skald::Skald skald(backend, 1);
+    skald.run();
+    const auto &vtables = skald.getVtables();
+    expect(vtables.size() == 1, fmt::format("found {} vtables, expected 1", vtables.size()));
+    if (!vtables.empty())
+        expect(vtables[0].functions.size() == 4,
+               fmt::format("vtable of {} slots, expected 4", vtables[0].functions.size()));
+}
+
+// Construction vtable whose destructors are null, followed by the vcall offsets of the next one
+void checkConstructionVtable() {
+    skald::MemoryBackend backend = makeImage();
+    writeSlots(backend, DATA, {0, DATA + 0x100, TEXT, 0, 0, TEXT + 0x10, uint64_t(-0x20), 0});
+
+    skald::TypeAccessor accessor(backend);
+    const skald::VtableScanner scanner(backend, {DATA + 0x40});
+    const auto functions = scanner.scan<skald::ItaniumLe64>(accessor, DATA + 8, true);
+    expect(functions == std::vector<address_t>{TEXT, 0, 0, TEXT + 0x10},
+           fmt::format("scanned {} slots of the construction vtable, expected 4",
+                       functions.size()));
+    expect(scanner.scan<skald::ItaniumLe64>(accessor, DATA + 8).size() == 1,
+           "the null slots are kept outside of a construction vtable");
+}
+
+// The SIMD variants count as many executable slots as the scalar one, on every block length and
+// on the values around the bounds of the ranges and the sign bit
+void checkCountExecutable() {
+    const std::vector<std::pair<uint64_t, uint64_t>> ranges = {
+        {0x1000, 0x2000}, {0x7ffffffffffff000, 0x8000000000001000}};
+    std::vector<uint64_t> values = {0, UINT64_MAX, 0x8000000000000000};
+    for (const auto &[start, end] : ranges)
+        for (uint64_t value : {start - 1, start, start + 8, end - 1, end}) values.push_back(value);
+
+    const auto variants = skald::VtableScanner::getCountExecutableVariants();
+    std::mt19937_64 random(42);
+    std::vector<uint64_t> slots;
+    for (size_t count = 0; count <= 40; ++count) {
+        for (int round = 0; round < 200; ++round) {
+            // Mostly executable slots, so that the runs reach past the first blocks
+            slots.resize(count);
+            for (uint64_t &slot : slots)
+                slot = random() % 8 ? 0x1000 + random() % 0x1000 : values[random() % values.size()];
+            const size_t expected =
+                variants[0](slots.data(), count, ranges.data(), ranges.size());
+            for (size_t v = 1; v < variants.size(); ++v)
+                expect(variants[v](slots.data(), count, ranges.data(), ranges.size()) == expected,
+                       fmt::format("variant {} disagrees on {} slots", v, count));
+        }
+    }
+}
+
+}  // namespace
+
+int main() {
+    checkVtableWithoutRtti();
+    checkConstructionVtable();
+    checkCountExecutable();
+    return failures ? 1 : 0;
+}
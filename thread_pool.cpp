@@ -0,0 +1,65 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace skald {
+
+ThreadPool::ThreadPool(size_t threads) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (size_t i = 1; i < threads; ++i) {
+        this->workers.emplace_back([this] {
+            while (true) {
+                std::function<void()> task;
+                {
+                    std::unique_lock lock(this->mutex);
+                    this->cv.wait(lock, [this] { return this->stopping || !this->tasks.empty(); });
+                    if (this->stopping && this->tasks.empty()) return;
+                    task = std::move(this->tasks.front());
+                    this->tasks.pop();
+                }
+                task();
+            }
+        });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(this->mutex);
+        this->stopping = true;
+    }
+    this->cv.notify_all();
+    for (auto &worker : this->workers) worker.join();
+}
+
+void ThreadPool::run(const std::function<void()> &work, size_t helpers) {
+    std::mutex doneMutex;
+    std::condition_variable doneCv;
+    size_t pending = helpers;
+
+    {
+        std::lock_guard lock(this->mutex);
+        for (size_t i = 0; i < helpers; ++i) {
+            this->tasks.push([&] {
+                work();
+                std::lock_guard doneLock(doneMutex);
+                if (--pending == 0) doneCv.notify_one();
+            });
+        }
+    }
+    this->cv.notify_all();
+
+    work();
+
+    std::unique_lock lock(doneMutex);
+    doneCv.wait(lock, [&] { return pending == 0; });
+}
+
+}  // namespace skald
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace skald {
+
+// Fixed size pool of worker threads
+class ThreadPool {
+   public:
+    // 0 threads means one per hardware thread
+    explicit ThreadPool(size_t threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    size_t size() const { return this->workers.size() + 1; }  // The caller also takes part
+
+    // Call `fn(i)` for every i in [0, count) and wait for all of them to complete. The calling
+    // thread participates in the work. The first exception thrown is rethrown here
+    template <typename F>
+    void parallelFor(size_t count, F &&fn) {
+        if (count == 0) return;
+        if (this->workers.empty() || count == 1) {
+            for (size_t i = 0; i < count; ++i) fn(i);
+            return;
+        }
+
+        // Small chunks keep the load balanced when the cost per item varies a lot
+        const size_t chunk = std::max<size_t>(1, count / (this->size() * 8));
+        std::atomic<size_t> next = 0;
+        std::exception_ptr error;
+        std::mutex errorMutex;
+
+        auto work = [&] {
+            for (size_t start = next.fetch_add(chunk); start < count;
+                 start = next.fetch_add(chunk)) {
+                const size_t end = std::min(count, start + chunk);
+                try {
+                    for (size_t i = start; i < end; ++i) fn(i);
+                } catch (...) {
+                    std::lock_guard lock(errorMutex);
+                    if (!error) error = std::current_exception();
+                    next = count;  // Stop handing out work
+                }
+            }
+        };
+
+        const size_t helpers = std::min(this->workers.size(), (count + chunk - 1) / chunk - 1);
+        this->run(work, helpers);
+        if (error) std::rethrow_exception(error);
+    }
+
+   private:
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stopping = false;
+
+    // Execute `work` on `helpers` workers and on the calling thread, then wait
+    void run(const std::function<void()> &work, size_t helpers);
+};
+
+}  // namespace skald
@@ -0,0 +1,460 @@
+#include "trace_backend.h"
+
+#include <fcntl.h>
+#include <fmt/format.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "backend.h"
+
+namespace skald {
+
+namespace {
+
+// The trace is made of the header, the fixed size tables and the blob holding the strings and the
+// bytes read. Everything is little endian and 8 bytes aligned so that the mapping is used in place
+static_assert(std::endian::native == std::endian::little, "The trace is mapped as is");
+
+constexpr uint32_t MAGIC = 0x52544b53;  // "SKTR"
+// Version 2 added the ABI, the traces of version 1 are all of 64-bit little endian binaries.
+// Version 3 added the addends of the relocations
+constexpr uint32_t VERSION = 3;
+
+// Addend of a relocation that is unknown or does not fit in the trace
+constexpr int32_t NO_ADDEND = INT32_MIN;
+
+// Answer of getSectionAt() when there is no section
+constexpr uint32_t NO_SECTION = UINT32_MAX;
+
+struct TraceTable {
+    uint64_t offset;  // From the start of the file
+    uint64_t count;
+};
+
+struct TraceHeader {
+    uint32_t magic;
+    uint32_t version;
+    TraceTable sections;
+    TraceTable segments;
+    TraceTable sectionsAt;
+    TraceTable symbols;
+    TraceTable relocations;
+    TraceTable ranges;
+    TraceTable answers;
+    uint32_t pointerSize;  // Since version 2, like the fields below
+    uint8_t bigEndian;
+    uint8_t variant;
+    uint16_t reserved;
+};
+
+struct TraceSection {
+    uint64_t start;
+    uint64_t end;
+    uint64_t nameOffset;
+    uint32_t nameSize;
+    uint32_t flags;
+};
+
+struct TraceString {
+    uint64_t offset;
+    uint64_t size;
+};
+
+struct TraceRelocation {
+    uint64_t address;
+    uint32_t symbol;
+    int32_t addend;  // Since version 3
+};
+
+struct TraceRange {
+    uint64_t start;
+    uint64_t size;
+    uint64_t offset;  // Of the bytes
+};
+
+struct TraceAnswer {
+    uint64_t address;
+    uint32_t query;
+    uint32_t value;
+};
+
+static_assert(sizeof(TraceHeader) == 128 && sizeof(TraceSection) == 32 &&
+              sizeof(TraceString) == 16 && sizeof(TraceRelocation) == 16 &&
+              sizeof(TraceRange) == 24 && sizeof(TraceAnswer) == 16);
+
+// Builds the tables and the blob, which is placed at `blobStart` in the file
+class TraceWriter {
+   public:
+    explicit TraceWriter(uint64_t blobStart) : blobStart(blobStart) {}
+
+    template <typename T>
+    void add(std::vector<uint8_t> &table, const T &entry) {
+        const auto *bytes = reinterpret_cast<const uint8_t *>(&entry);
+        table.insert(table.end(), bytes, bytes + sizeof(T));
+    }
+
+    // Offset of `bytes` in the file, 8 bytes aligned
+    uint64_t addBlob(std::span<const uint8_t> bytes) {
+        const uint64_t offset = this->blobStart + this->blob.size();
+        this->blob.insert(this->blob.end(), bytes.begin(), bytes.end());
+        this->blob.resize((this->blob.size() + 7) & ~uint64_t{7});
+        return offset;
+    }
+
+    uint64_t addBlob(std::string_view text) {
+        const auto *bytes = reinterpret_cast<const uint8_t *>(text.data());
+        return this->addBlob(std::span(bytes, text.size()));
+    }
+
+    uint64_t blobStart;
+    std::vector<uint8_t> blob;
+};
+
+// Entries of `table`, checking the bounds
+template <typename T>
+std::span<const T> tableAt(const uint8_t *data, size_t size, const TraceTable &table) {
+    if (table.offset > size || table.count > (size - table.offset) / sizeof(T))
+        throw std::runtime_error("Truncated trace");
+    return {reinterpret_cast<const T *>(data + table.offset), table.count};
+}
+
+std::string_view stringAt(const uint8_t *data, size_t size, uint64_t offset, uint64_t length) {
+    if (offset > size || length > size - offset) throw std::runtime_error("Truncated trace");
+    return {reinterpret_cast<const char *>(data + offset), length};
+}
+
+std::vector<Section> readSections(const uint8_t *data, size_t size, const TraceTable &table) {
+    std::vector<Section> sections;
+    for (const TraceSection &section : tableAt<TraceSection>(data, size, table)) {
+        const std::string_view name = stringAt(data, size, section.nameOffset, section.nameSize);
+        sections.push_back({std::string(name), section.start, section.end,
+                            static_cast<SectionFlag>(section.flags)});
+    }
+    return sections;
+}
+
+void addSections(TraceWriter &writer, std::vector<uint8_t> &table,
+                 const std::vector<Section> &sections) {
+    for (const Section &section : sections)
+        writer.add(table, TraceSection{section.start, section.end, writer.addBlob(section.name),
+                                       static_cast<uint32_t>(section.name.size()),
+                                       static_cast<uint32_t>(section.flags)});
+}
+
+}  // namespace
+
+TraceRecorder::TraceRecorder(Backend &backend) : backend(backend) {}
+
+std::vector<Section> TraceRecorder::getSections() {
+    std::vector<Section> sections = this->backend.getSections();
+    std::lock_guard lock(this->mutex);
+    if (!this->sections) this->sections = sections;
+    return sections;
+}
+
+std::vector<Section> TraceRecorder::getSegments() {
+    std::vector<Section> segments = this->backend.getSegments();
+    std::lock_guard lock(this->mutex);
+    if (!this->segments) this->segments = segments;
+    return segments;
+}
+
+RelocationTable TraceRecorder::getRelocations() {
+    RelocationTable relocations = this->backend.getRelocations();
+    std::lock_guard lock(this->mutex);
+    if (!this->relocations) this->relocations = relocations;
+    return relocations;
+}
+
+size_t TraceRecorder::read(void *dest, address_t address, size_t len) {
+    const size_t read = this->backend.read(dest, address, len);
+    if (read) this->recordRange(address, std::span(static_cast<const uint8_t *>(dest), read));
+    return read;
+}
+
+bool TraceRecorder::isValidOffset(address_t address) {
+    return this->recordAnswer(TraceQuery::VALID_OFFSET, address,
+                              this->backend.isValidOffset(address));
+}
+
+bool TraceRecorder::isOffsetReadable(address_t address) {
+    return this->recordAnswer(TraceQuery::OFFSET_READABLE, address,
+                              this->backend.isOffsetReadable(address));
+}
+
+bool TraceRecorder::isOffsetExecutable(address_t address) {
+    return this->recordAnswer(TraceQuery::OFFSET_EXECUTABLE, address,
+                              this->backend.isOffsetExecutable(address));
+}
+
+std::optional<Section> TraceRecorder::getSectionAt(address_t address) {
+    std::optional<Section> section = this->backend.getSectionAt(address);
+
+    std::lock_guard lock(this->mutex);
+    uint32_t index = NO_SECTION;
+    if (section) {
+        auto it = std::ranges::find(this->sectionsAt, *section);
+        index = static_cast<uint32_t>(std::distance(this->sectionsAt.begin(), it));
+        if (it == this->sectionsAt.end()) this->sectionsAt.push_back(*section);
+    }
+    this->answers.try_emplace({TraceQuery::SECTION_AT, address}, index);
+    return section;
+}
+
+bool TraceRecorder::recordAnswer(TraceQuery query, address_t address, bool answer) {
+    std::lock_guard lock(this->mutex);
+    this->answers.try_emplace({query, address}, answer);
+    return answer;
+}
+
+void TraceRecorder::recordRange(address_t address, std::span<const uint8_t> bytes) {
+    const address_t start = address;
+    const address_t end = address + bytes.size();
+    std::lock_guard lock(this->mutex);
+
+    // First range touching [start, end)
+    auto first = this->ranges.upper_bound(start);
+    if (first != this->ranges.begin()) {
+        auto previous = std::prev(first);
+        if (previous->first + previous->second.size() >= start) first = previous;
+    }
+    auto last = first;
+    while (last != this->ranges.end() && last->first <= end) ++last;
+
+    // Most reads are sequential, they fall in or extend a single range
+    if (first != last && std::next(first) == last && first->first <= start) {
+        std::vector<uint8_t> &range = first->second;
+        const address_t rangeEnd = first->first + range.size();
+        if (end > rangeEnd) range.insert(range.end(), bytes.end() - (end - rangeEnd), bytes.end());
+        return;
+    }
+
+    // Otherwise merge every range touched into a new one
+    address_t mergedStart = start;
+    address_t mergedEnd = end;
+    if (first != last) {
+        mergedStart = std::min(mergedStart, first->first);
+        const auto &[lastStart, lastBytes] = *std::prev(last);
+        mergedEnd = std::max(mergedEnd, lastStart + lastBytes.size());
+    }
+    std::vector<uint8_t> merged(mergedEnd - mergedStart);
+    for (auto it = first; it != last; ++it)
+        std::ranges::copy(it->second, merged.begin() + (it->first - mergedStart));
+    std::ranges::copy(bytes, merged.begin() + (start - mergedStart));
+
+    this->ranges.erase(first, last);
+    this->ranges.emplace(mergedStart, std::move(merged));
+}
+
+void TraceRecorder::save(const std::filesystem::path &path) {
+    // The whole binary queries are needed to replay any run
+    if (!this->sections) this->getSections();
+    if (!this->segments) this->getSegments();
+    if (!this->relocations) this->getRelocations();
+
+    std::lock_guard lock(this->mutex);
+
+    // The tables follow the header, then comes the blob
+    const Abi abi = this->backend.getAbi();
+    TraceHeader header{};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.pointerSize = abi.pointerSize;
+    header.bigEndian = abi.order == std::endian::big;
+    header.variant = static_cast<uint8_t>(abi.variant);
+    uint64_t offset = sizeof(TraceHeader);
+    const auto place = [&](TraceTable &table, size_t count, size_t entrySize) {
+        table = {offset, count};
+        offset += count * entrySize;
+    };
+    place(header.sections, this->sections->size(), sizeof(TraceSection));
+    place(header.segments, this->segments->size(), sizeof(TraceSection));
+    place(header.sectionsAt, this->sectionsAt.size(), sizeof(TraceSection));
+    place(header.symbols, this->relocations->symbols.size(), sizeof(TraceString));
+    place(header.relocations, this->relocations->relocations.size(), sizeof(TraceRelocation));
+    place(header.ranges, this->ranges.size(), sizeof(TraceRange));
+    place(header.answers, this->answers.size(), sizeof(TraceAnswer));
+
+    TraceWriter writer(offset);
+    std::vector<uint8_t> sections, segments, sectionsAt, symbols, relocations, ranges, answers;
+    addSections(writer, sections, *this->sections);
+    addSections(writer, segments, *this->segments);
+    addSections(writer, sectionsAt, this->sectionsAt);
+    for (const std::string &symbol : this->relocations->symbols)
+        writer.add(symbols, TraceString{writer.addBlob(symbol), symbol.size()});
+    for (const Relocation &relocation : this->relocations->relocations) {
+        const bool fits = relocation.addend > NO_ADDEND && relocation.addend <= INT32_MAX;
+        writer.add(relocations,
+                   TraceRelocation{relocation.address, relocation.symbol,
+                                   fits ? static_cast<int32_t>(relocation.addend) : NO_ADDEND});
+    }
+    for (const auto &[start, bytes] : this->ranges)
+        writer.add(ranges, TraceRange{start, bytes.size(), writer.addBlob(bytes)});
+    for (const auto &[key, value] : this->answers)
+        writer.add(answers, TraceAnswer{key.second, static_cast<uint32_t>(key.first), value});
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    for (const auto *table : {&sections, &segments, &sectionsAt, &symbols, &relocations, &ranges,
+                              &answers, &writer.blob})
+        file.write(reinterpret_cast<const char *>(table->data()), table->size());
+    if (!file.flush())
+        throw std::runtime_error(fmt::format("Cannot write the trace to `{}`", path.string()));
+}
+
+TraceBackend::TraceBackend(const std::filesystem::path &path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error(fmt::format("Cannot open `{}`", path.string()));
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(TraceHeader))) {
+        close(fd);
+        throw std::runtime_error(fmt::format("`{}` is too small to be a trace", path.string()));
+    }
+
+    this->size = st.st_size;
+    void *mapping = mmap(nullptr, this->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+        throw std::runtime_error(fmt::format("Cannot map `{}`", path.string()));
+    this->data = static_cast<uint8_t *>(mapping);
+
+    try {
+        this->parse();
+    } catch (...) {
+        munmap(this->data, this->size);
+        throw;
+    }
+}
+
+TraceBackend::~TraceBackend() {
+    if (this->data) munmap(this->data, this->size);
+}
+
+bool TraceBackend::isTrace(const std::filesystem::path &path) {
+    uint32_t magic = 0;
+    std::ifstream file(path, std::ios::binary);
+    return file.read(reinterpret_cast<char *>(&magic), sizeof(magic)) && magic == MAGIC;
+}
+
+void TraceBackend::parse() {
+    const auto &header = *reinterpret_cast<const TraceHeader *>(this->data);
+    if (header.magic != MAGIC) throw std::runtime_error("Not a skald trace");
+    if (header.version < 1 || header.version > VERSION)
+        throw std::runtime_error(fmt::format("Unsupported trace version {}", header.version));
+    if (header.version >= 2) {
+        this->abi = {header.pointerSize, header.bigEndian ? std::endian::big : std::endian::little,
+                     static_cast<CxxAbi>(header.variant)};
+    }
+
+    this->sections = readSections(this->data, this->size, header.sections);
+    this->segments = readSections(this->data, this->size, header.segments);
+    this->sectionsAt = readSections(this->data, this->size, header.sectionsAt);
+
+    for (const TraceString &symbol : tableAt<TraceString>(this->data, this->size, header.symbols))
+        this->relocations.symbols.emplace_back(
+            stringAt(this->data, this->size, symbol.offset, symbol.size));
+    for (const TraceRelocation &relocation :
+         tableAt<TraceRelocation>(this->data, this->size, header.relocations)) {
+        if (relocation.symbol != NO_SYMBOL &&
+            relocation.symbol >= this->relocations.symbols.size())
+            throw std::runtime_error("Invalid relocation in the trace");
+        const bool known = header.version >= 3 && relocation.addend != NO_ADDEND;
+        this->relocations.relocations.push_back(
+            {relocation.address, relocation.symbol, known ? relocation.addend : UNKNOWN_ADDEND});
+    }
+
+    // The bytes are not copied, they are read from the mapping
+    for (const TraceRange &range : tableAt<TraceRange>(this->data, this->size, header.ranges)) {
+        const std::string_view bytes = stringAt(this->data, this->size, range.offset, range.size);
+        this->ranges.push_back(
+            {range.start, range.size, reinterpret_cast<const uint8_t *>(bytes.data())});
+    }
+    if (!std::ranges::is_sorted(this->ranges, {}, &Range::start))
+        throw std::runtime_error("Unsorted ranges in the trace");
+
+    for (const TraceAnswer &answer : tableAt<TraceAnswer>(this->data, this->size, header.answers))
+        this->answers.push_back(
+            {static_cast<TraceQuery>(answer.query), answer.address, answer.value});
+    if (!std::ranges::is_sorted(this->answers, {}, [](const Answer &answer) {
+            return std::pair(answer.query, answer.address);
+        }))
+        throw std::runtime_error("Unsorted answers in the trace");
+}
+
+size_t TraceBackend::read(void *dest, address_t address, size_t len) {
+    // The recorded ranges are not adjacent, a read never spans two of them
+    auto it = std::ranges::upper_bound(this->ranges, address, {}, &Range::start);
+    if (it == this->ranges.begin()) return 0;
+    --it;
+    const uint64_t offset = address - it->start;
+    if (offset >= it->size) return 0;
+    const size_t count = std::min<uint64_t>(len, it->size - offset);
+    std::memcpy(dest, it->data + offset, count);
+    return count;
+}
+
+bool TraceBackend::isValidOffset(address_t address) {
+    if (const Answer *answer = this->findAnswer(TraceQuery::VALID_OFFSET, address))
+        return answer->value;
+    return this->findSegment(address) != nullptr;
+}
+
+bool TraceBackend::isOffsetReadable(address_t address) {
+    if (const Answer *answer = this->findAnswer(TraceQuery::OFFSET_READABLE, address))
+        return answer->value;
+    const Section *segment = this->findSegment(address);
+    return segment && segment->flags & SectionFlag::READABLE;
+}
+
+bool TraceBackend::isOffsetExecutable(address_t address) {
+    if (const Answer *answer = this->findAnswer(TraceQuery::OFFSET_EXECUTABLE, address))
+        return answer->value;
+    const Section *segment = this->findSegment(address);
+    return segment && segment->flags & SectionFlag::EXECUTABLE;
+}
+
+std::optional<Section> TraceBackend::getSectionAt(address_t address) {
+    if (const Answer *answer = this->findAnswer(TraceQuery::SECTION_AT, address)) {
+        if (answer->value >= this->sectionsAt.size()) return std::nullopt;
+        return this->sectionsAt[answer->value];
+    }
+    for (const Section &section : this->sections)
+        if (address >= section.start && address < section.end) return section;
+    return std::nullopt;
+}
+
+const TraceBackend::Answer *TraceBackend::findAnswer(TraceQuery query, address_t address) const {
+    auto it = std::ranges::lower_bound(this->answers, std::pair(query, address), {},
+                                       [](const Answer &answer) {
+                                           return std::pair(answer.query, answer.address);
+                                       });
+    if (it == this->answers.end() || it->query != query || it->address != address) return nullptr;
+    return &*it;
+}
+
+const Section *TraceBackend::findSegment(address_t address) const {
+    for (const Section &segment : this->segments)
+        if (address >= segment.start && address < segment.end) return &segment;
+    return nullptr;
+}
+
+}  // namespace skald
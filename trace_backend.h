@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "backend.h"
+
+namespace skald {
+
+// Record and replay of the queries made to a backend, to profile the recovery offline and to attach
+// a reproducer to a report without sharing the binary. TraceRecorder forwards every query to the
+// real backend and keeps the answers, TraceBackend answers the same queries later from the saved
+// trace. The trace only contains the bytes that were actually read
+
+// Kind of the queries answered with a single value
+enum class TraceQuery : uint32_t { VALID_OFFSET, OFFSET_READABLE, OFFSET_EXECUTABLE, SECTION_AT };
+
+class TraceRecorder : public Backend {
+   public:
+    explicit TraceRecorder(Backend &backend);
+
+    // Write the trace of the queries made so far. The whole binary queries (sections, segments
+    // and relocations) are always part of it, even if they were not made. Throws on I/O errors
+    void save(const std::filesystem::path &path);
+
+    std::vector<Section> getSections() override;
+    std::vector<Section> getSegments() override;
+    RelocationTable getRelocations() override;
+    size_t read(void *dest, address_t address, size_t len) override;
+    bool isValidOffset(address_t address) override;
+    bool isOffsetReadable(address_t address) override;
+    bool isOffsetExecutable(address_t address) override;
+    std::optional<Section> getSectionAt(address_t address) override;
+    uint64_t getGeneration() override { return this->backend.getGeneration(); }
+    Abi getAbi() override { return this->backend.getAbi(); }
+
+   private:
+    Backend &backend;
+
+    std::mutex mutex;
+    std::optional<std::vector<Section>> sections;
+    std::optional<std::vector<Section>> segments;
+    std::optional<RelocationTable> relocations;
+    std::map<address_t, std::vector<uint8_t>> ranges;  // Bytes read, disjoint and not adjacent
+    std::map<std::pair<TraceQuery, address_t>, uint32_t> answers;
+    std::vector<Section> sectionsAt;  // Answers of getSectionAt(), referenced by index
+
+    void recordRange(address_t address, std::span<const uint8_t> bytes);
+    bool recordAnswer(TraceQuery query, address_t address, bool answer);
+};
+
+// Backend answering the queries from a trace written by TraceRecorder. The file is mapped in
+// memory as is. The queries that were not recorded are answered from the recorded segments and
+// sections, reads outside of the recorded bytes fail
+class TraceBackend : public Backend {
+   public:
+    explicit TraceBackend(const std::filesystem::path &path);
+    ~TraceBackend() override;
+
+    TraceBackend(const TraceBackend &) = delete;
+    TraceBackend &operator=(const TraceBackend &) = delete;
+
+    // Check the trace magic without mapping the whole file
+    static bool isTrace(const std::filesystem::path &path);
+
+    std::vector<Section> getSections() override { return this->sections; }
+    std::vector<Section> getSegments() override { return this->segments; }
+    RelocationTable getRelocations() override { return this->relocations; }
+    size_t read(void *dest, address_t address, size_t len) override;
+    bool isValidOffset(address_t address) override;
+    bool isOffsetReadable(address_t address) override;
+    bool isOffsetExecutable(address_t address) override;
+    std::optional<Section> getSectionAt(address_t address) override;
+    Abi getAbi() override { return this->abi; }
+
+   private:
+    struct Range {
+        address_t start;
+        uint64_t size;
+        const uint8_t *data;  // Points inside the mapping
+    };
+
+    struct Answer {
+        TraceQuery query;
+        address_t address;
+        uint32_t value;
+    };
+
+    uint8_t *data = nullptr;
+    size_t size = 0;
+
+    std::vector<Section> sections;
+    std::vector<Section> segments;
+    std::vector<Section> sectionsAt;
+    RelocationTable relocations;
+    Abi abi;
+    std::vector<Range> ranges;    // Sorted by address
+    std::vector<Answer> answers;  // Sorted by query and address
+
+    void parse();
+    const Answer *findAnswer(TraceQuery query, address_t address) const;
+    const Section *findSegment(address_t address) const;
+};
+
+}  // namespace skald
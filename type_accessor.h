@@ -1,30 +1,66 @@
 #pragma once
 
-#include <any>
-#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
 #include <string>
-#include <string_view>
-#include <unordered_map>
+#include <type_traits>
 
-#include "binaryninjaapi.h"
+#include "abi.h"
+#include "backend.h"
+#include "types.h"
 
 namespace skald {
 
-static const constexpr std::array<const char *, 13> TYPE_CLASS = {
-    "VoidTypeClass",      "BoolTypeClass",        "IntegerTypeClass", "FloatTypeClass",
-    "StructureTypeClass", "EnumerationTypeClass", "PointerTypeClass", "ArrayTypeClass",
-    "FunctionTypeClass",  "VarArgsTypeClass",     "ValueTypeClass",   "NamedTypeReferenceClass",
-    "WideCharTypeClass"};
-
+// Typed reads on top of the raw `Backend` memory accessor
 class TypeAccessor {
    public:
-    TypeAccessor(BinaryNinja::BinaryView *view);
-    std::string readString(uint64_t address, const std::string &name);
-    std::unordered_map<std::string, std::any> readVar(uint64_t address);
-    std::any readValue(const BinaryNinja::Ref<BinaryNinja::Type> &type, uint64_t address);
+    TypeAccessor(Backend &backend);
+    std::string readString(uint64_t address);
+
+    // Read `bytes.size()` bytes in a single request. Returns how many were read
+    size_t readBytes(uint64_t address, std::span<uint8_t> bytes);
+
+    // Pointer of the ABI `A`, 0 if it can not be read
+    template <typename A>
+    address_t readPointer(uint64_t address) {
+        return A::load(this->readValue<typename A::pointer_t>(address));
+    }
+
+    // Signed pointer-sized value of the ABI `A` (`offset_to_top`, vbase offsets...)
+    template <typename A>
+    int64_t readOffset(uint64_t address) {
+        return A::loadOffset(this->readValue<typename A::pointer_t>(address));
+    }
+
+    // Read consecutive pointers of the ABI `A` in a single request. Returns how many were read
+    template <typename A>
+    size_t readPointers(uint64_t address, std::span<address_t> pointers) {
+        auto *bytes = reinterpret_cast<uint8_t *>(pointers.data());
+        const size_t count =
+            this->backend.read(bytes, address, pointers.size() * A::POINTER_SIZE) / A::POINTER_SIZE;
+        if constexpr (!A::NATIVE) {
+            // Widened in place from the end, a word is never overwritten before being decoded
+            for (size_t i = count; i-- > 0;) {
+                typename A::pointer_t word;
+                std::memcpy(&word, bytes + i * A::POINTER_SIZE, sizeof(word));
+                pointers[i] = A::load(word);
+            }
+        }
+        return count;
+    }
+
+    template <typename T>
+        requires std::is_trivially_copyable_v<T>
+    T readValue(uint64_t address) {
+        T value{};
+        this->backend.read(&value, address, sizeof(T));
+        return value;
+    }
 
    private:
-    BinaryNinja::BinaryView *_view;
+    Backend &backend;
 };
 
-}  // namespace skald
\ No newline at end of file
+}  // namespace skald
@@ -0,0 +1,90 @@
+#include "type_interner.h"
+
+#include <fmt/format.h>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "binaryninjaapi.h"
+#include "instrumentation.h"
+#include "log.h"
+
+namespace skald {
+
+using BinaryNinja::QualifiedName;
+using BinaryNinja::Ref;
+using BinaryNinja::Type;
+
+TypeInterner::TypeInterner(BinaryNinja::BinaryView *view)
+    : _view(view),
+      voidPointer(Type::PointerType(view->GetDefaultArchitecture(), Type::VoidType())),
+      charPointer(Type::PointerType(view->GetDefaultArchitecture(),
+                                    Type::IntegerType(1, false, "char"))) {}
+
+Ref<Type> TypeInterner::getNamed(const std::string &name,
+                                 const std::function<Ref<Type>()> &build) {
+    if (auto it = this->named.find(name); it != this->named.end()) return it->second;
+
+    // Single lookup per name, the next requests are served from the cache
+    Ref<Type> type = _view->GetTypeByName(QualifiedName(name));
+    if (!type) {
+        type = build();
+        this->pending.push_back({QualifiedName(name), type});
+    }
+    this->names[type->GetObject()] = name;
+    this->named.emplace(name, type);
+    return type;
+}
+
+void TypeInterner::define(const std::string &name, Ref<Type> type) {
+    this->pending.push_back({QualifiedName(name), std::move(type)});
+}
+
+Ref<Type> TypeInterner::getReference(const std::string &name) {
+    auto [it, inserted] = this->references.try_emplace(name);
+    if (inserted) it->second = Type::NamedType(_view, QualifiedName(name));
+    return it->second;
+}
+
+Ref<Type> TypeInterner::getReference(const Ref<Type> &type) {
+    auto it = this->names.find(type->GetObject());
+    return it != this->names.end() ? this->getReference(it->second) : type;
+}
+
+Ref<Type> TypeInterner::getFunctionPointer(
+    const Ref<Type> &returnType, const std::vector<BinaryNinja::FunctionParameter> &params) {
+    // The signature is the key, made of the canonical handles of its types
+    std::string key = fmt::format("{}", fmt::ptr(this->intern(returnType)));
+    for (const auto &param : params)
+        key += fmt::format("|{} {}", fmt::ptr(this->intern(param.type.GetValue())), param.name);
+
+    auto [it, inserted] = this->functionPointers.try_emplace(std::move(key));
+    if (inserted) {
+        auto function = Type::FunctionType(
+            returnType, _view->GetDefaultPlatform()->GetDefaultCallingConvention(), params);
+        it->second = Type::PointerType(_view->GetDefaultArchitecture(), function);
+    }
+    return it->second;
+}
+
+BNType *TypeInterner::intern(const Ref<Type> &type) {
+    // Equal types have distinct handles, they are compared by the core within a bucket
+    auto &bucket = this->canonical[uint64_t{type->GetClass()} << 56 ^ type->GetWidth()];
+    for (const Ref<Type> &known : bucket)
+        if (known->GetObject() == type->GetObject() || *known == *type) return known->GetObject();
+    bucket.push_back(type);
+    return type->GetObject();
+}
+
+void TypeInterner::flush() {
+    if (this->pending.empty()) return;
+    logDebug("Defining {} types", this->pending.size());
+    SKALD_COUNT(DEFINE_TYPES, this->pending.size());
+    _view->DefineUserTypes(this->pending);
+    this->pending.clear();
+}
+
+}  // namespace skald
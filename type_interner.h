@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "binaryninjaapi.h"
+
+namespace skald {
+
+// Cache of the types created by the Annotator, each distinct type is built once and shared. The
+// named types are not registered right away: `flush()` defines all the pending ones at once
+class TypeInterner {
+   public:
+    explicit TypeInterner(BinaryNinja::BinaryView *view);
+
+    // Named type defined once: it is taken from the view if it already exists there, otherwise
+    // `build` creates it and it becomes pending. The structure itself is returned, so that it can
+    // be used by other types before being registered
+    BinaryNinja::Ref<BinaryNinja::Type> getNamed(
+        const std::string &name, const std::function<BinaryNinja::Ref<BinaryNinja::Type>()> &build);
+
+    // Named type (re)defined with `type`, replacing any previous definition
+    void define(const std::string &name, BinaryNinja::Ref<BinaryNinja::Type> type);
+
+    // Reference to the named type `name`, valid once it has been flushed
+    BinaryNinja::Ref<BinaryNinja::Type> getReference(const std::string &name);
+
+    // Reference to the named type of `type` if it was returned by `getNamed()`, else `type`
+    BinaryNinja::Ref<BinaryNinja::Type> getReference(
+        const BinaryNinja::Ref<BinaryNinja::Type> &type);
+
+    BinaryNinja::Ref<BinaryNinja::Type> getVoidPointer() const { return this->voidPointer; }
+    BinaryNinja::Ref<BinaryNinja::Type> getCharPointer() const { return this->charPointer; }
+
+    // Pointer to a function of the default calling convention. Functions sharing the same
+    // signature share the same type
+    BinaryNinja::Ref<BinaryNinja::Type> getFunctionPointer(
+        const BinaryNinja::Ref<BinaryNinja::Type> &returnType,
+        const std::vector<BinaryNinja::FunctionParameter> &params);
+
+    // Define all the pending named types with a single call
+    void flush();
+
+   private:
+    BinaryNinja::BinaryView *_view;
+    BinaryNinja::Ref<BinaryNinja::Type> voidPointer;
+    BinaryNinja::Ref<BinaryNinja::Type> charPointer;
+
+    std::unordered_map<std::string, BinaryNinja::Ref<BinaryNinja::Type>> named;
+    std::unordered_map<BNType *, std::string> names;  // Types kept alive by `named`
+    std::unordered_map<std::string, BinaryNinja::Ref<BinaryNinja::Type>> references;
+    std::unordered_map<std::string, BinaryNinja::Ref<BinaryNinja::Type>> functionPointers;
+    // First of the equal types seen, grouped by class and width. Their handles make up the keys
+    // of `functionPointers`
+    std::unordered_map<uint64_t, std::vector<BinaryNinja::Ref<BinaryNinja::Type>>> canonical;
+    std::vector<BinaryNinja::QualifiedNameAndType> pending;
+
+    // Handle of the first type equal to `type`, kept alive by `canonical`
+    BNType *intern(const BinaryNinja::Ref<BinaryNinja::Type> &type);
+};
+
+}  // namespace skald
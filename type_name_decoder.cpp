@@ -0,0 +1,804 @@
+#include "type_name_decoder.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace skald {
+
+namespace {
+
+struct Abbreviation {
+    std::string_view code;
+    std::string_view text;
+};
+
+// Builtin types, `<builtin-type>`
+constexpr std::array<Abbreviation, 32> BUILTIN_TYPES{{
+    {"v", "void"},          {"w", "wchar_t"},
+    {"b", "bool"},          {"c", "char"},
+    {"a", "signed char"},   {"h", "unsigned char"},
+    {"s", "short"},         {"t", "unsigned short"},
+    {"i", "int"},           {"j", "unsigned int"},
+    {"l", "long"},          {"m", "unsigned long"},
+    {"x", "long long"},     {"y", "unsigned long long"},
+    {"n", "__int128"},      {"o", "unsigned __int128"},
+    {"f", "float"},         {"d", "double"},
+    {"e", "long double"},   {"g", "__float128"},
+    {"z", "..."},           {"Dd", "decimal64"},
+    {"De", "decimal128"},   {"Df", "decimal32"},
+    {"Dh", "half"},         {"DF16_", "_Float16"},
+    {"Di", "char32_t"},     {"Ds", "char16_t"},
+    {"Du", "char8_t"},      {"Da", "auto"},
+    {"Dc", "decltype(auto)"}, {"Dn", "decltype(nullptr)"},
+}};
+
+// Abbreviations of the standard library, `<substitution>` that are not part of the table. Expanded
+// in full like `c++filt` does
+constexpr std::array<Abbreviation, 6> STD_ABBREVIATIONS{{
+    {"Sa", "std::allocator"},
+    {"Sb", "std::basic_string"},
+    {"Ss", "std::basic_string<char, std::char_traits<char>, std::allocator<char> >"},
+    {"Si", "std::basic_istream<char, std::char_traits<char> >"},
+    {"So", "std::basic_ostream<char, std::char_traits<char> >"},
+    {"Sd", "std::basic_iostream<char, std::char_traits<char> >"},
+}};
+
+// `<operator-name>`, the conversion and literal operators are handled apart
+constexpr std::array<Abbreviation, 49> OPERATORS{{
+    {"nw", "new"},  {"na", "new[]"}, {"dl", "delete"}, {"da", "delete[]"}, {"aw", "co_await"},
+    {"ps", "+"},    {"ng", "-"},     {"ad", "&"},      {"de", "*"},        {"co", "~"},
+    {"pl", "+"},    {"mi", "-"},     {"ml", "*"},      {"dv", "/"},        {"rm", "%"},
+    {"an", "&"},    {"or", "|"},     {"eo", "^"},      {"aS", "="},        {"pL", "+="},
+    {"mI", "-="},   {"mL", "*="},    {"dV", "/="},     {"rM", "%="},       {"aN", "&="},
+    {"oR", "|="},   {"eO", "^="},    {"ls", "<<"},     {"rs", ">>"},       {"lS", "<<="},
+    {"rS", ">>="},  {"eq", "=="},    {"ne", "!="},     {"lt", "<"},        {"gt", ">"},
+    {"le", "<="},   {"ge", ">="},    {"ss", "<=>"},    {"nt", "!"},        {"aa", "&&"},
+    {"oo", "||"},   {"pp", "++"},    {"mm", "--"},     {"cm", ","},        {"pm", "->*"},
+    {"pt", "->"},   {"cl", "()"},    {"ix", "[]"},     {"qu", "?"},
+}};
+
+// Suffix of the integer literals in the template arguments, by type
+constexpr std::array<Abbreviation, 6> LITERAL_SUFFIXES{{
+    {"i", ""}, {"j", "u"}, {"l", "l"}, {"m", "ul"}, {"x", "ll"}, {"y", "ull"},
+}};
+
+// Last component of a qualified name without its template arguments, the name of the constructors
+std::string_view unqualifiedName(std::string_view name) {
+    size_t end = name.size();
+    if (name.ends_with('>')) {
+        size_t nesting = 0;
+        while (end > 0) {
+            const char c = name[--end];
+            if (c == '>')
+                ++nesting;
+            else if (c == '<' && --nesting == 0)
+                break;
+        }
+    }
+    name = name.substr(0, end);
+    const size_t separator = name.rfind("::");
+    return separator == std::string_view::npos ? name : name.substr(separator + 2);
+}
+
+}  // namespace
+
+std::string_view StringArena::store(std::string_view text) {
+    if (text.empty()) return {};
+
+    // Large strings get a chunk of their own, so that the current one is not wasted
+    if (text.size() > CHUNK_SIZE / 4) {
+        this->chunks.push_back(std::make_unique<char[]>(text.size()));
+        std::memcpy(this->chunks.back().get(), text.data(), text.size());
+        return {this->chunks.back().get(), text.size()};
+    }
+
+    if (text.size() > this->available) {
+        this->chunks.push_back(std::make_unique<char[]>(CHUNK_SIZE));
+        this->current = this->chunks.back().get();
+        this->available = CHUNK_SIZE;
+    }
+    char *start = this->current;
+    std::memcpy(start, text.data(), text.size());
+    this->current += text.size();
+    this->available -= text.size();
+    return {start, text.size()};
+}
+
+// Recursive descent parser of the `<type>` production, the text is appended to the output buffer
+// of the decoder. Every method returns false if the input is malformed or not supported
+class Demangler {
+   public:
+    Demangler(TypeNameDecoder &decoder, std::string_view input)
+        : input(input),
+          out(decoder.output),
+          candidates(decoder.candidates),
+          substitutions(decoder.substitutions),
+          templateArgs(decoder.templateArgs),
+          argStack(decoder.argStack) {
+        this->out.clear();
+        this->candidates.clear();
+        this->substitutions.clear();
+        this->templateArgs.clear();
+        this->argStack.clear();
+    }
+
+    bool decode() { return this->parseType() && this->position == this->input.size(); }
+
+   private:
+    typedef TypeNameDecoder::Declarator Declarator;
+    typedef TypeNameDecoder::Fragment Fragment;
+
+    // Nesting limit, malformed inputs could otherwise exhaust the stack
+    static constexpr size_t MAX_DEPTH = 256;
+
+    std::string_view input;
+    size_t position = 0;
+    size_t depth = 0;
+
+    std::string &out;
+    std::string &candidates;
+    std::vector<Fragment> &substitutions;
+    std::vector<Fragment> &templateArgs;
+    std::vector<Fragment> &argStack;
+
+    // Declarators of the type parsed last: the functions and the arrays take them in the middle,
+    // `void (*)(int)`, `int (&) [4]`, and so does a type that already has them, `void (**)(int)`
+    Declarator declarator = Declarator::NONE;
+    size_t insert = 0;
+
+    std::string_view lastSourceName;  // For the constructors and destructors
+    std::string_view functionQualifiers;
+    bool endsWithTemplateArgs = false;
+
+    char peek(size_t offset = 0) const {
+        return this->position + offset < this->input.size() ? this->input[this->position + offset]
+                                                            : '\0';
+    }
+
+    bool consume(std::string_view prefix) {
+        if (!this->input.substr(this->position).starts_with(prefix)) return false;
+        this->position += prefix.size();
+        return true;
+    }
+
+    void setPlain() { this->declarator = Declarator::NONE; }
+
+    // Copy the text appended since `start`, with the declarators of the type parsed last
+    Fragment copy(size_t start) {
+        const Fragment fragment{static_cast<uint32_t>(this->candidates.size()),
+                                static_cast<uint32_t>(this->out.size() - start),
+                                static_cast<uint32_t>(this->insert - std::min(start, this->insert)),
+                                this->declarator};
+        this->candidates.append(this->out, start);
+        return fragment;
+    }
+
+    void addSubstitution(size_t start) { this->substitutions.push_back(this->copy(start)); }
+
+    void append(const Fragment &fragment) {
+        this->insert = this->out.size() + fragment.insert;
+        this->declarator = fragment.declarator;
+        this->out.append(this->candidates, fragment.offset, fragment.length);
+        this->lastSourceName = unqualifiedName(
+            std::string_view(this->candidates).substr(fragment.offset, fragment.length));
+    }
+
+    // Add a declarator to the type parsed last
+    void addDeclarator(std::string_view text) {
+        switch (this->declarator) {
+            case Declarator::NONE:
+                this->out += text;
+                return;
+            case Declarator::GROUPED:
+                this->out.insert(this->insert, text);
+                this->insert += text.size();
+                return;
+            case Declarator::FUNCTION:
+            case Declarator::ARRAY: {
+                // The space before the parameters is taken by the group, the one of arrays stays
+                const bool space = this->out[this->insert] == ' ';
+                if (space && this->declarator == Declarator::FUNCTION)
+                    this->out.erase(this->insert, 1);
+                const std::string group = (space ? " (" : "(") + std::string(text) + ")";
+                this->out.insert(this->insert, group);
+                this->insert += group.size() - 1;
+                this->declarator = Declarator::GROUPED;
+                return;
+            }
+        }
+    }
+
+    // Add `const`, `volatile` or `restrict` to the type parsed last
+    void addQualifier(std::string_view text) {
+        if (this->declarator == Declarator::GROUPED) {
+            this->out.insert(this->insert, text);
+            this->insert += text.size();
+        } else {
+            this->out += text;
+        }
+    }
+
+    bool parseNumber(size_t &value) {
+        if (this->peek() < '0' || this->peek() > '9') return false;
+        value = 0;
+        while (this->peek() >= '0' && this->peek() <= '9') {
+            const size_t digit = this->peek() - '0';
+            if (value > (SIZE_MAX - digit) / 10) return false;
+            value = value * 10 + digit;
+            ++this->position;
+        }
+        return true;
+    }
+
+    // `_` is 0, `<number>_` is number + 1, in base 36 for the substitutions
+    bool parseSequenceId(size_t &id, int base) {
+        if (this->consume("_")) {
+            id = 0;
+            return true;
+        }
+        size_t value = 0;
+        while (this->peek() != '_') {
+            const char c = this->peek();
+            int digit;
+            if (c >= '0' && c <= '9')
+                digit = c - '0';
+            else if (base == 36 && c >= 'A' && c <= 'Z')
+                digit = c - 'A' + 10;
+            else
+                return false;
+            value = value * base + digit;
+            if (value > this->input.size()) return false;
+            ++this->position;
+        }
+        ++this->position;
+        id = value + 1;
+        return true;
+    }
+
+    bool parseType() {
+        if (++this->depth > MAX_DEPTH) return false;
+        const bool ok = this->parseTypeInner();
+        --this->depth;
+        return ok;
+    }
+
+    bool parseTypeInner() {
+        const size_t start = this->out.size();
+
+        for (const auto &[code, text] : BUILTIN_TYPES) {
+            if (this->consume(code)) {
+                this->out += text;
+                this->setPlain();
+                return true;
+            }
+        }
+
+        switch (const char c = this->peek()) {
+            case 'r':
+            case 'V':
+            case 'K': {
+                bool isRestrict = false, isVolatile = false, isConst = false;
+                for (;; ++this->position) {
+                    if (this->peek() == 'r')
+                        isRestrict = true;
+                    else if (this->peek() == 'V')
+                        isVolatile = true;
+                    else if (this->peek() == 'K')
+                        isConst = true;
+                    else
+                        break;
+                }
+                // The qualifiers of a member function: the unqualified type is not a candidate
+                if (this->peek() == 'F' ? !this->parseFunctionType() : !this->parseType())
+                    return false;
+                if (isConst) this->addQualifier(" const");
+                if (isVolatile) this->addQualifier(" volatile");
+                if (isRestrict) this->addQualifier(" restrict");
+                break;
+            }
+            case 'P':
+            case 'R':
+            case 'O': {
+                ++this->position;
+                if (!this->parseType()) return false;
+                this->addDeclarator(c == 'P' ? "*" : c == 'R' ? "&" : "&&");
+                break;
+            }
+            case 'F':
+                if (!this->parseFunctionType()) return false;
+                break;
+            case 'A': {
+                // `int [2][3]`, the dimensions follow the element type. They are copied as they
+                // are, whatever their size
+                const size_t start = ++this->position;
+                while (this->peek() >= '0' && this->peek() <= '9') ++this->position;
+                const std::string dimension =
+                    "[" + std::string(this->input.substr(start, this->position - start)) + "]";
+                if (!this->consume("_") || !this->parseType()) return false;
+                if (this->declarator == Declarator::ARRAY) {
+                    this->out.insert(this->insert + 1, dimension);
+                } else if (this->declarator == Declarator::GROUPED) {
+                    this->out.insert(this->insert, " " + dimension);
+                } else {
+                    this->insert = this->out.size();
+                    this->declarator = Declarator::ARRAY;
+                    this->out += " " + dimension;
+                }
+                break;
+            }
+            case 'M': {
+                // Pointer to member: `int Foo::*` or `void (Foo::*)(int)`
+                ++this->position;
+                const size_t classStart = this->out.size();
+                if (!this->parseType()) return false;
+                const std::string member = this->out.substr(classStart) + "::*";
+                this->out.resize(classStart);
+                if (!this->parseType()) return false;
+                this->addDeclarator(this->declarator == Declarator::NONE ? " " + member : member);
+                break;
+            }
+            case 'T':
+                if (!this->parseTemplateParam()) return false;
+                break;
+            case 'D': {
+                if (!this->consume("Dp") || !this->parseType()) return false;
+                this->out += "...";
+                this->setPlain();
+                break;
+            }
+            case 'S': {
+                if (this->peek(1) == 't') return this->parseClassType(start);
+
+                // A substitution is only a new candidate once instantiated
+                if (!this->parseSubstitution()) return false;
+                if (this->peek() != 'I') return true;
+                if (!this->parseTemplateArgs()) return false;
+                this->setPlain();
+                break;
+            }
+            case 'u': {
+                // Vendor extended type
+                ++this->position;
+                if (!this->parseSourceName()) return false;
+                this->setPlain();
+                break;
+            }
+            default:
+                return this->parseClassType(start);
+        }
+
+        this->addSubstitution(start);
+        return true;
+    }
+
+    // `<class-enum-type>`
+    bool parseClassType(size_t start) {
+        if (!this->parseName()) return false;
+        this->setPlain();
+        this->addSubstitution(start);
+        return true;
+    }
+
+    // `F [Y] <return type> <parameter types> [<ref-qualifier>] E`. A function returning a pointer
+    // to function has its parameters inside of the declarators of the return type
+    bool parseFunctionType() {
+        ++this->position;
+        this->consume("Y");
+        if (!this->parseType()) return false;
+        const bool nested = this->declarator == Declarator::GROUPED;
+        const size_t returnInsert = this->insert;
+
+        const size_t parameters = this->out.size();
+        if (!nested) this->out += ' ';
+        if (!this->parseParameters("E")) return false;
+        if (nested) {
+            const std::string text = this->out.substr(parameters);
+            this->out.resize(parameters);
+            this->out.insert(returnInsert, text);
+        }
+        this->insert = nested ? returnInsert : parameters;
+        this->declarator = Declarator::FUNCTION;
+
+        if (this->consume("R"))
+            this->out += " &";
+        else if (this->consume("O"))
+            this->out += " &&";
+        return this->consume("E");
+    }
+
+    // Parameter types up to `end` (not consumed), `v` alone means no parameters. The template
+    // parameters of the parameter types refer to `scope` if given
+    bool parseParameters(std::string_view end, const std::vector<Fragment> *scope = nullptr) {
+        this->out += '(';
+        if (this->peek() == 'v' && this->input.substr(this->position + 1).starts_with(end)) {
+            ++this->position;
+        } else {
+            for (bool first = true; !this->input.substr(this->position).starts_with(end) &&
+                                    !this->input.substr(this->position).starts_with("RE") &&
+                                    !this->input.substr(this->position).starts_with("OE");
+                 first = false) {
+                if (this->position >= this->input.size()) return false;
+                if (!first) this->out += ", ";
+                if (scope) this->templateArgs = *scope;
+                if (!this->parseType()) return false;
+            }
+        }
+        this->out += ')';
+        return true;
+    }
+
+    // `<name>`
+    bool parseName() {
+        const size_t start = this->out.size();
+        switch (this->peek()) {
+            case 'N':
+                return this->parseNestedName();
+            case 'Z':
+                return this->parseLocalName();
+            case 'S':
+                if (this->consume("St")) {
+                    this->out += "std::";
+                    if (!this->parseUnqualifiedName()) return false;
+                } else {
+                    // Only a template can be named by a substitution
+                    if (!this->parseSubstitution() || this->peek() != 'I') return false;
+                    return this->parseTemplateArgs();
+                }
+                break;
+            default:
+                if (!this->parseUnqualifiedName()) return false;
+                break;
+        }
+
+        if (this->peek() == 'I') {
+            this->setPlain();
+            this->addSubstitution(start);  // `<unscoped-template-name>`
+            return this->parseTemplateArgs();
+        }
+        return true;
+    }
+
+    // `N [<CV-qualifiers>] [<ref-qualifier>] <prefix> <unqualified-name> E`
+    bool parseNestedName() {
+        ++this->position;
+        const size_t qualifiers = this->position;
+        while (this->peek() == 'r' || this->peek() == 'V' || this->peek() == 'K') ++this->position;
+        if (!this->consume("R")) this->consume("O");
+        const std::string_view functionQualifiers =
+            this->input.substr(qualifiers, this->position - qualifiers);
+
+        const size_t start = this->out.size();
+        for (bool first = true; !this->consume("E"); first = false) {
+            bool candidate = true;
+            if (this->peek() == 'I') {
+                if (first || !this->parseTemplateArgs()) return false;
+            } else if (this->peek() == 'S' && this->peek(1) != 't') {
+                if (!first || !this->parseSubstitution()) return false;
+                candidate = false;
+            } else if (this->peek() == 'T') {
+                if (!first || !this->parseTemplateParam()) return false;
+            } else if (this->consume("St")) {
+                if (!first) return false;
+                this->out += "std";
+                candidate = false;
+            } else if (this->peek() == 'M') {
+                // Scope of the closures in the initializer of a data member, not a new prefix
+                if (first) return false;
+                ++this->position;
+                continue;
+            } else {
+                if (!first) this->out += "::";
+                if (!this->parseUnqualifiedName()) return false;
+            }
+
+            // Every prefix is a candidate, the full name is added by the enclosing type
+            if (this->position >= this->input.size()) return false;
+            this->setPlain();
+            if (candidate && this->peek() != 'E') this->addSubstitution(start);
+        }
+        this->functionQualifiers = functionQualifiers;
+        return true;
+    }
+
+    // `Z <function encoding> E <entity name> [<discriminator>]`, a class local to a function:
+    // `foo(int) const::Bar`. The return type of the templates is not shown
+    bool parseLocalName() {
+        ++this->position;
+        if (++this->depth > MAX_DEPTH) return false;
+
+        this->functionQualifiers = {};
+        if (!this->parseName()) return false;
+        const std::string_view qualifiers = this->functionQualifiers;
+        if (this->peek() != 'E') {
+            // The template parameters refer to the arguments of the function
+            const std::vector<Fragment> functionArgs = this->templateArgs;
+            if (this->endsWithTemplateArgs) {
+                const size_t returnStart = this->out.size();
+                if (!this->parseType()) return false;
+                this->out.resize(returnStart);
+            }
+            if (!this->parseParameters("E", &functionArgs)) return false;
+            for (const char qualifier : qualifiers) {
+                if (qualifier == 'K') this->out += " const";
+                if (qualifier == 'V') this->out += " volatile";
+                if (qualifier == 'r') this->out += " restrict";
+                if (qualifier == 'R') this->out += " &";
+                if (qualifier == 'O') this->out += " &&";
+            }
+        }
+        if (!this->consume("E")) return false;
+
+        if (this->consume("s")) {
+            this->out += "::string literal";
+        } else {
+            this->out += "::";
+            if (!this->parseName()) return false;
+        }
+
+        // The discriminator of the entities with the same name in the function
+        size_t discriminator;
+        if (this->consume("__")) {
+            if (!this->parseNumber(discriminator) || !this->consume("_")) return false;
+        } else if (this->consume("_")) {
+            if (!this->parseNumber(discriminator)) return false;
+        }
+
+        --this->depth;
+        return true;
+    }
+
+    // `<unqualified-name>`, followed by its ABI tags
+    bool parseUnqualifiedName() {
+        const char c = this->peek();
+        if (c >= '0' && c <= '9') {
+            if (!this->parseSourceName()) return false;
+        } else if (c == 'L') {
+            // Internal linkage
+            ++this->position;
+            if (!this->parseSourceName()) return false;
+        } else if (c == 'U') {
+            if (!this->parseUnnamedType()) return false;
+        } else if (c == 'C' && this->peek(1) >= '1' && this->peek(1) <= '5') {
+            this->position += 2;
+            this->out += this->lastSourceName;
+        } else if (c == 'D' && (this->peek(1) == '0' || this->peek(1) == '1' ||
+                                this->peek(1) == '2' || this->peek(1) == '4' ||
+                                this->peek(1) == '5')) {
+            this->position += 2;
+            this->out += '~';
+            this->out += this->lastSourceName;
+        } else if (!this->parseOperatorName()) {
+            return false;
+        }
+
+        while (this->consume("B")) {
+            const size_t tagStart = this->out.size();
+            if (!this->parseSourceName()) return false;
+            this->out.insert(tagStart, "[abi:");
+            this->out += ']';
+        }
+        this->endsWithTemplateArgs = false;
+        return true;
+    }
+
+    // `<number> <identifier>`
+    bool parseSourceName() {
+        size_t length;
+        if (!this->parseNumber(length) || length > this->input.size() - this->position)
+            return false;
+        const std::string_view identifier = this->input.substr(this->position, length);
+        this->position += length;
+
+        if (identifier.starts_with("_GLOBAL__N"))
+            this->out += "(anonymous namespace)";
+        else
+            this->out += identifier;
+        this->lastSourceName = identifier;
+        return true;
+    }
+
+    // `Ut [<number>] _` and the closures `Ul <lambda-sig> E [<number>] _`
+    bool parseUnnamedType() {
+        if (this->consume("Ut")) {
+            size_t id;
+            if (!this->parseSequenceId(id, 10)) return false;
+            this->out += "{unnamed type#" + std::to_string(id + 1) + "}";
+            return true;
+        }
+        if (!this->consume("Ul")) return false;
+
+        this->out += "{lambda";
+        if (!this->parseParameters("E") || !this->consume("E")) return false;
+        size_t id;
+        if (!this->parseSequenceId(id, 10)) return false;
+        this->out += "#" + std::to_string(id + 1) + "}";
+        return true;
+    }
+
+    bool parseOperatorName() {
+        if (this->consume("cv")) {
+            this->out += "operator ";
+            return this->parseType();
+        }
+        if (this->consume("li")) {
+            this->out += "operator\"\" ";
+            return this->parseSourceName();
+        }
+        for (const auto &[code, text] : OPERATORS) {
+            if (this->consume(code)) {
+                this->out += "operator";
+                if (text[0] >= 'a' && text[0] <= 'z') this->out += ' ';
+                this->out += text;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // `S_`, `S<seq-id>_` and the abbreviations of the standard library
+    bool parseSubstitution() {
+        for (const auto &[code, text] : STD_ABBREVIATIONS) {
+            if (this->consume(code)) {
+                this->out += text;
+                this->lastSourceName = unqualifiedName(text);
+                this->setPlain();
+                return true;
+            }
+        }
+
+        ++this->position;
+        size_t id;
+        if (!this->parseSequenceId(id, 36) || id >= this->substitutions.size()) return false;
+        this->append(this->substitutions[id]);
+        return true;
+    }
+
+    // `T_`, `T<number>_`
+    bool parseTemplateParam() {
+        ++this->position;
+        size_t id;
+        if (!this->parseSequenceId(id, 10) || id >= this->templateArgs.size()) return false;
+        this->append(this->templateArgs[id]);
+        return true;
+    }
+
+    // `I <template-arg>+ E`
+    bool parseTemplateArgs() {
+        ++this->position;
+        if (++this->depth > MAX_DEPTH) return false;
+
+        // The name of the template, not the last one of its arguments
+        const std::string_view sourceName = this->lastSourceName;
+        this->out += '<';
+        const size_t first = this->argStack.size();
+        bool empty = true, trailingPack = false;
+        while (!this->consume("E")) {
+            if (this->position >= this->input.size()) return false;
+            const size_t separator = this->out.size();
+            if (!empty) this->out += ", ";
+            const size_t start = this->out.size();
+            if (!this->parseTemplateArg()) return false;
+            this->argStack.push_back(this->copy(start));
+
+            // Empty packs take no room
+            trailingPack = this->out.size() == start;
+            if (trailingPack)
+                this->out.resize(separator);
+            else
+                empty = false;
+        }
+        // Like `c++filt`, `>>` after an empty pack
+        if (this->out.back() == '>' && !trailingPack) this->out += ' ';
+        this->out += '>';
+
+        // The innermost list completes first, the last one is the list of the outer template
+        this->templateArgs.assign(this->argStack.begin() + first, this->argStack.end());
+        this->argStack.resize(first);
+        this->lastSourceName = sourceName;
+        this->endsWithTemplateArgs = true;
+        --this->depth;
+        return true;
+    }
+
+    bool parseTemplateArg() {
+        switch (this->peek()) {
+            case 'L':
+                if (!this->parseLiteral()) return false;
+                this->setPlain();
+                return true;
+            case 'J': {
+                // Argument pack
+                ++this->position;
+                bool empty = true;
+                while (!this->consume("E")) {
+                    if (this->position >= this->input.size()) return false;
+                    const size_t separator = this->out.size();
+                    if (!empty) this->out += ", ";
+                    const size_t start = this->out.size();
+                    if (!this->parseTemplateArg()) return false;
+                    if (this->out.size() == start)
+                        this->out.resize(separator);
+                    else
+                        empty = false;
+                }
+                this->setPlain();
+                return true;
+            }
+            case 'X':
+                return false;  // Expressions are not supported
+            default:
+                return this->parseType();
+        }
+    }
+
+    // `L <type> <value> E` and `L _Z <encoding> E`
+    bool parseLiteral() {
+        ++this->position;
+        if (this->consume("_Z")) {
+            // Address of an entity, only its name is shown
+            this->out += '&';
+            if (!this->parseName()) return false;
+            const size_t parameters = this->out.size();
+            while (this->peek() != 'E') {
+                if (this->position >= this->input.size() || !this->parseType()) return false;
+            }
+            this->out.resize(parameters);
+            return this->consume("E");
+        }
+
+        if (this->consume("b0E")) {
+            this->out += "false";
+            return true;
+        }
+        if (this->consume("b1E")) {
+            this->out += "true";
+            return true;
+        }
+
+        std::string_view suffix;
+        bool integer = false;
+        for (const auto &[code, text] : LITERAL_SUFFIXES) {
+            if (this->consume(code)) {
+                suffix = text;
+                integer = true;
+                break;
+            }
+        }
+        if (!integer) {
+            this->out += '(';
+            if (!this->parseType()) return false;
+            this->out += ')';
+        }
+
+        if (this->consume("n")) this->out += '-';
+        while (this->peek() != 'E') {
+            if (this->position >= this->input.size()) return false;
+            this->out += this->input[this->position++];
+        }
+        ++this->position;
+        this->out += suffix;
+        return true;
+    }
+};
+
+std::string_view TypeNameDecoder::decode(std::string_view mangled) {
+    if (auto it = this->decoded.find(mangled); it != this->decoded.end()) return it->second;
+
+    // GCC marks the names of the classes with internal linkage with a leading `*`, to compare
+    // them by address instead of by content
+    Demangler demangler(*this, mangled.starts_with('*') ? mangled.substr(1) : mangled);
+    const std::string_view key = this->arena.store(mangled);
+    const std::string_view name = demangler.decode() ? this->arena.store(this->output) : key;
+    this->decoded.emplace(key, name);
+    return name;
+}
+
+}  // namespace skald
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace skald {
+
+// Append-only storage for strings, the views it returns stay valid as long as the arena
+class StringArena {
+   public:
+    std::string_view store(std::string_view text);
+
+   private:
+    static constexpr size_t CHUNK_SIZE = 0x10000;
+
+    std::vector<std::unique_ptr<char[]>> chunks;
+    char *current = nullptr;  // Free space of the current chunk
+    size_t available = 0;
+};
+
+// Decodes the Itanium manglings of the type names held by the type_info objects (`__type_name`,
+// the symbol without its `_ZTS` prefix) into display names, as printed by `c++filt -t`:
+// `N3foo3BarIiEE` becomes `foo::Bar<int>`. Each distinct name is decoded once, the result lives in
+// the arena of the decoder. Not thread safe
+class TypeNameDecoder {
+   public:
+    // The names that cannot be decoded are returned as is
+    std::string_view decode(std::string_view mangled);
+
+   private:
+    friend class Demangler;
+
+    // Where the declarators (`*`, `&`, `C::*`) of a type built on top of it go
+    enum class Declarator : uint8_t { NONE, FUNCTION, ARRAY, GROUPED };
+
+    // A type or a template argument stored in `candidates`
+    struct Fragment {
+        uint32_t offset;
+        uint32_t length;
+        uint32_t insert;  // Where the declarators go, relative to the offset
+        Declarator declarator;
+    };
+
+    StringArena arena;
+    std::unordered_map<std::string_view, std::string_view> decoded;  // Views in the arena
+
+    // Scratch buffers reused by every decoding, they do not allocate once grown
+    std::string output;
+    std::string candidates;              // Text of the substitution candidates and template args
+    std::vector<Fragment> substitutions;  // `S_`, `S0_`, ... of the name being decoded
+    std::vector<Fragment> templateArgs;   // `T_`, `T0_`, ... of the last template argument list
+    std::vector<Fragment> argStack;       // Arguments of the lists being parsed
+};
+
+}  // namespace skald
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstdint>
+
+namespace skald {
+
+typedef uint64_t address_t;
+
+}  // namespace skald
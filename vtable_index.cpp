@@ -0,0 +1,235 @@
+#include "vtable_index.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "abi.h"
+#include "backend.h"
+#include "log.h"
+#include "range_table.h"
+#include "thread_pool.h"
+
+namespace skald {
+
+namespace {
+
+// Bytes of data scanned by each task
+constexpr uint64_t CHUNK_SIZE = 0x100000;
+
+// Largest object (in bytes) for which an `offset_to_top` is considered plausible
+constexpr int64_t MAX_OFFSET_TO_TOP = 1 << 24;
+
+// Open addressing hash set of addresses, 0 marks an empty slot
+class AddressSet {
+   public:
+    explicit AddressSet(std::span<const address_t> addresses)
+        : mask(std::bit_ceil(addresses.size() * 2 + 1) - 1), table(this->mask + 1, 0) {
+        for (address_t address : addresses) {
+            if (address == 0) continue;
+            size_t i = this->slot(address);
+            while (this->table[i] != 0 && this->table[i] != address) i = (i + 1) & this->mask;
+            this->table[i] = address;
+        }
+    }
+
+    bool contains(address_t address) const {
+        for (size_t i = this->slot(address); this->table[i] != 0; i = (i + 1) & this->mask)
+            if (this->table[i] == address) return true;
+        return false;
+    }
+
+   private:
+    size_t mask;
+    std::vector<address_t> table;
+
+    size_t slot(address_t address) const {
+        return (address * 0x9e3779b97f4a7c15ull >> 17) & this->mask;
+    }
+};
+
+// Sections holding the vtables. If none of them is found fall back to any data section
+std::vector<Section> vtableSections(Backend &backend) {
+    std::vector<Section> sections;
+    for (Section &section : backend.getSections()) {
+        if (section.flags & SectionFlag::EXECUTABLE || !(section.flags & SectionFlag::READABLE))
+            continue;
+        if (section.name.starts_with(".data") || section.name.starts_with(".rodata"))
+            sections.push_back(std::move(section));
+    }
+    if (sections.empty()) {
+        for (Section &section : backend.getSections())
+            if (!(section.flags & SectionFlag::EXECUTABLE) && section.flags & SectionFlag::READABLE)
+                sections.push_back(std::move(section));
+    }
+    return sections;
+}
+
+}  // namespace
+
+template <typename A>
+VtableIndex::VtableIndex(A, Backend &backend, ThreadPool &pool,
+                         std::span<const address_t> typeInfos,
+                         std::span<const address_t> typeInfoEnds, const RangeTable &unchanged,
+                         std::span<const std::pair<address_t, address_t>> previous) {
+    typedef typename A::pointer_t pointer_t;
+    constexpr uint64_t POINTER_SIZE = A::POINTER_SIZE;
+
+    if (typeInfos.empty()) return;
+
+    const std::vector<Section> sections = vtableSections(backend);
+    const AddressSet known(typeInfos);
+    std::vector<std::pair<address_t, address_t>> candidates;
+
+    // Split the sections in chunks scanned in parallel. The candidates of the sections that did
+    // not change since the previous run are reused, as long as their type_info still exists
+    std::vector<std::pair<address_t, address_t>> chunks;
+    for (const Section &section : sections) {
+        if (const Section *same = unchanged.find(section.start); same && *same == section) {
+            for (const auto &[rtti, slot] : previous)
+                if (section.start <= slot && slot < section.end && known.contains(rtti))
+                    candidates.emplace_back(rtti, slot);
+            continue;
+        }
+
+        // Each chunk but the first also covers the word preceding it, the `offset_to_top` of its
+        // first slot. The first one must not: the data before the section might not be mapped
+        const address_t start = (section.start + POINTER_SIZE - 1) & ~(POINTER_SIZE - 1);
+        for (address_t addr = start; addr < section.end; addr += CHUNK_SIZE)
+            chunks.emplace_back(addr == start ? addr : addr - POINTER_SIZE,
+                                std::min(section.end, addr + CHUNK_SIZE));
+    }
+
+    // The range test runs on the words as they are stored, the bounds are converted instead
+    const auto low = fromOrder<A::ORDER>(static_cast<pointer_t>(typeInfos.front()));
+    const auto high = fromOrder<A::ORDER>(static_cast<pointer_t>(typeInfos.back()));
+    const bool ordered = A::ORDER == std::endian::native;
+    std::vector<std::vector<std::pair<address_t, address_t>>> found(chunks.size());
+
+    pool.parallelFor(chunks.size(), [&](size_t i) {
+        const auto [base, end] = chunks[i];
+        std::vector<pointer_t> words((end - base) / POINTER_SIZE);
+        const size_t count =
+            backend.read(words.data(), base, words.size() * POINTER_SIZE) / POINTER_SIZE;
+
+        for (size_t block = 1; block < count; block += 8) {
+            const size_t blockEnd = std::min(count, block + 8);
+
+            // Branch-free range test on the whole block, most of the words are not pointing to
+            // the type_info area. The compiler turns it into vector compares
+            // With the other byte order every word is a candidate, the set test filters them
+            uint32_t hits = ordered ? 0 : (1u << (blockEnd - block)) - 1;
+            if (ordered)
+                for (size_t j = block; j < blockEnd; ++j)
+                    hits |= static_cast<uint32_t>(words[j] - low <= high - low) << (j - block);
+
+            for (; hits != 0; hits &= hits - 1) {
+                const size_t j = block + std::countr_zero(hits);
+                const address_t value = A::load(words[j]);
+                if (!known.contains(value)) continue;
+
+                // Usually 0 or negative, but positive in construction vtables
+                const int64_t offsetToTop = A::loadOffset(words[j - 1]);
+                if (offsetToTop >= MAX_OFFSET_TO_TOP || offsetToTop <= -MAX_OFFSET_TO_TOP)
+                    continue;
+
+                // A type_info object pointing to another one (as a base class)
+                const address_t slot = base + POINTER_SIZE * j;
+                auto it = std::ranges::upper_bound(typeInfos, slot);
+                if (it != typeInfos.begin() && slot < typeInfoEnds[it - typeInfos.begin() - 1])
+                    continue;
+
+                found[i].emplace_back(value, slot);
+            }
+        }
+    });
+
+    for (const auto &chunk : found) candidates.insert(candidates.end(), chunk.begin(), chunk.end());
+    std::ranges::sort(candidates);
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    this->rttiAddresses.reserve(candidates.size());
+    this->slots.reserve(candidates.size());
+    for (const auto &[rtti, slot] : candidates) {
+        this->rttiAddresses.push_back(rtti);
+        this->slots.push_back(slot);
+    }
+    logDebug("Found {} vtable candidates in {} sections", this->slots.size(), sections.size());
+}
+
+template <typename A>
+VtableIndex::VtableIndex(A, Backend &backend,
+                         std::span<const std::pair<address_t, address_t>> pointers) {
+    std::vector<std::pair<address_t, address_t>> candidates;
+    for (const auto &[slot, rtti] : pointers) {
+        typename A::pointer_t word = 0;
+        if (backend.read(&word, slot - A::POINTER_SIZE, sizeof(word)) != sizeof(word)) continue;
+        const int64_t offsetToTop = A::loadOffset(word);
+        if (offsetToTop >= MAX_OFFSET_TO_TOP || offsetToTop <= -MAX_OFFSET_TO_TOP) continue;
+        candidates.emplace_back(rtti, slot);
+    }
+    std::ranges::sort(candidates);
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    for (const auto &[rtti, slot] : candidates) {
+        this->rttiAddresses.push_back(rtti);
+        this->slots.push_back(slot);
+    }
+}
+
+std::span<const address_t> VtableIndex::getCandidates(address_t rttiAddress) const {
+    auto [first, last] = std::ranges::equal_range(this->rttiAddresses, rttiAddress);
+    return std::span(this->slots).subspan(first - this->rttiAddresses.begin(), last - first);
+}
+
+template <typename A>
+std::vector<std::pair<address_t, address_t>> findPointers(Backend &backend, ThreadPool &pool,
+                                                          std::span<const address_t> targets) {
+    typedef typename A::pointer_t pointer_t;
+    std::vector<std::pair<address_t, address_t>> pointers;
+    if (targets.empty()) return pointers;
+
+    std::vector<std::pair<address_t, address_t>> chunks;
+    for (const Section &section : vtableSections(backend)) {
+        const address_t start = (section.start + A::POINTER_SIZE - 1) & ~(A::POINTER_SIZE - 1);
+        for (address_t addr = start; addr < section.end; addr += CHUNK_SIZE)
+            chunks.emplace_back(addr, std::min(section.end, addr + CHUNK_SIZE));
+    }
+
+    const AddressSet known(targets);
+    const auto [low, high] = std::ranges::minmax(targets);
+    std::vector<std::vector<std::pair<address_t, address_t>>> found(chunks.size());
+    pool.parallelFor(chunks.size(), [&](size_t i) {
+        const auto [base, end] = chunks[i];
+        std::vector<pointer_t> words((end - base) / A::POINTER_SIZE);
+        const size_t count =
+            backend.read(words.data(), base, words.size() * A::POINTER_SIZE) / A::POINTER_SIZE;
+        for (size_t j = 0; j < count; ++j) {
+            const address_t value = A::load(words[j]);
+            if (value - low <= high - low && known.contains(value))
+                found[i].emplace_back(base + A::POINTER_SIZE * j, value);
+        }
+    });
+
+    for (const auto &chunk : found) pointers.insert(pointers.end(), chunk.begin(), chunk.end());
+    std::ranges::sort(pointers);
+    return pointers;
+}
+
+#define INSTANTIATE(A)                                                                          \
+    template VtableIndex::VtableIndex(A, Backend &, ThreadPool &, std::span<const address_t>,   \
+                                      std::span<const address_t>, const RangeTable &,           \
+                                      std::span<const std::pair<address_t, address_t>>);        \
+    template VtableIndex::VtableIndex(A, Backend &,                                             \
+                                      std::span<const std::pair<address_t, address_t>>);       \
+    template std::vector<std::pair<address_t, address_t>> findPointers<A>(                      \
+        Backend &, ThreadPool &, std::span<const address_t>);
+SKALD_FOR_EACH_ABI(INSTANTIATE)
+#undef INSTANTIATE
+
+}  // namespace skald
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "abi.h"
+#include "backend.h"
+#include "range_table.h"
+#include "thread_pool.h"
+
+namespace skald {
+
+// Every place in the data sections that looks like the RTTI slot of a vtable: a pointer-aligned
+// word holding the address of a known type_info object, preceded by a plausible `offset_to_top`.
+// The index is built with a single sweep over the data, instead of a reference query per class
+class VtableIndex {
+   public:
+    VtableIndex() = default;
+
+    // `typeInfos` and `typeInfoEnds` are the sorted start addresses of the type_info objects and
+    // their respective end. Words lying inside a type_info object are not considered.
+    // The sections in `unchanged` are not scanned, their candidates are taken from `previous`.
+    // The words are read as pointers of the ABI `A`
+    template <typename A>
+    VtableIndex(A abi, Backend &backend, ThreadPool &pool, std::span<const address_t> typeInfos,
+                std::span<const address_t> typeInfoEnds, const RangeTable &unchanged = {},
+                std::span<const std::pair<address_t, address_t>> previous = {});
+
+    // Address of the RTTI slots pointing to `rttiAddress`, sorted
+    std::span<const address_t> getCandidates(address_t rttiAddress) const;
+
+    // Candidates among `pointers`, words of the data sections holding the address of a type_info
+    // object as found by `findPointers()`: those preceded by a plausible `offset_to_top`. The
+    // words lying inside a type_info object must have been left out
+    template <typename A>
+    VtableIndex(A abi, Backend &backend,
+                std::span<const std::pair<address_t, address_t>> pointers);
+
+    // RTTI slots of all the candidates
+    std::span<const address_t> getSlots() const { return this->slots; }
+
+    // type_info of each slot returned by `getSlots()`
+    std::span<const address_t> getRttiAddresses() const { return this->rttiAddresses; }
+
+   private:
+    std::vector<address_t> rttiAddresses;  // Sorted, each one paired with the slot in `slots`
+    std::vector<address_t> slots;
+};
+
+// Every pointer-aligned word of the data sections holding one of `targets`, as its address and
+// value, sorted by address. A single sweep like the one building VtableIndex
+template <typename A>
+std::vector<std::pair<address_t, address_t>> findPointers(Backend &backend, ThreadPool &pool,
+                                                          std::span<const address_t> targets);
+
+}  // namespace skald
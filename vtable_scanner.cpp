@@ -0,0 +1,169 @@
+#include "vtable_scanner.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "abi.h"
+#include "backend.h"
+#include "range_table.h"
+#include "type_accessor.h"
+
+namespace skald {
+
+namespace {
+
+typedef std::pair<uint64_t, uint64_t> range_t;
+
+// Slots fetched at once
+constexpr size_t BLOCK_SIZE = 32;
+
+size_t countExecutableScalar(const uint64_t *slots, size_t count, const range_t *ranges,
+                             size_t rangeCount) {
+    for (size_t i = 0; i < count; ++i) {
+        bool executable = false;
+        for (size_t r = 0; r < rangeCount; ++r)
+            executable |= slots[i] - ranges[r].first < ranges[r].second - ranges[r].first;
+        if (!executable) return i;
+    }
+    return count;
+}
+
+#if defined(__x86_64__)
+constexpr uint64_t SIGN_BIT = 1ull << 63;
+
+// There is no unsigned 64 bits compare, flipping the sign bit turns it into a signed one:
+// `value - start < size` (unsigned) becomes `(size ^ sign) > ((value - start) ^ sign)`
+__attribute__((target("avx2"))) size_t countExecutableAvx2(const uint64_t *slots, size_t count,
+                                                           const range_t *ranges,
+                                                           size_t rangeCount) {
+    const __m256i sign = _mm256_set1_epi64x(SIGN_BIT);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(slots + i));
+        __m256i executable = _mm256_setzero_si256();
+        for (size_t r = 0; r < rangeCount; ++r) {
+            const auto [first, last] = ranges[r];
+            const __m256i start = _mm256_set1_epi64x(static_cast<int64_t>(first));
+            const __m256i size =
+                _mm256_set1_epi64x(static_cast<int64_t>((last - first) ^ SIGN_BIT));
+            const __m256i offset = _mm256_xor_si256(_mm256_sub_epi64(values, start), sign);
+            executable = _mm256_or_si256(executable, _mm256_cmpgt_epi64(size, offset));
+        }
+        const auto mask =
+            static_cast<uint32_t>(_mm256_movemask_pd(_mm256_castsi256_pd(executable)));
+        if (mask != 0xf) return i + std::countr_one(mask);
+    }
+    return i + countExecutableScalar(slots + i, count - i, ranges, rangeCount);
+}
+
+__attribute__((target("sse4.2"))) size_t countExecutableSse42(const uint64_t *slots,
+                                                              size_t count,
+                                                              const range_t *ranges,
+                                                              size_t rangeCount) {
+    const __m128i sign = _mm_set1_epi64x(SIGN_BIT);
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        const __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i *>(slots + i));
+        __m128i executable = _mm_setzero_si128();
+        for (size_t r = 0; r < rangeCount; ++r) {
+            const auto [first, last] = ranges[r];
+            const __m128i start = _mm_set1_epi64x(static_cast<int64_t>(first));
+            const __m128i size = _mm_set1_epi64x(static_cast<int64_t>((last - first) ^ SIGN_BIT));
+            const __m128i offset = _mm_xor_si128(_mm_sub_epi64(values, start), sign);
+            executable = _mm_or_si128(executable, _mm_cmpgt_epi64(size, offset));
+        }
+        const auto mask = static_cast<uint32_t>(_mm_movemask_pd(_mm_castsi128_pd(executable)));
+        if (mask != 0x3) return i + std::countr_one(mask);
+    }
+    return i + countExecutableScalar(slots + i, count - i, ranges, rangeCount);
+}
+#endif
+
+}  // namespace
+
+std::vector<VtableScanner::count_executable_t> VtableScanner::getCountExecutableVariants() {
+    std::vector<count_executable_t> variants = {countExecutableScalar};
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.2")) variants.push_back(countExecutableSse42);
+    if (__builtin_cpu_supports("avx2")) variants.push_back(countExecutableAvx2);
+#endif
+    return variants;
+}
+
+VtableScanner::VtableScanner(Backend &backend, std::vector<address_t> stops)
+    : sections(backend.getSections()),
+      segments(backend.getSegments()),
+      stops(std::move(stops)),
+      countExecutable(getCountExecutableVariants().back()) {
+    std::ranges::sort(this->stops);
+
+    // Merge the adjacent executable segments, there are usually only one or two ranges left
+    for (const Section &segment : this->segments.get()) {
+        if (!(segment.flags & SectionFlag::EXECUTABLE)) continue;
+        if (!this->executable.empty() && this->executable.back().second == segment.start)
+            this->executable.back().second = segment.end;
+        else
+            this->executable.emplace_back(segment.start, segment.end);
+    }
+}
+
+template <typename A>
+std::vector<address_t> VtableScanner::scan(TypeAccessor &accessor, address_t rttiSlot,
+                                           bool nulls) const {
+    constexpr uint64_t POINTER_SIZE = A::POINTER_SIZE;
+    std::vector<address_t> functions;
+    const address_t start = rttiSlot + POINTER_SIZE;
+
+    // Upper bound of the vtable: end of the readable segment, of the section and next stop
+    const Section *segment = this->segments.find(start);
+    if (!segment || !(segment->flags & SectionFlag::READABLE)) return functions;
+    address_t limit = segment->end;
+    if (const Section *section = this->sections.find(rttiSlot))
+        limit = std::min(limit, section->end);
+    if (auto it = std::ranges::upper_bound(this->stops, rttiSlot); it != this->stops.end())
+        limit = std::min(limit, *it);
+    if (limit <= start) return functions;
+
+    std::array<uint64_t, BLOCK_SIZE> slots;
+    size_t trailing = 0;  // Null slots, not part of the vtable yet
+    for (address_t addr = start; addr + POINTER_SIZE <= limit; addr += POINTER_SIZE * BLOCK_SIZE) {
+        const size_t wanted = std::min<uint64_t>(BLOCK_SIZE, (limit - addr) / POINTER_SIZE);
+        const size_t read = accessor.readPointers<A>(addr, std::span(slots).first(wanted));
+        if constexpr (A::VARIANT == CxxAbi::ARM)
+            for (size_t j = 0; j < read; ++j) slots[j] = A::functionAddress(slots[j]);
+        size_t i = 0;
+        while (i < read) {
+            const size_t count = this->countExecutable(
+                slots.data() + i, read - i, this->executable.data(), this->executable.size());
+            if (count == 0 && slots[i] != 0) return functions;
+            if (count > 0) {
+                if (trailing > 0 && !nulls) return functions;
+                functions.insert(functions.end(), trailing, 0);
+                functions.insert(functions.end(), slots.begin() + i, slots.begin() + i + count);
+                trailing = 0;
+                i += count;
+            }
+            for (; i < read && slots[i] == 0; ++i) ++trailing;
+        }
+        if (read < wanted) break;
+    }
+
+    return functions;
+}
+
+#define INSTANTIATE(A) \
+    template std::vector<address_t> VtableScanner::scan<A>(TypeAccessor &, address_t, bool) const;
+SKALD_FOR_EACH_ABI(INSTANTIATE)
+#undef INSTANTIATE
+
+}  // namespace skald
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "backend.h"
+#include "range_table.h"
+#include "type_accessor.h"
+
+namespace skald {
+
+// Size the vtables. There is no reliable way of knowing how large a vtable is, so the slots are
+// taken as long as they point to executable code, without leaving the section and the readable
+// segment of the vtable and without running into the next known vtable or type_info object. A null
+// slot ends the vtable, the next one may have no RTTI and start with two null slots.
+// The executable ranges are checked on blocks of slots with SIMD instructions when available
+class VtableScanner {
+   public:
+    VtableScanner() = default;
+
+    // `stops` are addresses where a vtable can not continue (start of other vtables or type_info
+    // objects)
+    VtableScanner(Backend &backend, std::vector<address_t> stops);
+
+    // Virtual function pointers of the vtable whose RTTI slot is at `rttiSlot`, in the ABI `A`.
+    // `nulls` keeps the null slots followed by more functions, for the construction vtables whose
+    // destructors are null
+    template <typename A>
+    std::vector<address_t> scan(TypeAccessor &accessor, address_t rttiSlot,
+                                bool nulls = false) const;
+
+    // Number of leading `slots` pointing inside one of the executable ranges
+    typedef size_t (*count_executable_t)(const uint64_t *slots, size_t count,
+                                         const std::pair<uint64_t, uint64_t> *ranges,
+                                         size_t rangeCount);
+
+    // Implementations of `count_executable_t` supported by the CPU, the scalar one first and the
+    // one used by the scanner last
+    static std::vector<count_executable_t> getCountExecutableVariants();
+
+   private:
+    RangeTable sections;
+    RangeTable segments;
+    std::vector<std::pair<uint64_t, uint64_t>> executable;  // Merged [start, end) ranges
+    std::vector<address_t> stops;                           // Sorted
+    count_executable_t countExecutable = nullptr;
+};
+
+}  // namespace skald